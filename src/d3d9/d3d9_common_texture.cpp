@@ -15,6 +15,7 @@ namespace dxvk {
           IUnknown*                 pInterface,
     const D3D9_COMMON_TEXTURE_DESC* pDesc,
           D3DRESOURCETYPE           ResourceType,
+    const D3D9_COMMON_TEXTURE_IMPORT_INFO* pImport,
           HANDLE*                   pSharedHandle)
     : m_device(pDevice), m_desc(*pDesc), m_type(ResourceType), m_d3d9Interop(pInterface, this) {
     if (m_desc.Format == D3D9Format::Unknown)
@@ -35,6 +36,10 @@ namespace dxvk {
       throw DxvkError("D3D9: Incompatible pool type for texture sharing.");
     }
 
+    if (pImport && (m_desc.Pool != D3DPOOL_DEFAULT || pSharedHandle)) {
+      throw DxvkError("D3D9: Incompatible parameters for image import.");
+    }
+
     if (IsPoolManaged(m_desc.Pool)) {
       SetAllNeedUpload();
     }
@@ -52,19 +57,24 @@ namespace dxvk {
       bool plainSurface = m_type == D3DRTYPE_SURFACE &&
                           !(m_desc.Usage & (D3DUSAGE_RENDERTARGET | D3DUSAGE_DEPTHSTENCIL));
 
-      try {
-        m_image = CreatePrimaryImage(ResourceType, plainSurface, pSharedHandle);
-      }
-      catch (const DxvkError& e) {
-        // D3DUSAGE_AUTOGENMIPMAP and offscreen plain is mutually exclusive
-        // so we can combine their retry this way.
-        if (m_desc.Usage & D3DUSAGE_AUTOGENMIPMAP || plainSurface) {
-          m_desc.Usage &= ~D3DUSAGE_AUTOGENMIPMAP;
-          m_desc.MipLevels = 1;
-          m_image = CreatePrimaryImage(ResourceType, false, pSharedHandle);
+      if (pImport) {
+        m_image = CreateImportedImage(ResourceType, pImport);
+        m_imported = true;
+      } else {
+        try {
+          m_image = CreatePrimaryImage(ResourceType, plainSurface, pSharedHandle);
+        }
+        catch (const DxvkError& e) {
+          // D3DUSAGE_AUTOGENMIPMAP and offscreen plain is mutually exclusive
+          // so we can combine their retry this way.
+          if (m_desc.Usage & D3DUSAGE_AUTOGENMIPMAP || plainSurface) {
+            m_desc.Usage &= ~D3DUSAGE_AUTOGENMIPMAP;
+            m_desc.MipLevels = 1;
+            m_image = CreatePrimaryImage(ResourceType, false, pSharedHandle);
+          }
+          else
+            throw e;
         }
-        else
-          throw e;
       }
 
       if (pSharedHandle && *pSharedHandle == nullptr) {
@@ -75,7 +85,7 @@ namespace dxvk {
       if ((m_image->info().usage & VK_IMAGE_USAGE_SAMPLED_BIT) != 0)
         CreateSampleView(0);
 
-      if (!IsManaged()) {
+      if (!IsManaged() && !m_imported) {
         m_size = m_image->memory().length();
         if (!m_device->ChangeReportedMemory(-m_size))
           throw DxvkError("D3D9: Reporting out of memory from tracking.");
@@ -101,7 +111,7 @@ namespace dxvk {
 
     m_device->RemoveMappedTexture(this);
 
-    if (m_desc.Pool == D3DPOOL_DEFAULT)
+    if (m_desc.Pool == D3DPOOL_DEFAULT && !m_imported)
       m_device->DecrementLosableCounter();
   }
 
@@ -405,6 +415,73 @@ namespace dxvk {
   }
 
 
+  Rc<DxvkImage> D3D9CommonTexture::CreateImportedImage(D3DRESOURCETYPE ResourceType, const D3D9_COMMON_TEXTURE_IMPORT_INFO* pImport) const {
+    // Converted formats are backed by a different Vulkan format
+    // than the application-facing one, which we cannot import
+    if (m_mapping.ConversionFormatInfo.FormatType != D3D9ConversionFormat_None)
+      throw DxvkError(str::format("D3D9: Cannot import image of format ", m_desc.Format));
+
+    // Describe the image exactly as it was created by its owner,
+    // so that views and barriers only use what the image supports
+    DxvkImageCreateInfo imageInfo;
+    imageInfo.type            = GetImageTypeFromResourceType(ResourceType, m_desc.ArraySize);
+    imageInfo.format          = m_mapping.FormatColor;
+    imageInfo.flags           = pImport->Flags;
+    imageInfo.sampleCount     = VK_SAMPLE_COUNT_1_BIT;
+    imageInfo.extent.width    = m_desc.Width;
+    imageInfo.extent.height   = m_desc.Height;
+    imageInfo.extent.depth    = m_desc.Depth;
+    imageInfo.numLayers       = m_desc.ArraySize;
+    imageInfo.mipLevels       = m_desc.MipLevels;
+    imageInfo.usage           = pImport->Usage;
+    imageInfo.stages          = 0;
+    imageInfo.access          = 0;
+    imageInfo.tiling          = VK_IMAGE_TILING_OPTIMAL;
+
+    // Imported images are owned by someone else, so they
+    // need to be in their default layout after each submission
+    imageInfo.shared          = true;
+
+    DecodeMultiSampleType(m_device->GetDXVKDevice(), m_desc.MultiSample, m_desc.MultisampleQuality, &imageInfo.sampleCount);
+
+    if (imageInfo.usage & VK_IMAGE_USAGE_TRANSFER_SRC_BIT) {
+      imageInfo.stages |= VK_PIPELINE_STAGE_TRANSFER_BIT;
+      imageInfo.access |= VK_ACCESS_TRANSFER_READ_BIT;
+    }
+
+    if (imageInfo.usage & VK_IMAGE_USAGE_TRANSFER_DST_BIT) {
+      imageInfo.stages |= VK_PIPELINE_STAGE_TRANSFER_BIT;
+      imageInfo.access |= VK_ACCESS_TRANSFER_WRITE_BIT;
+    }
+
+    if (imageInfo.usage & VK_IMAGE_USAGE_SAMPLED_BIT) {
+      imageInfo.stages |= m_device->GetEnabledShaderStages();
+      imageInfo.access |= VK_ACCESS_SHADER_READ_BIT;
+    }
+
+    if (imageInfo.usage & VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT) {
+      imageInfo.stages |= VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+      imageInfo.access |= VK_ACCESS_COLOR_ATTACHMENT_READ_BIT
+                       |  VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    }
+
+    if (imageInfo.usage & VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT) {
+      imageInfo.stages |= VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT
+                       |  VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+      imageInfo.access |= VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT
+                       |  VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+    }
+
+    // Render targets are handed back to their owner in
+    // attachment layout, regardless of other usage flags
+    imageInfo.layout = (imageInfo.usage & VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT)
+      ? VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL
+      : OptimizeLayout(imageInfo.usage);
+
+    return m_device->GetDXVKDevice()->importImage(imageInfo, pImport->Image, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+  }
+
+
   Rc<DxvkImage> D3D9CommonTexture::CreateResolveImage() const {
     DxvkImageCreateInfo imageInfo = m_image->info();
     imageInfo.sampleCount = VK_SAMPLE_COUNT_1_BIT;
@@ -634,6 +711,10 @@ namespace dxvk {
           UINT                   Lod,
           VkImageUsageFlags      UsageFlags,
           bool                   Srgb) {    
+    // Imported images may not support views with a different format
+    if (m_imported && !(m_image->info().flags & VK_IMAGE_CREATE_MUTABLE_FORMAT_BIT))
+      Srgb = false;
+
     DxvkImageViewCreateInfo viewInfo;
     viewInfo.format    = m_mapping.ConversionFormatInfo.FormatColor != VK_FORMAT_UNDEFINED
                        ? PickSRGB(m_mapping.ConversionFormatInfo.FormatColor, m_mapping.ConversionFormatInfo.FormatSrgb, Srgb)
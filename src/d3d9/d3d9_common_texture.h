@@ -50,6 +50,19 @@ namespace dxvk {
     bool                IsLockable;
   };
 
+  /**
+   * \brief Externally owned image
+   *
+   * Describes a Vulkan image that a texture wraps instead
+   * of creating its own. Usage and create flags must be
+   * the ones the image was created with.
+   */
+  struct D3D9_COMMON_TEXTURE_IMPORT_INFO {
+    VkImage             Image;
+    VkImageUsageFlags   Usage;
+    VkImageCreateFlags  Flags;
+  };
+
   struct D3D9ColorView {
     inline Rc<DxvkImageView>& Pick(bool Srgb) {
       return Srgb ? this->Srgb : this->Color;
@@ -77,6 +90,7 @@ namespace dxvk {
             IUnknown*                 pInterface,
       const D3D9_COMMON_TEXTURE_DESC* pDesc,
             D3DRESOURCETYPE           ResourceType,
+      const D3D9_COMMON_TEXTURE_IMPORT_INFO* pImport,
             HANDLE*                   pSharedHandle);
 
     ~D3D9CommonTexture();
@@ -213,6 +227,14 @@ namespace dxvk {
       return m_supportsFetch4;
     }
 
+    /**
+     * \brief Imported
+     * \returns Whether the texture wraps an externally owned image
+     */
+    bool IsImported() const {
+      return m_imported;
+    }
+
     /**
      * \brief Null
      * \returns Whether the texture is D3DFMT_NULL or not
@@ -511,6 +533,7 @@ namespace dxvk {
     bool                          m_shadow; //< Depth Compare-ness
     bool                          m_upgradedToD32f; // Dref Clamp
     bool                          m_supportsFetch4;
+    bool                          m_imported = false;
 
     int64_t                       m_size = 0;
 
@@ -538,6 +561,8 @@ namespace dxvk {
 
     Rc<DxvkImage> CreatePrimaryImage(D3DRESOURCETYPE ResourceType, bool TryOffscreenRT, HANDLE* pSharedHandle) const;
 
+    Rc<DxvkImage> CreateImportedImage(D3DRESOURCETYPE ResourceType, const D3D9_COMMON_TEXTURE_IMPORT_INFO* pImport) const;
+
     Rc<DxvkImage> CreateResolveImage() const;
 
     BOOL DetermineShadowState() const;
@@ -60,7 +60,16 @@ namespace dxvk {
     , m_d3d9Interop     ( this )
     , m_d3d9On12        ( this )
     , m_d3d8Bridge      ( this )
-    , m_multiViewFF     ( BehaviorFlags & 0x10000 /* Magic number to pass to the device to let it know that it should use multiview rendering for fixed-function vertex shaders */ ) {
+    , m_viewCountFF     ( BehaviorFlags & 0x10000 /* Magic number to pass to the device to let it know that it should use multiview rendering for fixed-function vertex shaders */ ? 2 : 1 )
+    , m_instancedViewCount( 1 )
+    , m_drawViewCount   ( 1 )
+    , m_viewMask        ( BehaviorFlags & 0x10000 ? 0b11u : 0u )
+    , m_vrTimings       ( this ) {
+    // Dispatching chunks early depends on timing, which
+    // would make the command stream non-deterministic
+    if (!m_d3d9Options.reproducibleCommandStream)
+      m_csEarlyDispatchSize = MinEarlyCsDispatchSize;
+
     // If we can SWVP, then we use an extended constant set
     // as SWVP has many more slots available than HWVP.
     bool canSWVP = CanSWVP();
@@ -72,6 +81,12 @@ namespace dxvk {
     if (m_dxvkDevice->instance()->extensions().extDebugUtils)
       m_annotation = new D3D9UserDefinedAnnotation(this);
 
+    // Leave room for samplers created by DXVK itself and by
+    // other devices, but keep lookups fast for games that
+    // cycle through many LOD bias or anisotropy settings
+    m_samplers.SetMaxCount(std::min(MaxCachedSamplers,
+      m_dxvkDevice->properties().core.properties.limits.maxSamplerAllocationCount / 2));
+
     m_initializer      = new D3D9Initializer(m_dxvkDevice);
     m_converter        = new D3D9FormatHelper(m_dxvkDevice);
 
@@ -168,6 +183,7 @@ namespace dxvk {
 
     m_flags.set(D3D9DeviceFlag::DirtyFFVertexData);
     m_flags.set(D3D9DeviceFlag::DirtyFFVertexBlend);
+    m_flags.set(D3D9DeviceFlag::DirtyFFViewData);
     m_flags.set(D3D9DeviceFlag::DirtyFFVertexShader);
     m_flags.set(D3D9DeviceFlag::DirtyFFPixelShader);
     m_flags.set(D3D9DeviceFlag::DirtyFFViewport);
@@ -1346,6 +1362,126 @@ namespace dxvk {
   }
 
 
+  HRESULT D3D9DeviceEx::CopySurfaceLayers(
+          D3D9Surface*         src,
+          D3D9Surface* const*  dsts,
+          UINT                 layerCount) {
+    if (unlikely(src == nullptr || (dsts == nullptr && layerCount)))
+      return D3DERR_INVALIDCALL;
+
+    D3D9CommonTexture* srcTextureInfo = src->GetCommonTexture();
+
+    if (unlikely(srcTextureInfo->Desc()->Pool != D3DPOOL_DEFAULT
+              || layerCount > srcTextureInfo->Desc()->ArraySize))
+      return D3DERR_INVALIDCALL;
+
+    Rc<DxvkImage> srcImage = srcTextureInfo->GetImage();
+
+    if (unlikely(srcImage == nullptr))
+      return D3DERR_INVALIDCALL;
+
+    const DxvkFormatInfo* srcFormatInfo = lookupFormatInfo(srcImage->info().format);
+    const VkImageSubresource srcSubresource = srcTextureInfo->GetSubresourceFromIndex(srcFormatInfo->aspectMask, src->GetSubresource());
+    const VkExtent3D srcExtent = srcImage->mipLevelExtent(srcSubresource.mipLevel);
+
+    struct LayerCopy {
+      Rc<DxvkImage>            image;
+      VkImageSubresourceLayers layers;
+    };
+
+    std::vector<LayerCopy> copies;
+    copies.reserve(layerCount);
+
+    // Only batch plain full-size copies and resolves of color
+    // images, anything else needs the full StretchRect logic.
+    bool batch = !(srcFormatInfo->aspectMask & (VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT));
+
+    for (UINT i = 0; i < layerCount; i++) {
+      D3D9Surface* dst = dsts[i];
+
+      if (unlikely(dst == nullptr || dst == src))
+        return D3DERR_INVALIDCALL;
+
+      D3D9CommonTexture* dstTextureInfo = dst->GetCommonTexture();
+      Rc<DxvkImage> dstImage = dstTextureInfo->GetImage();
+
+      if (unlikely(dstTextureInfo->Desc()->Pool != D3DPOOL_DEFAULT || dstImage == nullptr))
+        return D3DERR_INVALIDCALL;
+
+      if (!batch)
+        continue;
+
+      const DxvkFormatInfo* dstFormatInfo = lookupFormatInfo(dstImage->info().format);
+      const VkImageSubresource dstSubresource = dstTextureInfo->GetSubresourceFromIndex(dstFormatInfo->aspectMask, dst->GetSubresource());
+
+      batch &= AreFormatsSimilar(srcTextureInfo->Desc()->Format, dstTextureInfo->Desc()->Format);
+      batch &= dstImage->info().sampleCount == VK_SAMPLE_COUNT_1_BIT;
+      batch &= dstImage->mipLevelExtent(dstSubresource.mipLevel) == srcExtent;
+      batch &= (dstTextureInfo->Desc()->Usage & D3DUSAGE_RENDERTARGET) != 0;
+
+      copies.push_back({ std::move(dstImage), VkImageSubresourceLayers {
+        dstSubresource.aspectMask,
+        dstSubresource.mipLevel,
+        dstSubresource.arrayLayer, 1 } });
+    }
+
+    if (!batch) {
+      for (UINT i = 0; i < layerCount; i++) {
+        HRESULT hr = StretchRectInternal(src, nullptr, dsts[i], nullptr, D3DTEXF_NONE, i);
+
+        if (unlikely(FAILED(hr)))
+          return hr;
+      }
+
+      return D3D_OK;
+    }
+
+    EmitCs([
+      cSrcImage = std::move(srcImage),
+      cSrcLayer = VkImageSubresourceLayers {
+        srcSubresource.aspectMask,
+        srcSubresource.mipLevel,
+        0, 1 },
+      cCopies   = std::move(copies),
+      cExtent   = srcExtent
+    ] (DxvkContext* ctx) {
+      bool needsResolve = cSrcImage->info().sampleCount != VK_SAMPLE_COUNT_1_BIT;
+
+      VkImageSubresourceLayers srcLayers = cSrcLayer;
+
+      for (const auto& copy : cCopies) {
+        if (needsResolve) {
+          VkImageResolve region;
+          region.srcSubresource = srcLayers;
+          region.srcOffset      = VkOffset3D { 0, 0, 0 };
+          region.dstSubresource = copy.layers;
+          region.dstOffset      = VkOffset3D { 0, 0, 0 };
+          region.extent         = cExtent;
+
+          ctx->resolveImage(copy.image, cSrcImage, region, VK_FORMAT_UNDEFINED);
+        } else {
+          ctx->copyImage(
+            copy.image, copy.layers, VkOffset3D { 0, 0, 0 },
+            cSrcImage, srcLayers, VkOffset3D { 0, 0, 0 },
+            cExtent);
+        }
+
+        srcLayers.baseArrayLayer += 1;
+      }
+    });
+
+    for (UINT i = 0; i < layerCount; i++) {
+      D3D9CommonTexture* dstTextureInfo = dsts[i]->GetCommonTexture();
+      dstTextureInfo->SetNeedsReadback(dsts[i]->GetSubresource(), true);
+
+      if (dstTextureInfo->IsAutomaticMip())
+        MarkTextureMipsDirty(dstTextureInfo);
+    }
+
+    return D3D_OK;
+  }
+
+
   HRESULT STDMETHODCALLTYPE D3D9DeviceEx::StretchRect(
           IDirect3DSurface9*   pSourceSurface,
     const RECT*                pSourceRect,
@@ -1891,10 +2027,7 @@ namespace dxvk {
 
     m_state.transforms[idx] = m_state.transforms[idx] * ConvertMatrix(pMatrix);
 
-    m_flags.set(D3D9DeviceFlag::DirtyFFVertexData);
-
-    if (idx == GetTransformIndex(D3DTS_VIEW) || idx >= GetTransformIndex(D3DTS_WORLD))
-      m_flags.set(D3D9DeviceFlag::DirtyFFVertexBlend);
+    SetTransformDirty(idx);
 
     return D3D_OK;
   }
@@ -2483,6 +2616,8 @@ namespace dxvk {
     if (unlikely(ppSB == nullptr || m_recorder == nullptr))
       return D3DERR_INVALIDCALL;
 
+    m_recorder->CompileDeltas();
+
     *ppSB = m_recorder.ref();
     if (!m_isD3D8Compatible)
       m_losableResourceCounter++;
@@ -2722,7 +2857,8 @@ namespace dxvk {
     EmitCs([this,
       cPrimType    = PrimitiveType,
       cPrimCount   = PrimitiveCount,
-      cStartVertex = StartVertex
+      cStartVertex = StartVertex,
+      cViewCount   = m_drawViewCount
     ](DxvkContext* ctx) {
       uint32_t vertexCount = GetVertexCount(cPrimType, cPrimCount);
 
@@ -2731,7 +2867,7 @@ namespace dxvk {
       // Tests on Windows show that D3D9 does not do non-indexed instanced draws.
 
       ctx->draw(
-        vertexCount, 1,
+        vertexCount, cViewCount,
         cStartVertex, 0);
     });
 
@@ -2773,9 +2909,10 @@ namespace dxvk {
       cPrimCount       = PrimitiveCount,
       cStartIndex      = StartIndex,
       cBaseVertexIndex = BaseVertexIndex,
-      cInstanceCount   = GetInstanceCount()
+      cInstanceCount   = GetInstanceCount(),
+      cViewCount       = m_drawViewCount
     ](DxvkContext* ctx) {
-      auto drawInfo = GenerateDrawInfo(cPrimType, cPrimCount, cInstanceCount);
+      auto drawInfo = GenerateDrawInfo(cPrimType, cPrimCount, cInstanceCount, cViewCount);
 
       ApplyPrimitiveType(ctx, cPrimType);
 
@@ -2816,7 +2953,8 @@ namespace dxvk {
       cBufferSlice  = std::move(upSlice.slice),
       cPrimType     = PrimitiveType,
       cStride       = VertexStreamZeroStride,
-      cVertexCount  = vertexCount
+      cVertexCount  = vertexCount,
+      cViewCount    = m_drawViewCount
     ](DxvkContext* ctx) mutable {
       ApplyPrimitiveType(ctx, cPrimType);
 
@@ -2824,7 +2962,7 @@ namespace dxvk {
 
       ctx->bindVertexBuffer(0, std::move(cBufferSlice), cStride);
       ctx->draw(
-        cVertexCount, 1,
+        cVertexCount, cViewCount,
         0, 0);
       ctx->bindVertexBuffer(0, DxvkBufferSlice(), 0);
     });
@@ -2878,10 +3016,11 @@ namespace dxvk {
       cPrimCount    = PrimitiveCount,
       cStride       = VertexStreamZeroStride,
       cInstanceCount = GetInstanceCount(),
+      cViewCount    = m_drawViewCount,
       cIndexType    = DecodeIndexType(
                         static_cast<D3D9Format>(IndexDataFormat))
     ](DxvkContext* ctx) {
-      auto drawInfo = GenerateDrawInfo(cPrimType, cPrimCount, cInstanceCount);
+      auto drawInfo = GenerateDrawInfo(cPrimType, cPrimCount, cInstanceCount, cViewCount);
 
       ApplyPrimitiveType(ctx, cPrimType);
 
@@ -2926,6 +3065,30 @@ namespace dxvk {
         return D3DERR_INVALIDCALL;
     }
 
+    if (!VertexCount)
+      return D3D_OK;
+
+    D3D9CommonBuffer* dst  = static_cast<D3D9VertexBuffer*>(pDestBuffer)->GetCommonBuffer();
+    D3D9VertexDecl*   decl = static_cast<D3D9VertexDecl*>  (pVertexDecl);
+
+    if (decl == nullptr) {
+      DWORD FVF = dst->Desc()->FVF;
+
+      auto iter = m_fvfTable.find(FVF);
+
+      if (iter == m_fvfTable.end()) {
+        decl = new D3D9VertexDecl(this, FVF);
+        m_fvfTable.insert(std::make_pair(FVF, decl));
+      }
+      else
+        decl = iter->second.ptr();
+    }
+
+    if (m_d3d9Options.cpuProcessVertices || !SupportsSWVP()) {
+      if (ProcessVerticesCpu(SrcStartIndex, DestIndex, VertexCount, dst, decl))
+        return D3D_OK;
+    }
+
     if (!SupportsSWVP()) {
       static bool s_errorShown = false;
 
@@ -2935,12 +3098,6 @@ namespace dxvk {
       return D3D_OK;
     }
 
-    if (!VertexCount)
-      return D3D_OK;
-
-    D3D9CommonBuffer* dst  = static_cast<D3D9VertexBuffer*>(pDestBuffer)->GetCommonBuffer();
-    D3D9VertexDecl*   decl = static_cast<D3D9VertexDecl*>  (pVertexDecl);
-
     bool dynamicSysmemVBOs;
     uint32_t firstIndex     = 0;
     int32_t baseVertexIndex = 0;
@@ -2956,19 +3113,6 @@ namespace dxvk {
 
     PrepareDraw(D3DPT_FORCE_DWORD, !dynamicSysmemVBOs, false);
 
-    if (decl == nullptr) {
-      DWORD FVF = dst->Desc()->FVF;
-
-      auto iter = m_fvfTable.find(FVF);
-
-      if (iter == m_fvfTable.end()) {
-        decl = new D3D9VertexDecl(this, FVF);
-        m_fvfTable.insert(std::make_pair(FVF, decl));
-      }
-      else
-        decl = iter->second.ptr();
-    }
-
     uint32_t offset = DestIndex * decl->GetSize(0);
 
     auto slice = dst->GetBufferSlice<D3D9_COMMON_BUFFER_TYPE_REAL>();
@@ -2988,7 +3132,7 @@ namespace dxvk {
     ](DxvkContext* ctx) mutable {
       Rc<DxvkShader> shader = m_swvpEmulator.GetShaderModule(this, std::move(cVertexElements));
 
-      auto drawInfo = GenerateDrawInfo(D3DPT_POINTLIST, cVertexCount, cInstanceCount);
+      auto drawInfo = GenerateDrawInfo(D3DPT_POINTLIST, cVertexCount, cInstanceCount, 1);
 
       if (drawInfo.instanceCount != 1) {
         drawInfo.instanceCount = 1;
@@ -3040,6 +3184,130 @@ namespace dxvk {
   }
 
 
+  bool D3D9DeviceEx::ProcessVerticesCpu(
+          UINT                    SrcStartIndex,
+          UINT                    DestIndex,
+          UINT                    VertexCount,
+          D3D9CommonBuffer*       pDestBuffer,
+          D3D9VertexDecl*         pVertexDecl) {
+    if (!UseProgrammableVS() || m_state.vertexDecl == nullptr)
+      return false;
+
+    const DxvkShaderKey& shaderKey = GetCommonShader(m_state.vertexShader)->GetShaderKey();
+
+    // Only fetch and decode the bytecode the first time a shader is used
+    Rc<D3D9SWVPProgram> program;
+
+    if (!m_swvpProcessor.FindProgram(shaderKey, &program)) {
+      D3D9VertexShader* shader = m_state.vertexShader.ptr();
+
+      UINT bytecodeSize = 0;
+      shader->GetFunction(nullptr, &bytecodeSize);
+
+      std::vector<uint8_t> bytecode(bytecodeSize);
+      shader->GetFunction(bytecode.data(), &bytecodeSize);
+
+      program = m_swvpProcessor.GetProgram(shaderKey, bytecode.data());
+    }
+
+    if (program == nullptr)
+      return false;
+
+    uint32_t dstStride = pVertexDecl->GetSize(0);
+    uint32_t dstSize   = pDestBuffer->Desc()->Size;
+
+    if (!dstStride || DestIndex >= dstSize / dstStride)
+      return true;
+
+    VertexCount = std::min(VertexCount, dstSize / dstStride - DestIndex);
+
+    D3D9SWVPJob job;
+    job.program         = program.ptr();
+    job.floatConsts     = m_state.vsConsts->fConsts;
+    job.floatConstCount = m_vsLayout.floatCount;
+    job.intConsts       = m_state.vsConsts->iConsts;
+    job.intConstCount   = m_vsLayout.intCount;
+    job.boolConsts      = m_state.vsConsts->bConsts;
+    job.boolConstCount  = m_vsLayout.boolCount;
+    job.firstVertex     = SrcStartIndex;
+    job.vertexCount     = VertexCount;
+    job.dstStride       = dstStride;
+    job.floatEmulation  = m_d3d9Options.d3d9FloatEmulation;
+
+    // Only the first instance is processed, same as on the GPU path
+    std::array<void*, caps::MaxStreams> streamData = { };
+
+    for (uint32_t reg : bit::BitMask(program->GetInputMask())) {
+      const DxsoSemantic& semantic = program->GetInputSemantic(reg);
+
+      for (const auto& element : m_state.vertexDecl->GetElements()) {
+        DxsoSemantic elementSemantic = { DxsoUsage(element.Usage), element.UsageIndex };
+
+        if (elementSemantic != semantic)
+          continue;
+
+        const D3D9VBO& vbo = m_state.vertexBuffers[element.Stream];
+        D3D9CommonBuffer* buffer = GetCommonBuffer(vbo.vertexBuffer);
+
+        if (buffer == nullptr)
+          break;
+
+        void*& data = streamData[element.Stream];
+
+        if (data == nullptr && FAILED(LockBuffer(buffer, 0, 0, &data, D3DLOCK_READONLY))) {
+          data = nullptr;
+          break;
+        }
+
+        uint32_t offset = vbo.offset + element.Offset;
+        uint32_t size   = buffer->Desc()->Size;
+        uint32_t limit  = 0;
+
+        if (offset + GetDecltypeSize(D3DDECLTYPE(element.Type)) <= size) {
+          limit = vbo.stride
+            ? (size - offset - GetDecltypeSize(D3DDECLTYPE(element.Type))) / vbo.stride + 1
+            : ~0u;
+        }
+
+        D3D9SWVPInputElement input;
+        input.reg         = reg;
+        input.data        = reinterpret_cast<const uint8_t*>(data) + offset;
+        input.stride      = vbo.stride;
+        input.vertexLimit = limit;
+        input.type        = D3DDECLTYPE(element.Type);
+        input.instanced   = m_state.streamFreq[element.Stream] & D3DSTREAMSOURCE_INSTANCEDATA;
+        job.inputs.push_back(input);
+        break;
+      }
+    }
+
+    for (const auto& element : pVertexDecl->GetElements()) {
+      if (element.Stream != 0 || element.Type == D3DDECLTYPE_UNUSED)
+        continue;
+
+      uint32_t slot = program->FindOutput({ DxsoUsage(element.Usage), element.UsageIndex });
+
+      if (slot < D3D9SWVPProgram::MaxOutputs)
+        job.outputs.push_back({ slot, element.Offset, D3DDECLTYPE(element.Type) });
+    }
+
+    void* dstData = nullptr;
+
+    if (SUCCEEDED(LockBuffer(pDestBuffer, DestIndex * dstStride, VertexCount * dstStride, &dstData, 0))) {
+      job.dstData = reinterpret_cast<uint8_t*>(dstData);
+      m_swvpProcessor.ProcessVertices(job);
+      UnlockBuffer(pDestBuffer);
+    }
+
+    for (uint32_t i = 0; i < caps::MaxStreams; i++) {
+      if (streamData[i] != nullptr)
+        UnlockBuffer(GetCommonBuffer(m_state.vertexBuffers[i].vertexBuffer));
+    }
+
+    return true;
+  }
+
+
   HRESULT STDMETHODCALLTYPE D3D9DeviceEx::CreateVertexDeclaration(
     const D3DVERTEXELEMENT9*            pVertexElements,
           IDirect3DVertexDeclaration9** ppDecl) {
@@ -3155,7 +3423,8 @@ namespace dxvk {
       return D3DERR_INVALIDCALL;
 
     DxsoModuleInfo moduleInfo;
-    moduleInfo.options = m_dxsoOptions;
+    moduleInfo.options   = m_dxsoOptions;
+    moduleInfo.multiView = m_multiViewVS;
 
     D3D9CommonShader module;
     uint32_t bytecodeLength;
@@ -3856,7 +4125,7 @@ namespace dxvk {
       return D3DERR_INVALIDCALL;
 
     try {
-      const Com<D3D9Surface> surface = new D3D9Surface(this, pDesc, nullptr, pSharedHandle);
+      const Com<D3D9Surface> surface = new D3D9Surface(this, pDesc, nullptr, nullptr, pSharedHandle);
       m_initializer->InitTexture(surface->GetCommonTexture());
       *ppSurface = surface.ref();
       m_losableResourceCounter++;
@@ -3869,6 +4138,28 @@ namespace dxvk {
     }
   }
 
+  HRESULT D3D9DeviceEx::CreateRenderTargetFromVkImage(D3D9_COMMON_TEXTURE_DESC* pDesc, const D3D9_COMMON_TEXTURE_IMPORT_INFO* pImport, IDirect3DSurface9** ppSurface)
+  {
+    if (unlikely(pImport->Image == VK_NULL_HANDLE || !(pImport->Usage & VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT)))
+      return D3DERR_INVALIDCALL;
+
+    if (FAILED(D3D9CommonTexture::NormalizeTextureProperties(this, D3DRTYPE_TEXTURE, pDesc)))
+      return D3DERR_INVALIDCALL;
+
+    try {
+      // The image contents belong to its owner, so don't clear it, and
+      // don't count it as losable since a reset must not release it.
+      const Com<D3D9Surface> surface = new D3D9Surface(this, pDesc, nullptr, pImport, nullptr);
+      *ppSurface = surface.ref();
+
+      return D3D_OK;
+    }
+    catch (const DxvkError& e) {
+      Logger::err(e.message());
+      return D3DERR_INVALIDCALL;
+    }
+  }
+
   HRESULT STDMETHODCALLTYPE D3D9DeviceEx::CreateRenderTargetEx(
           UINT                Width,
           UINT                Height,
@@ -3941,7 +4232,7 @@ namespace dxvk {
       return D3DERR_INVALIDCALL;
 
     try {
-      const Com<D3D9Surface> surface = new D3D9Surface(this, &desc, nullptr, pSharedHandle);
+      const Com<D3D9Surface> surface = new D3D9Surface(this, &desc, nullptr, nullptr, pSharedHandle);
       m_initializer->InitTexture(surface->GetCommonTexture());
       *ppSurface = surface.ref();
       
@@ -4181,12 +4472,52 @@ namespace dxvk {
 
     m_state.transforms[idx] = ConvertMatrix(pMatrix);
 
-    m_flags.set(D3D9DeviceFlag::DirtyFFVertexData);
+    SetTransformDirty(idx);
 
-    if (idx == GetTransformIndex(D3DTS_VIEW) || idx >= GetTransformIndex(D3DTS_WORLD))
+    return D3D_OK;
+  }
+
+
+  void D3D9DeviceEx::SetTransformDirty(uint32_t idx) {
+    const uint32_t viewIdx = GetTransformIndex(D3DTS_VIEW);
+    const uint32_t projIdx = GetTransformIndex(D3DTS_PROJECTION);
+
+    if (idx != viewIdx && idx != projIdx)
+      m_flags.set(D3D9DeviceFlag::DirtyFFVertexData);
+
+    if (idx == viewIdx || idx == projIdx)
+      m_flags.set(D3D9DeviceFlag::DirtyFFViewData);
+
+    if (idx >= GetTransformIndex(D3DTS_WORLD))
       m_flags.set(D3D9DeviceFlag::DirtyFFVertexBlend);
+  }
 
-    return D3D_OK;
+
+  void D3D9DeviceEx::SetViewTransformsFF(
+          uint32_t    FirstView,
+          uint32_t    ViewCount,
+    const D3DMATRIX*  pViews,
+    const D3DMATRIX*  pProjections) {
+    for (uint32_t i = 0; i < ViewCount; i++) {
+      const uint32_t view = FirstView + i;
+      const uint32_t bit  = 1u << view;
+
+      if (pViews) {
+        m_viewTransformsFF[view] = ConvertMatrix(&pViews[i]);
+        m_viewTransformMaskFF |= bit;
+      } else {
+        m_viewTransformMaskFF &= ~bit;
+      }
+
+      if (pProjections) {
+        m_projTransformsFF[view] = ConvertMatrix(&pProjections[i]);
+        m_projTransformMaskFF |= bit;
+      } else {
+        m_projTransformMaskFF &= ~bit;
+      }
+    }
+
+    m_flags.set(D3D9DeviceFlag::DirtyFFViewData);
   }
 
 
@@ -4312,6 +4643,9 @@ namespace dxvk {
 
     // SM3 level hardware
     enabled.core.features.multiViewport = VK_TRUE;
+
+    // Instanced views export the viewport index from the vertex shader
+    enabled.vk12.shaderOutputViewportIndex = supported.vk12.shaderOutputViewportIndex;
     enabled.core.features.independentBlend = VK_TRUE;
 
     // D3D10 level hardware supports this in D3D9 native.
@@ -4355,61 +4689,77 @@ namespace dxvk {
 
 
   D3D9BufferSlice D3D9DeviceEx::AllocUPBuffer(VkDeviceSize size) {
-    constexpr VkDeviceSize UPBufferSize = 1 << 20;
-
-    if (unlikely(m_upBuffer == nullptr || size > UPBufferSize)) {
-      VkMemoryPropertyFlags memoryFlags
-        = VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
-        | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
-        | VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
-
-      DxvkBufferCreateInfo info;
-      info.size   = std::max(UPBufferSize, size);
-      info.usage  = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT
-                  | VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
-      info.access = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT
-                  | VK_ACCESS_INDEX_READ_BIT;
-      info.stages = VK_PIPELINE_STAGE_VERTEX_INPUT_BIT;
-
-      Rc<DxvkBuffer> buffer = m_dxvkDevice->createBuffer(info, memoryFlags);
-
-      if (size <= UPBufferSize) {
-        m_upBuffer = std::move(buffer);
-        m_upBufferMapPtr = m_upBuffer->mapPtr(0);
-      } else {
-        // Temporary buffer
-        D3D9BufferSlice result;
-        result.slice = DxvkBufferSlice(std::move(buffer), 0, size);
-        result.mapPtr = buffer->mapPtr(0);
-        return result;
+    VkDeviceSize alignedSize = align(size, CACHE_LINE_SIZE);
+
+    if (unlikely(m_upAllocated + alignedSize > m_upBufferBase + m_upBufferSize)) {
+      // Skip the remainder of the buffer and start over at offset 0.
+      // This is also the only point where the buffer can be replaced,
+      // slices of the old buffer keep it alive until the GPU is done.
+      if (m_upBuffer != nullptr) {
+        m_upAllocated = m_upBufferBase + m_upBufferSize;
+        m_upFrameWraps += 1;
       }
-    }
 
-    VkDeviceSize alignedSize = align(size, CACHE_LINE_SIZE);
+      m_upBufferBase = m_upAllocated;
 
-    if (unlikely(m_upBufferOffset + alignedSize > UPBufferSize)) {
-      auto sliceHandle = m_upBuffer->allocSlice();
+      VkDeviceSize requiredSize = std::max(m_upBufferTargetSize, alignedSize);
 
-      m_upBufferOffset = 0;
-      m_upBufferMapPtr = sliceHandle.mapPtr;
+      if (m_upBufferSize < requiredSize) {
+        VkDeviceSize bufferSize = std::max(m_upBufferSize, MinUPBufferSize);
 
-      EmitCs([
-        cBuffer = m_upBuffer,
-        cSlice  = sliceHandle
-      ] (DxvkContext* ctx) {
-        ctx->invalidateBuffer(cBuffer, cSlice);
-      });
+        while (bufferSize < requiredSize)
+          bufferSize *= 2;
+
+        CreateUPBuffer(bufferSize);
+      }
     }
 
+    // Data written during the previous pass over the buffer may still
+    // be in use, data from before the buffer was created is not.
+    VkDeviceSize limit = std::max(m_upLastSignaled, m_upBufferStart) + m_upBufferSize;
+
+    if (unlikely(m_upAllocated + alignedSize > limit))
+      WaitUPBuffer(m_upAllocated + alignedSize - m_upBufferSize);
+
+    VkDeviceSize offset = m_upAllocated - m_upBufferBase;
+
     D3D9BufferSlice result;
-    result.slice = DxvkBufferSlice(m_upBuffer, m_upBufferOffset, size);
-    result.mapPtr = reinterpret_cast<char*>(m_upBufferMapPtr) + m_upBufferOffset;
+    result.slice = DxvkBufferSlice(m_upBuffer, offset, size);
+    result.mapPtr = reinterpret_cast<char*>(m_upBufferMapPtr) + offset;
 
-    m_upBufferOffset += alignedSize;
+    m_upAllocated += alignedSize;
     return result;
   }
 
 
+  void D3D9DeviceEx::CreateUPBuffer(VkDeviceSize size) {
+    VkMemoryPropertyFlags memoryFlags
+      = VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+      | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
+      | VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+
+    DxvkBufferCreateInfo info;
+    info.size   = size;
+    info.usage  = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT
+                | VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
+    info.access = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT
+                | VK_ACCESS_INDEX_READ_BIT;
+    info.stages = VK_PIPELINE_STAGE_VERTEX_INPUT_BIT;
+
+    m_upBuffer = m_dxvkDevice->createBuffer(info, memoryFlags);
+    m_upBufferMapPtr = m_upBuffer->mapPtr(0);
+    m_upBufferSize = size;
+    m_upBufferStart = m_upAllocated;
+  }
+
+
+  void D3D9DeviceEx::WaitUPBuffer(VkDeviceSize required) {
+    m_upRequired = required;
+
+    WaitStagingBuffer();
+  }
+
+
   D3D9BufferSlice D3D9DeviceEx::AllocStagingBuffer(VkDeviceSize size) {
     m_stagingBufferAllocated += size;
 
@@ -4421,13 +4771,16 @@ namespace dxvk {
 
 
   void D3D9DeviceEx::EmitStagingBufferMarker() {
-    if (m_stagingBufferLastAllocated == m_stagingBufferAllocated)
+    if (m_stagingBufferLastAllocated == m_stagingBufferAllocated
+     && m_upLastAllocated == m_upAllocated)
       return;
 
     D3D9StagingBufferMarkerPayload payload;
     payload.sequenceNumber = GetCurrentSequenceNumber();
     payload.allocated = m_stagingBufferAllocated;
+    payload.upAllocated = m_upAllocated;
     m_stagingBufferLastAllocated = m_stagingBufferAllocated;
+    m_upLastAllocated = m_upAllocated;
 
     Rc<D3D9StagingBufferMarker> marker = new D3D9StagingBufferMarker(payload);
     m_stagingBufferMarkers.push(marker);
@@ -4448,13 +4801,22 @@ namespace dxvk {
       ? StagingBufferSize * 4
       : StagingBufferSize * 16;
 
+    // The UP ring buffer shares the marker queue with the staging
+    // buffer, and needs to stall until the region it wants to reuse
+    // is no longer in use.
+    auto needsStall = [this] {
+      return m_stagingBufferLastSignaled + maxStagingMemoryInFlight < m_stagingBufferAllocated
+          || m_upLastSignaled < m_upRequired;
+    };
+
     // If the game uploads a significant amount of data at once, it's
     // possible that we exceed the limit while the queue is empty. In
     // that case, enforce a flush early to populate the marker queue.
+    // The same applies if the UP data we need to wait for was not
+    // covered by any marker yet.
     bool didFlush = false;
 
-    if (m_stagingBufferLastSignaled + maxStagingMemoryInFlight < m_stagingBufferAllocated
-     && m_stagingBufferMarkers.empty()) {
+    if (needsStall() && (m_stagingBufferMarkers.empty() || m_upLastAllocated < m_upRequired)) {
       Flush();
       didFlush = true;
     }
@@ -4468,10 +4830,10 @@ namespace dxvk {
       const auto& marker = m_stagingBufferMarkers.front();
       const auto& payload = marker->payload();
 
-      bool needsStall = m_stagingBufferLastSignaled + maxStagingMemoryInFlight < m_stagingBufferAllocated;
+      bool stall = needsStall();
 
       if (payload.sequenceNumber > lastSequenceNumber) {
-        if (!needsStall)
+        if (!stall)
           break;
 
         SynchronizeCsThread(payload.sequenceNumber);
@@ -4479,7 +4841,7 @@ namespace dxvk {
       }
 
       if (marker->isInUse(DxvkAccess::Read)) {
-        if (!needsStall)
+        if (!stall)
           break;
 
         if (!didFlush) {
@@ -4491,6 +4853,7 @@ namespace dxvk {
       }
 
       m_stagingBufferLastSignaled = marker->payload().allocated;
+      m_upLastSignaled = marker->payload().upAllocated;
       m_stagingBufferMarkers.pop();
     }
   }
@@ -5046,6 +5409,56 @@ namespace dxvk {
     return D3D_OK;
   }
 
+  Rc<DxvkImage> D3D9DeviceEx::GetImportedImage(
+          VkImage     Image,
+          VkFormat    Format,
+          VkExtent3D  Extent) {
+    D3D9ImportedImageKey key = { Image, Format, Extent };
+
+    auto entry = m_importedImages.find(key);
+
+    if (entry != m_importedImages.end()) {
+      m_importedImageStats.hits += 1;
+      return entry->second;
+    }
+
+    m_importedImageStats.misses += 1;
+
+    DxvkImageCreateInfo info;
+    info.type            = VK_IMAGE_TYPE_2D;
+    info.format          = Format;
+    info.sampleCount     = VK_SAMPLE_COUNT_1_BIT;
+    info.extent          = Extent;
+    info.numLayers       = 1;
+    info.mipLevels       = 1;
+    info.usage           = VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+    info.stages          = VK_PIPELINE_STAGE_TRANSFER_BIT;
+    info.access          = VK_ACCESS_TRANSFER_WRITE_BIT;
+    info.tiling          = VK_IMAGE_TILING_OPTIMAL;
+    info.layout          = VK_IMAGE_LAYOUT_UNDEFINED;
+    info.shared          = VK_FALSE;
+    info.viewFormats     = &Format;
+    info.viewFormatCount = 1;
+
+    Rc<DxvkImage> image = m_dxvkDevice->importImage(info, Image, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    m_importedImages.insert({ key, image });
+    return image;
+  }
+
+  void D3D9DeviceEx::InvalidateImportedImages(VkImage Image) {
+    if (Image == VK_NULL_HANDLE) {
+      m_importedImages.clear();
+      return;
+    }
+
+    for (auto i = m_importedImages.begin(); i != m_importedImages.end(); ) {
+      if (i->first.image == Image)
+        i = m_importedImages.erase(i);
+      else
+        i++;
+    }
+  }
+
   void D3D9DeviceEx::UpdateTextureFromBuffer(
     D3D9CommonTexture* pDestTexture,
     D3D9CommonTexture* pSrcTexture,
@@ -5599,8 +6012,44 @@ namespace dxvk {
   }
 
 
+  void D3D9DeviceEx::DispatchFullCsChunk() {
+    m_csFlushChunkId += m_csChunk->blockSize() / DxvkCsChunk::DefaultBlockSize;
+    m_csChunkPartial = false;
+
+    EmitCsChunk(std::move(m_csChunk));
+
+    // Use larger chunks while the CS thread is falling behind, e.g.
+    // while loading, and go back to regular chunks once it catches up
+    if (!m_d3d9Options.reproducibleCommandStream) {
+      uint64_t lag = GetCsSequenceLag();
+
+      if (lag >= LargeCsChunkLag)
+        m_csChunkSize = DxvkCsChunk::LargeBlockSize;
+      else if (lag <= 1)
+        m_csChunkSize = DxvkCsChunk::DefaultBlockSize;
+    }
+
+    m_csChunk = AllocCsChunk();
+  }
+
+
+  void D3D9DeviceEx::ConsiderEarlyCsDispatch() {
+    // If the CS thread has nothing left to do, hand over
+    // what we have instead of letting it idle until the
+    // current chunk is full.
+    if (GetCsSequenceLag())
+      return;
+
+    EmitCsChunk(std::move(m_csChunk));
+
+    m_csChunkSize = DxvkCsChunk::DefaultBlockSize;
+    m_csChunk = AllocCsChunk();
+    m_csChunkPartial = true;
+  }
+
+
   void D3D9DeviceEx::ConsiderFlush(GpuFlushType FlushType) {
-    uint64_t chunkId = GetCurrentSequenceNumber();
+    uint64_t chunkId = GetCurrentFlushChunkId();
     uint64_t submissionId = m_submissionFence->value();
 
     if (m_flushTracker.considerFlush(FlushType, chunkId, submissionId))
@@ -5727,6 +6176,11 @@ namespace dxvk {
       DxsoConstantBuffers::PSShared,
       sizeof(D3D9SharedPS));
 
+    m_vsFixedFunctionViews = D3D9ConstantBuffer(this,
+      DxsoProgramType::VertexShader,
+      DxsoConstantBuffers::VSFixedFunctionViews,
+      sizeof(D3D9FixedFunctionViews));
+
     m_vsVertexBlend = D3D9ConstantBuffer(this,
       DxsoProgramType::VertexShader,
       DxsoConstantBuffers::VSVertexBlendData,
@@ -5984,7 +6438,7 @@ namespace dxvk {
 
     FlushCsChunk();
 
-    m_flushSeqNum = m_csSeqNum;
+    m_flushSeqNum = m_csFlushChunkId;
     m_flushTracker.notifyFlush(m_flushSeqNum, submissionId);
 
     // If necessary, block calling thread until the
@@ -6004,9 +6458,46 @@ namespace dxvk {
   }
 
 
+  void D3D9DeviceEx::WriteTimestamp(const Rc<DxvkGpuQuery>& Query) {
+    EmitCs([cQuery = Query] (DxvkContext* ctx) {
+      ctx->writeTimestamp(cQuery);
+    });
+  }
+
+
+  void D3D9DeviceEx::SignalFence(const Rc<DxvkFence>& Fence, uint64_t Value) {
+    D3D9DeviceLock lock = LockDevice();
+
+    EmitCs([
+      cFence = Fence,
+      cValue = Value
+    ] (DxvkContext* ctx) {
+      ctx->signalFence(cFence, cValue);
+    });
+
+    ExecuteFlush<false>();
+  }
+
+
   void D3D9DeviceEx::EndFrame() {
     D3D9DeviceLock lock = LockDevice();
 
+    VkDeviceSize upFrameBytes = m_upAllocated - m_upFrameStart;
+
+    m_upBufferStats.bufferSize    = m_upBufferSize;
+    m_upBufferStats.bytesPerFrame = upFrameBytes;
+    m_upBufferStats.wrapsPerFrame = m_upFrameWraps;
+
+    m_upFrameStart = m_upAllocated;
+    m_upFrameWraps = 0;
+
+    // Size the UP buffer so that all frames in flight fit without
+    // stalling. The buffer only grows the next time it wraps around.
+    VkDeviceSize upTargetSize = std::min(upFrameBytes * (GetFrameLatency() + 1), MaxUPBufferSize);
+
+    while (m_upBufferTargetSize < upTargetSize)
+      m_upBufferTargetSize *= 2;
+
     EmitCs<false>([] (DxvkContext* ctx) {
       ctx->endFrame();
     });
@@ -6426,6 +6917,23 @@ namespace dxvk {
       }
     }
 
+    // Only render multiple views if all attachments have enough
+    // layers, otherwise the render pass would be invalid
+    if (m_viewMask) {
+      uint32_t layerCount = caps::MaxViewCount;
+
+      for (uint32_t i = 0; i < caps::MaxSimultaneousRenderTargets; i++) {
+        if (attachments.color[i].view != nullptr)
+          layerCount = std::min(layerCount, attachments.color[i].view->info().numLayers);
+      }
+
+      if (attachments.depth.view != nullptr)
+        layerCount = std::min(layerCount, attachments.depth.view->info().numLayers);
+
+      if (!(m_viewMask >> layerCount))
+        attachments.viewMask = m_viewMask;
+    }
+
     VkImageAspectFlags feedbackLoopAspects = 0u;
     if (m_hazardLayout == VK_IMAGE_LAYOUT_ATTACHMENT_FEEDBACK_LOOP_OPTIMAL_EXT) {
       if (m_activeHazardsRT != 0)
@@ -6512,14 +7020,28 @@ namespace dxvk {
         VkExtent2D { vp.Width,      vp.Height     }};
     }
 
+    // With instanced views, further views are placed next to the
+    // first one, i.e. the render target holds all views side by side
+    std::array<VkViewport, caps::MaxViewCount> viewports;
+    std::array<VkRect2D,   caps::MaxViewCount> scissors;
+
+    for (uint32_t i = 0; i < m_instancedViewCount; i++) {
+      viewports[i] = viewport;
+      viewports[i].x += float(i * vp.Width);
+
+      scissors[i] = scissor;
+      scissors[i].offset.x += int32_t(i * vp.Width);
+    }
+
     EmitCs([
-      cViewport = viewport,
-      cScissor = scissor
+      cViewports = viewports,
+      cScissors  = scissors,
+      cCount     = m_instancedViewCount
     ] (DxvkContext* ctx) {
       ctx->setViewports(
-        1,
-        &cViewport,
-        &cScissor);
+        cCount,
+        cViewports.data(),
+        cScissors.data());
     });
   }
 
@@ -6827,10 +7349,10 @@ namespace dxvk {
     ] (DxvkContext* ctx) {
       VkShaderStageFlags stage = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
 
-      auto pair = m_samplers.find(cKey);
-      if (pair != m_samplers.end()) {
-        ctx->bindResourceSampler(stage, cSlot,
-          Rc<DxvkSampler>(pair->second));
+      Rc<DxvkSampler> cached = m_samplers.Find(cKey);
+
+      if (cached != nullptr) {
+        ctx->bindResourceSampler(stage, cSlot, std::move(cached));
         return;
       }
 
@@ -6875,10 +7397,10 @@ namespace dxvk {
       try {
         auto sampler = m_dxvkDevice->createSampler(info);
 
-        m_samplers.insert(std::make_pair(cKey, sampler));
+        m_samplers.Insert(cKey, sampler);
         ctx->bindResourceSampler(stage, cSlot, std::move(sampler));
 
-        m_samplerCount++;
+        m_samplerCount.store(m_samplers.GetCount());
       }
       catch (const DxvkError& e) {
         Logger::err(e.message());
@@ -6960,12 +7482,14 @@ namespace dxvk {
   D3D9DrawInfo D3D9DeviceEx::GenerateDrawInfo(
           D3DPRIMITIVETYPE PrimitiveType,
           UINT             PrimitiveCount,
-          UINT             InstanceCount) {
+          UINT             InstanceCount,
+          UINT             ViewCount) {
     D3D9DrawInfo drawInfo;
     drawInfo.vertexCount = GetVertexCount(PrimitiveType, PrimitiveCount);
     drawInfo.instanceCount = m_iaState.streamsInstanced & m_iaState.streamsUsed
       ? InstanceCount
       : 1u;
+    drawInfo.instanceCount *= ViewCount;
     return drawInfo;
   }
 
@@ -7072,6 +7596,8 @@ namespace dxvk {
       UpdateFixedFunctionVS();
     }
 
+    UpdateDrawViewCount();
+
     if (m_flags.test(D3D9DeviceFlag::DirtyInputLayout))
       BindInputLayout();
 
@@ -7161,7 +7687,8 @@ namespace dxvk {
   template <DxsoProgramType ShaderStage>
   void D3D9DeviceEx::BindShader(
   const D3D9CommonShader*                 pShaderModule) {
-    auto shader = pShaderModule->GetShader();
+    auto shader = pShaderModule->GetShader(
+      ShaderStage == DxsoProgramType::VertexShader && m_multiViewVS.enabled());
 
     if (unlikely(shader->needsLibraryCompile()))
       m_dxvkDevice->requestCompileShader(shader);
@@ -7201,7 +7728,8 @@ namespace dxvk {
         cVertexDecl       = std::move(vertexDecl),
         cVertexShader     = std::move(vertexShader),
         cStreamsInstanced = m_instancedData,
-        cStreamFreq       = streamFreq
+        cStreamFreq       = streamFreq,
+        cViewCount        = m_drawViewCount
       ] (DxvkContext* ctx) {
         cIaState.streamsInstanced = cStreamsInstanced;
         cIaState.streamsUsed      = 0;
@@ -7250,7 +7778,9 @@ namespace dxvk {
 
           uint32_t instanceData = cStreamFreq[binding.binding % caps::MaxStreams];
           if (instanceData & D3DSTREAMSOURCE_INSTANCEDATA) {
-            binding.fetchRate = instanceData & 0x7FFFFF; // Remove instance packed-in flags in the data.
+            // Remove instance packed-in flags in the data. With instanced views,
+            // each D3D9 instance spans one hardware instance per view.
+            binding.fetchRate = (instanceData & 0x7FFFFF) * cViewCount;
             binding.inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
           }
           else {
@@ -7428,7 +7958,14 @@ namespace dxvk {
         ? m_consts[ProgramType].meta.maxConstIndexF
         : m_consts[ProgramType].meta.maxConstIndexI;
 
-      m_consts[ProgramType].dirty |= StartRegister < maxCount;
+      // Games commonly set the same constants again for every draw.
+      // The uploaded data matches the current state as long as the set
+      // is not dirty, so only registers whose values actually change
+      // and that the shader can read need to trigger another upload.
+      if (StartRegister < maxCount && !m_consts[ProgramType].dirty) {
+        m_consts[ProgramType].dirty = HasConstantChanged<ProgramType, ConstantType>(
+          StartRegister, pConstantData, std::min(Count, maxCount - StartRegister));
+      }
     } else if constexpr (ProgramType == DxsoProgramType::VertexShader) {
       if (unlikely(CanSWVP())) {
         m_consts[DxsoProgramType::VertexShader].dirty |= StartRegister < m_consts[ProgramType].meta.maxConstIndexB;
@@ -7446,6 +7983,51 @@ namespace dxvk {
   }
 
 
+  template <
+    DxsoProgramType  ProgramType,
+    D3D9ConstantType ConstantType,
+    typename         T>
+  bool D3D9DeviceEx::HasConstantChanged(
+          UINT  StartRegister,
+    const T*    pConstantData,
+          UINT  Count) {
+    const void* pOldData;
+
+    if constexpr (ProgramType == DxsoProgramType::VertexShader) {
+      pOldData = ConstantType == D3D9ConstantType::Float
+        ? static_cast<const void*>(&m_state.vsConsts->fConsts[StartRegister])
+        : static_cast<const void*>(&m_state.vsConsts->iConsts[StartRegister]);
+    } else {
+      pOldData = ConstantType == D3D9ConstantType::Float
+        ? static_cast<const void*>(&m_state.psConsts->fConsts[StartRegister])
+        : static_cast<const void*>(&m_state.psConsts->iConsts[StartRegister]);
+    }
+
+    // Float and int registers are both four dwords in size
+    return std::memcmp(pOldData, pConstantData, Count * 4 * sizeof(T)) != 0;
+  }
+
+
+  void D3D9DeviceEx::UpdateDrawViewCount() {
+    uint32_t viewCount = 1;
+
+    if (unlikely(m_instancedViewCount > 1)) {
+      if (UseProgrammableVS()) {
+        if (m_multiViewVS.enabled())
+          viewCount = GetCommonShader(m_state.vertexShader)->GetInstancedViewCount();
+      } else {
+        viewCount = m_instancedViewCount;
+      }
+    }
+
+    // Instance-rate vertex attributes depend on the view count
+    if (unlikely(m_drawViewCount != viewCount)) {
+      m_drawViewCount = viewCount;
+      m_flags.set(D3D9DeviceFlag::DirtyInputLayout);
+    }
+  }
+
+
   void D3D9DeviceEx::UpdateFixedFunctionVS() {
     // Shader...
     bool hasPositionT = m_state.vertexDecl != nullptr ? m_state.vertexDecl->TestFlag(D3D9VertexDeclFlag::HasPositionT) : false;
@@ -7502,7 +8084,8 @@ namespace dxvk {
       key.Data.Contents.AmbientSource    = m_state.renderStates[D3DRS_AMBIENTMATERIALSOURCE]  & mask;
       key.Data.Contents.SpecularSource   = m_state.renderStates[D3DRS_SPECULARMATERIALSOURCE] & mask;
       key.Data.Contents.EmissiveSource   = m_state.renderStates[D3DRS_EMISSIVEMATERIALSOURCE] & mask;
-      key.Data.Contents.MultiView        = m_multiViewFF;
+      key.Data.Contents.ViewCount        = ActiveViewCountFF();
+      key.Data.Contents.InstancedViews   = m_instancedViewCount > 1;
 
       uint32_t lightCount = 0;
 
@@ -7586,30 +8169,10 @@ namespace dxvk {
 
       auto mapPtr = m_vsFixedFunction.AllocSlice();
 
-      auto View = m_state.transforms[GetTransformIndex(D3DTS_VIEW)];
-      auto WorldView    = View * m_state.transforms[GetTransformIndex(D3DTS_WORLD)];
-      auto NormalMatrix = inverse(WorldView);
-      auto Projection = m_state.transforms[GetTransformIndex(D3DTS_PROJECTION)];
-
       D3D9FixedFunctionVS* data = reinterpret_cast<D3D9FixedFunctionVS*>(mapPtr);
-      data->WorldView     = WorldView;
-      data->NormalMatrix  = NormalMatrix;
-      data->InverseView   = transpose(inverse(View));
-      data->Projection    = Projection;
-
-      if (m_multiViewFF) {
-        // We're misusing D3DTS_WORLDMATRIX indices 10 and 11 to pass the view matrix and projection matrix of another view into the generated fixed-function shader
-        // This will break if software vertex processing is in use, but in our use case it is not ever enabled
-        auto View2 = m_state.transforms[GetTransformIndex(D3DTS_WORLDMATRIX(10))];
-        auto WorldView2   = View2 * m_state.transforms[GetTransformIndex(D3DTS_WORLD)];
-        auto NormalMatrix2 = inverse(WorldView2);
-        auto Projection2 = m_state.transforms[GetTransformIndex(D3DTS_WORLDMATRIX(11))];
-
-        data->WorldView2    = WorldView2;
-        data->NormalMatrix2 = NormalMatrix2;
-        data->InverseView2  = transpose(inverse(View2));
-        data->Projection2   = Projection2;
-      }
+
+      data->World        = m_state.transforms[GetTransformIndex(D3DTS_WORLD)];
+      data->InverseWorld = inverse(data->World);
 
       for (uint32_t i = 0; i < data->TexcoordMatrices.size(); i++)
         data->TexcoordMatrices[i] = m_state.transforms[GetTransformIndex(D3DTS_TEXTURE0) + i];
@@ -7624,20 +8187,42 @@ namespace dxvk {
         if (idx == UINT32_MAX)
           continue;
 
-        data->Lights[lightIdx++] = D3D9Light(m_state.lights[idx].value(), m_state.transforms[GetTransformIndex(D3DTS_VIEW)]);
+        data->Lights[lightIdx++] = D3D9Light(m_state.lights[idx].value());
       }
 
       data->Material = m_state.material;
       data->TweenFactor = bit::cast<float>(m_state.renderStates[D3DRS_TWEENFACTOR]);
     }
 
+    if (m_flags.test(D3D9DeviceFlag::DirtyFFViewData)) {
+      m_flags.clr(D3D9DeviceFlag::DirtyFFViewData);
+
+      auto mapPtr = m_vsFixedFunctionViews.AllocSlice();
+
+      D3D9FixedFunctionViews* data = reinterpret_cast<D3D9FixedFunctionViews*>(mapPtr);
+
+      for (uint32_t i = 0; i < ActiveViewCountFF(); i++) {
+        auto& view = data->Views[i];
+
+        view.View = (m_viewTransformMaskFF & (1u << i))
+          ? m_viewTransformsFF[i]
+          : m_state.transforms[GetTransformIndex(D3DTS_VIEW)];
+
+        view.InverseView = inverse(view.View);
+
+        view.Projection = (m_projTransformMaskFF & (1u << i))
+          ? m_projTransformsFF[i]
+          : m_state.transforms[GetTransformIndex(D3DTS_PROJECTION)];
+      }
+    }
+
     if (m_flags.test(D3D9DeviceFlag::DirtyFFVertexBlend) && vertexBlendMode == D3D9FF_VertexBlendMode_Normal) {
       m_flags.clr(D3D9DeviceFlag::DirtyFFVertexBlend);
 
       auto mapPtr = m_vsVertexBlend.AllocSlice();
       auto UploadVertexBlendData = [&](auto data) {
-        for (uint32_t i = 0; i < std::size(data->WorldView); i++)
-          data->WorldView[i] = m_state.transforms[GetTransformIndex(D3DTS_VIEW)] * m_state.transforms[GetTransformIndex(D3DTS_WORLDMATRIX(i))];
+        for (uint32_t i = 0; i < std::size(data->World); i++)
+          data->World[i] = m_state.transforms[GetTransformIndex(D3DTS_WORLDMATRIX(i))];
       };
 
       (m_isSWVP && indexedVertexBlend)
@@ -8214,7 +8799,7 @@ namespace dxvk {
       if (FAILED(D3D9CommonTexture::NormalizeTextureProperties(this, D3DRTYPE_TEXTURE, &desc)))
         return D3DERR_NOTAVAILABLE;
 
-      m_autoDepthStencil = new D3D9Surface(this, &desc, nullptr, nullptr);
+      m_autoDepthStencil = new D3D9Surface(this, &desc, nullptr, nullptr, nullptr);
       m_initializer->InitTexture(m_autoDepthStencil->GetCommonTexture());
       SetDepthStencilSurface(m_autoDepthStencil.ptr());
       m_losableResourceCounter++;
@@ -8263,6 +8848,13 @@ namespace dxvk {
   }
 
 
+  uint64_t D3D9DeviceEx::GetCurrentFlushChunkId() {
+    return (m_csChunk->empty() && !m_csChunkPartial)
+      ? m_csFlushChunkId
+      : m_csFlushChunkId + 1;
+  }
+
+
   void* D3D9DeviceEx::MapTexture(D3D9CommonTexture* pTexture, UINT Subresource) {
     // Will only be called inside the device lock
     void *ptr = pTexture->GetData(Subresource);
@@ -25,10 +25,13 @@
 #include "d3d9_sampler.h"
 #include "d3d9_fixed_function.h"
 #include "d3d9_swvp_emu.h"
+#include "d3d9_swvp_cpu.h"
 
 #include "d3d9_spec_constants.h"
 #include "d3d9_interop.h"
 #include "d3d9_on_12.h"
+#include "d3d9_vr_timing.h"
+#include "d3d9_shader_patch_cache.h"
 
 #include <cstdint>
 #include <unordered_set>
@@ -77,6 +80,7 @@ namespace dxvk {
 
     DirtyFFVertexData,
     DirtyFFVertexBlend,
+    DirtyFFViewData,
     DirtyFFVertexShader,
     DirtyFFPixelShader,
     DirtyFFViewport,
@@ -113,10 +117,48 @@ namespace dxvk {
   struct D3D9StagingBufferMarkerPayload {
     uint64_t        sequenceNumber;
     VkDeviceSize    allocated;
+    VkDeviceSize    upAllocated;
   };
 
   using D3D9StagingBufferMarker = DxvkMarker<D3D9StagingBufferMarkerPayload>;
 
+  struct D3D9ImportedImageKey {
+    VkImage         image;
+    VkFormat        format;
+    VkExtent3D      extent;
+  };
+
+  struct D3D9ImportedImageKeyHash {
+    size_t operator () (const D3D9ImportedImageKey& key) const {
+      DxvkHashState state;
+      state.add(std::hash<VkImage>()(key.image));
+      state.add(uint32_t(key.format));
+      state.add(key.extent.width);
+      state.add(key.extent.height);
+      state.add(key.extent.depth);
+      return state;
+    }
+  };
+
+  struct D3D9ImportedImageKeyEq {
+    bool operator () (const D3D9ImportedImageKey& a, const D3D9ImportedImageKey& b) const {
+      return a.image  == b.image
+          && a.format == b.format
+          && a.extent == b.extent;
+    }
+  };
+
+  struct D3D9ImportedImageStats {
+    uint64_t        hits   = 0;
+    uint64_t        misses = 0;
+  };
+
+  struct D3D9UPBufferStats {
+    VkDeviceSize    bufferSize    = 0;
+    VkDeviceSize    bytesPerFrame = 0;
+    uint32_t        wrapsPerFrame = 0;
+  };
+
   class D3D9DeviceEx final : public ComObjectClamp<IDirect3DDevice9Ex> {
     constexpr static uint32_t DefaultFrameLatency = 3;
     constexpr static uint32_t MaxFrameLatency     = 20;
@@ -127,8 +169,18 @@ namespace dxvk {
 
     constexpr static uint32_t NullStreamIdx = caps::MaxStreams;
 
+    constexpr static uint32_t MaxCachedSamplers = 2048;
+
     constexpr static VkDeviceSize StagingBufferSize = 4ull << 20;
 
+    constexpr static VkDeviceSize MinUPBufferSize = 4ull << 20;
+    constexpr static VkDeviceSize MaxUPBufferSize = env::is32BitHostPlatform()
+      ? 32ull << 20
+      : 128ull << 20;
+
+    constexpr static size_t   MinEarlyCsDispatchSize = DxvkCsChunk::DefaultBlockSize / 4;
+    constexpr static uint64_t LargeCsChunkLag        = 8;
+
     friend class D3D9SwapChainEx;
     friend struct D3D9WindowContext;
     friend class D3D9ConstantBuffer;
@@ -670,6 +722,8 @@ namespace dxvk {
 
     HRESULT SetStateTransform(uint32_t idx, const D3DMATRIX* pMatrix);
 
+    void SetTransformDirty(uint32_t idx);
+
     HRESULT SetStateTextureStageState(
             DWORD                      Stage,
             D3D9TextureStageStateTypes Type,
@@ -745,6 +799,35 @@ namespace dxvk {
         D3D9CommonTexture* pSrcTexture,
         Rc<DxvkImage> dstImage);
 
+    /**
+     * \brief Looks up or creates a wrapper for an external image
+     *
+     * Wrappers are cached per image handle, format and extent,
+     * so that copies into the same set of external images do
+     * not create new image objects every frame.
+     */
+    Rc<DxvkImage> GetImportedImage(
+            VkImage     Image,
+            VkFormat    Format,
+            VkExtent3D  Extent);
+
+    /**
+     * \brief Drops cached external image wrappers
+     *
+     * Must be called when external images get destroyed,
+     * since their handles may be reused afterwards.
+     * \param [in] Image Image to drop, or \c VK_NULL_HANDLE for all
+     */
+    void InvalidateImportedImages(VkImage Image);
+
+    D3D9ImportedImageStats GetImportedImageStats() const {
+      return m_importedImageStats;
+    }
+
+    D3D9UPBufferStats GetUPBufferStats() const {
+      return m_upBufferStats;
+    }
+
     HRESULT StretchRectInternal(
 		  D3D9Surface*         src,
     const RECT*                pSourceRect,
@@ -753,6 +836,18 @@ namespace dxvk {
           D3DTEXTUREFILTERTYPE Filter,
           UINT                 srcLayer);
 
+    /**
+     * \brief Copies each layer of a surface into its own surface
+     *
+     * Emits all copies or resolves in a single CS command if
+     * every layer can be copied without conversion, and falls
+     * back to one \c StretchRect per layer otherwise.
+     */
+    HRESULT CopySurfaceLayers(
+            D3D9Surface*         src,
+            D3D9Surface* const*  dsts,
+            UINT                 layerCount);
+
     void UpdateTextureFromBuffer(
             D3D9CommonTexture*      pDestTexture,
             D3D9CommonTexture*      pSrcTexture,
@@ -778,6 +873,24 @@ namespace dxvk {
     HRESULT UnlockBuffer(
             D3D9CommonBuffer*       pResource);
 
+    /**
+     * \brief Runs ProcessVertices on the CPU
+     *
+     * \param [in] SrcStartIndex First source vertex
+     * \param [in] DestIndex First destination vertex
+     * \param [in] VertexCount Number of vertices
+     * \param [in] pDestBuffer Destination buffer
+     * \param [in] pVertexDecl Output vertex declaration
+     * \returns \c false if the current state is not
+     *    supported and the GPU path must be used
+     */
+    bool ProcessVerticesCpu(
+            UINT                    SrcStartIndex,
+            UINT                    DestIndex,
+            UINT                    VertexCount,
+            D3D9CommonBuffer*       pDestBuffer,
+            D3D9VertexDecl*         pVertexDecl);
+
     /**
      * @brief Uploads data from D3DPOOL_SYSMEM + D3DUSAGE_DYNAMIC buffers and binds the temporary buffers.
      * 
@@ -807,6 +920,15 @@ namespace dxvk {
     void Flush();
     void FlushAndSync9On12();
 
+    /**
+     * \brief Signals a fence once all prior work completes
+     *
+     * Flushes the command list without synchronizing with
+     * the CS thread. The fence is signaled on the GPU when
+     * the submission containing all previous work finishes.
+     */
+    void SignalFence(const Rc<DxvkFence>& Fence, uint64_t Value);
+
     void EndFrame();
 
     void UpdateBoundRTs(uint32_t index);
@@ -924,7 +1046,8 @@ namespace dxvk {
     D3D9DrawInfo GenerateDrawInfo(
       D3DPRIMITIVETYPE PrimitiveType,
       UINT             PrimitiveCount,
-      UINT             InstanceCount);
+      UINT             InstanceCount,
+      UINT             ViewCount);
     
     uint32_t GetInstanceCount() const;
 
@@ -952,6 +1075,13 @@ namespace dxvk {
       return &m_d3d9Options;
     }
 
+    /**
+     * \brief Checks whether state changes go to a state block
+     */
+    bool IsRecordingState() {
+      return ShouldRecord();
+    }
+
     Direct3DState9* GetRawState() {
       return &m_state;
     }
@@ -1056,38 +1186,149 @@ namespace dxvk {
 
     HRESULT CreateRenderTargetFromDesc(D3D9_COMMON_TEXTURE_DESC* pDesc, IDirect3DSurface9** ppSurface, HANDLE* pSharedHandle);
 
+    HRESULT CreateRenderTargetFromVkImage(D3D9_COMMON_TEXTURE_DESC* pDesc, const D3D9_COMMON_TEXTURE_IMPORT_INFO* pImport, IDirect3DSurface9** ppSurface);
+
     DxvkCsChunkRef AllocCsChunk() {
-      DxvkCsChunk* chunk = m_csChunkPool.allocChunk(DxvkCsChunkFlag::SingleUse);
+      DxvkCsChunk* chunk = m_csChunkPool.allocChunk(DxvkCsChunkFlag::SingleUse, m_csChunkSize);
       return DxvkCsChunkRef(chunk, &m_csChunkPool);
     }
 
-    bool MultiViewFF() const { return m_multiViewFF; }
-    void SetMultiViewFF(bool enabled) {
-      m_multiViewFF = enabled;
+    uint32_t ViewCountFF() const { return m_viewCountFF; }
+
+    /**
+     * \brief Number of views rendered by fixed-function shaders
+     *
+     * Instanced views take precedence over the view count set
+     * with \ref SetViewCountFF, which is kept as is so that it
+     * applies again once instanced views get disabled.
+     */
+    uint32_t ActiveViewCountFF() const {
+      return m_instancedViewCount > 1 ? m_instancedViewCount : m_viewCountFF;
+    }
+
+    void SetViewCountFF(uint32_t viewCount) {
+      m_viewCountFF = std::clamp(viewCount, 1u, caps::MaxViewCount);
       m_flags.set(D3D9DeviceFlag::DirtyFFVertexShader);
+      m_flags.set(D3D9DeviceFlag::DirtyFFViewData);
     }
 
+    /**
+     * \brief Sets per-view fixed-function transforms
+     *
+     * Overrides the view and projection matrices used by
+     * fixed-function vertex shaders for the given views.
+     * Passing \c nullptr for either array makes these views
+     * use \c D3DTS_VIEW or \c D3DTS_PROJECTION again. Only
+     * the small per-view constant buffer gets updated.
+     * \param [in] FirstView First view to update
+     * \param [in] ViewCount Number of views to update
+     * \param [in] pViews View matrices, may be \c nullptr
+     * \param [in] pProjections Projection matrices, may be \c nullptr
+     */
+    void SetViewTransformsFF(
+            uint32_t    FirstView,
+            uint32_t    ViewCount,
+      const D3DMATRIX*  pViews,
+      const D3DMATRIX*  pProjections);
+
+    uint32_t InstancedViewCount() const { return m_instancedViewCount; }
+
+    /**
+     * \brief Sets the number of instanced views
+     *
+     * With more than one view, draws are replicated into one instance
+     * per view, and vertex shaders derive the view index from the
+     * instance index and export it as the viewport index. This is an
+     * alternative to native multiview for devices where it is slow or
+     * not supported. Programmable vertex shaders need to be created
+     * with an instanced multiview layout to support this.
+     */
+    void SetInstancedViewCount(uint32_t viewCount) {
+      m_instancedViewCount = std::clamp(viewCount, 1u, caps::MaxViewCount);
+      m_multiViewVS.instanced = m_instancedViewCount > 1;
+      m_flags.set(D3D9DeviceFlag::DirtyFFVertexShader);
+      m_flags.set(D3D9DeviceFlag::DirtyFFViewData);
+      m_flags.set(D3D9DeviceFlag::DirtyViewportScissor);
+    }
+
+    uint32_t ViewMask() const { return m_viewMask; }
+
+    /**
+     * \brief Sets the native multiview view mask
+     *
+     * Draws render one view per set bit into the corresponding
+     * layer of the bound render targets. The mask is ignored
+     * while any bound attachment has too few layers.
+     */
+    void SetViewMask(uint32_t viewMask) {
+      m_viewMask = viewMask;
+      m_flags.set(D3D9DeviceFlag::DirtyFramebuffer);
+    }
+
+    const DxsoMultiViewInfo& MultiViewVS() const { return m_multiViewVS; }
+    void SetMultiViewVS(const DxsoMultiViewInfo& info) {
+      m_multiViewVS = info;
+      m_multiViewVS.instanced = m_instancedViewCount > 1;
+      m_flags.set(D3D9DeviceFlag::DirtyProgVertexShader);
+    }
+
+    /**
+     * \brief Rebinds the programmable vertex shader on the next draw
+     *
+     * Needed when the shader objects of a vertex shader get
+     * replaced, e.g. after patching its code externally.
+     */
+    void MarkVertexShaderDirty() {
+      m_flags.set(D3D9DeviceFlag::DirtyProgVertexShader);
+    }
+
+    D3D9VRFrameTimings& GetVRFrameTimings() { return m_vrTimings; }
+
+    D3D9ShaderPatchCache& GetShaderPatchCache() { return m_shaderPatchCache; }
+
+    /**
+     * \brief Number of CS chunks not yet executed by the CS thread
+     */
+    uint64_t GetCsSequenceLag() const {
+      return m_csSeqNum - m_csThread.lastSequenceNumber();
+    }
+
+    void WriteTimestamp(const Rc<DxvkGpuQuery>& Query);
+
   private:
 
     template<bool AllowFlush = true, typename Cmd>
     void EmitCs(Cmd&& command) {
       if (unlikely(!m_csChunk->push(command))) {
-        EmitCsChunk(std::move(m_csChunk));
-        m_csChunk = AllocCsChunk();
+        DispatchFullCsChunk();
 
         if constexpr (AllowFlush)
           ConsiderFlush(GpuFlushType::ImplicitWeakHint);
 
         m_csChunk->push(command);
+      } else if (unlikely(m_csChunk->usedSize() >= m_csEarlyDispatchSize)) {
+        ConsiderEarlyCsDispatch();
       }
     }
 
     void EmitCsChunk(DxvkCsChunkRef&& chunk);
 
+    void DispatchFullCsChunk();
+
+    void ConsiderEarlyCsDispatch();
+
     void FlushCsChunk() {
       if (likely(!m_csChunk->empty())) {
         EmitCsChunk(std::move(m_csChunk));
         m_csChunk = AllocCsChunk();
+        m_csChunkPartial = true;
+      }
+
+      // Everything dispatched since the last full chunk
+      // counts as one chunk for the flush heuristics
+      if (m_csChunkPartial) {
+        m_csFlushChunkId += 1;
+        m_csChunkPartial = false;
       }
     }
 
@@ -1103,6 +1344,10 @@ namespace dxvk {
 
     D3D9BufferSlice AllocUPBuffer(VkDeviceSize size);
 
+    void CreateUPBuffer(VkDeviceSize size);
+
+    void WaitUPBuffer(VkDeviceSize required);
+
     D3D9BufferSlice AllocStagingBuffer(VkDeviceSize size);
 
     void EmitStagingBufferMarker();
@@ -1185,6 +1430,15 @@ namespace dxvk {
         const T*    pConstantData,
               UINT  Count);
 
+    template <
+      DxsoProgramType  ProgramType,
+      D3D9ConstantType ConstantType,
+      typename         T>
+      bool HasConstantChanged(
+              UINT  StartRegister,
+        const T*    pConstantData,
+              UINT  Count);
+
     template <
       DxsoProgramType  ProgramType,
       D3D9ConstantType ConstantType,
@@ -1246,6 +1500,8 @@ namespace dxvk {
 
     void UpdateFixedFunctionVS();
 
+    void UpdateDrawViewCount();
+
     void UpdateFixedFunctionPS();
 
     void ApplyPrimitiveType(
@@ -1281,6 +1537,8 @@ namespace dxvk {
 
     uint64_t GetCurrentSequenceNumber();
 
+    uint64_t GetCurrentFlushChunkId();
+
     /**
      * @brief Get the swapchain that was used the most recently for presenting
      * Has to be externally synchronized.
@@ -1331,6 +1589,7 @@ namespace dxvk {
 
     D3D9FFShaderModuleSet           m_ffModules;
     D3D9SWVPEmulator                m_swvpEmulator;
+    D3D9SWVPProcessor               m_swvpProcessor;
 
     Com<D3D9StateBlock, false>      m_recorder;
 
@@ -1339,14 +1598,28 @@ namespace dxvk {
     D3D9ConstantBuffer              m_vsClipPlanes;
 
     D3D9ConstantBuffer              m_vsFixedFunction;
+    D3D9ConstantBuffer              m_vsFixedFunctionViews;
     D3D9ConstantBuffer              m_vsVertexBlend;
     D3D9ConstantBuffer              m_psFixedFunction;
     D3D9ConstantBuffer              m_psShared;
     D3D9ConstantBuffer              m_specBuffer;
 
+    // UP data is written to a ring buffer. All positions below are
+    // monotonic byte counts rather than offsets into the buffer, the
+    // buffer offset of a position is relative to m_upBufferBase.
     Rc<DxvkBuffer>                  m_upBuffer;
-    VkDeviceSize                    m_upBufferOffset  = 0ull;
-    void*                           m_upBufferMapPtr  = nullptr;
+    void*                           m_upBufferMapPtr      = nullptr;
+    VkDeviceSize                    m_upBufferSize        = 0ull;
+    VkDeviceSize                    m_upBufferTargetSize  = MinUPBufferSize;
+    VkDeviceSize                    m_upBufferBase        = 0ull;
+    VkDeviceSize                    m_upBufferStart       = 0ull;
+    VkDeviceSize                    m_upAllocated         = 0ull;
+    VkDeviceSize                    m_upLastAllocated     = 0ull;
+    VkDeviceSize                    m_upLastSignaled      = 0ull;
+    VkDeviceSize                    m_upRequired          = 0ull;
+    VkDeviceSize                    m_upFrameStart        = 0ull;
+    uint32_t                        m_upFrameWraps        = 0u;
+    D3D9UPBufferStats               m_upBufferStats;
 
     DxvkStagingBuffer               m_stagingBuffer;
     VkDeviceSize                    m_stagingBufferAllocated      = 0ull;
@@ -1363,11 +1636,15 @@ namespace dxvk {
     const D3D9Options               m_d3d9Options;
     DxsoOptions                     m_dxsoOptions;
 
+    D3D9SamplerCache                m_samplers;
+
     std::unordered_map<
-      D3D9SamplerKey,
-      Rc<DxvkSampler>,
-      D3D9SamplerKeyHash,
-      D3D9SamplerKeyEq>             m_samplers;
+      D3D9ImportedImageKey,
+      Rc<DxvkImage>,
+      D3D9ImportedImageKeyHash,
+      D3D9ImportedImageKeyEq>       m_importedImages;
+
+    D3D9ImportedImageStats          m_importedImageStats;
 
     std::unordered_map<
       DWORD,
@@ -1460,9 +1737,16 @@ namespace dxvk {
 
     DxvkCsChunkPool                 m_csChunkPool;
     DxvkCsThread                    m_csThread;
+    size_t                          m_csChunkSize = DxvkCsChunk::DefaultBlockSize;
+    size_t                          m_csEarlyDispatchSize = ~size_t(0);
     DxvkCsChunkRef                  m_csChunk;
     uint64_t                        m_csSeqNum = 0ull;
 
+    // Chunk count used for flush heuristics. Early dispatches do not
+    // count, so that they do not affect how often we submit to the GPU.
+    uint64_t                        m_csFlushChunkId = 0ull;
+    bool                            m_csChunkPartial = false;
+
     Rc<sync::Fence>                 m_submissionFence;
     uint64_t                        m_submissionId = 0ull;
     DxvkSubmitStatus                m_submitStatus;
@@ -1490,7 +1774,17 @@ namespace dxvk {
     D3D9VkInteropDevice             m_d3d9Interop;
     D3D9On12                        m_d3d9On12;
     DxvkD3D8Bridge                  m_d3d8Bridge;
-    bool                            m_multiViewFF;
+    uint32_t                        m_viewCountFF;
+    std::array<Matrix4, caps::MaxViewCount> m_viewTransformsFF;
+    std::array<Matrix4, caps::MaxViewCount> m_projTransformsFF;
+    uint32_t                        m_viewTransformMaskFF = 0;
+    uint32_t                        m_projTransformMaskFF = 0;
+    DxsoMultiViewInfo               m_multiViewVS;
+    uint32_t                        m_instancedViewCount;
+    uint32_t                        m_drawViewCount;
+    uint32_t                        m_viewMask;
+    D3D9VRFrameTimings              m_vrTimings;
+    D3D9ShaderPatchCache            m_shaderPatchCache;
   };
 
 }
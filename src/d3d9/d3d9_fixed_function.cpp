@@ -595,16 +595,9 @@ namespace dxvk {
 
 
   enum class D3D9FFVSMembers {
-    WorldViewMatrix,
-    NormalMatrix,
-    InverseViewMatrix,
-    ProjMatrix,
+    WorldMatrix,
+    InverseWorldMatrix,
 
-    WorldViewMatrix2,
-    NormalMatrix2,
-    InverseViewMatrix2,
-    ProjMatrix2,
-      
     Texcoord0,
     Texcoord1,
     Texcoord2,
@@ -639,14 +632,25 @@ namespace dxvk {
     MemberCount
   };
 
+  enum class D3D9FFVSViewMembers {
+    ViewMatrix,
+    InverseViewMatrix,
+    ProjMatrix,
+
+    MemberCount
+  };
+
   struct D3D9FFVertexData {
     uint32_t constantBuffer;
+    uint32_t viewBuffer;
     uint32_t vertexBlendData;
     uint32_t lightType;
+    uint32_t viewType;
 
     struct {
-      uint32_t worldview;
-      uint32_t normal;
+      uint32_t world;
+      uint32_t inverseWorld;
+      uint32_t view;
       uint32_t inverseView;
       uint32_t proj;
 
@@ -729,14 +733,12 @@ namespace dxvk {
             Rc<DxvkDevice>           Device,
       const D3D9FFShaderKeyVS&       Key,
       const std::string&             Name,
-            bool                     MultiViewFF,
             D3D9FixedFunctionOptions Options);
 
     D3D9FFShaderCompiler(
             Rc<DxvkDevice>           Device,
       const D3D9FFShaderKeyFS&       Key,
       const std::string&             Name,
-            bool                     MultiViewFF,
             D3D9FixedFunctionOptions Options);
 
     Rc<DxvkShader> compile();
@@ -755,6 +757,10 @@ namespace dxvk {
 
     void emitLightTypeDecl();
 
+    void emitViewTypeDecl();
+
+    void emitViewBufferDecl();
+
     void emitBaseBufferDecl();
 
     void emitVertexBlendDecl();
@@ -773,6 +779,7 @@ namespace dxvk {
 
     uint32_t emitMatrixTimesVector(uint32_t rowCount, uint32_t colCount, uint32_t matrix, uint32_t vector);
     uint32_t emitVectorTimesMatrix(uint32_t rowCount, uint32_t colCount, uint32_t vector, uint32_t matrix);
+    uint32_t emitMatrix3(uint32_t matrix);
 
     bool isVS() { return m_programType == DxsoProgramType::VertexShader; }
     bool isPS() { return !isVS(); }
@@ -783,8 +790,6 @@ namespace dxvk {
     std::vector
       <DxvkBindingInfo>   m_bindings;
 
-    bool                  m_multiViewFF;
-
     uint32_t              m_inputMask = 0u;
     uint32_t              m_outputMask = 0u;
     uint32_t              m_flatShadingMask = 0u;
@@ -823,9 +828,8 @@ namespace dxvk {
           Rc<DxvkDevice>           Device,
     const D3D9FFShaderKeyVS&       Key,
     const std::string&             Name,
-          bool                     MultiViewFF,
           D3D9FixedFunctionOptions Options)
-  : m_module(spvVersion(1, 3)), m_multiViewFF(MultiViewFF), m_options(Options) {
+  : m_module(spvVersion(1, 3)), m_options(Options) {
     m_programType = DxsoProgramTypes::VertexShader;
     m_vsKey    = Key;
     m_filename = Name;
@@ -836,9 +840,8 @@ namespace dxvk {
           Rc<DxvkDevice>           Device,
     const D3D9FFShaderKeyFS&       Key,
     const std::string&             Name,
-          bool                     MultiViewFF,
           D3D9FixedFunctionOptions Options)
-  : m_module(spvVersion(1, 3)), m_multiViewFF(MultiViewFF), m_options(Options) {
+  : m_module(spvVersion(1, 3)), m_options(Options) {
     m_programType = DxsoProgramTypes::PixelShader;
     m_fsKey    = Key;
     m_filename = Name;
@@ -1008,20 +1011,13 @@ namespace dxvk {
           else
             arrayIndices = { m_module.constu32(0), m_module.constu32(i) };
 
-          uint32_t worldview = m_module.opLoad(m_mat4Type,
+          uint32_t world = m_module.opLoad(m_mat4Type,
             m_module.opAccessChain(
               m_module.defPointerType(m_mat4Type, spv::StorageClassUniform), m_vs.vertexBlendData, arrayIndices.size(), arrayIndices.data()));
 
-          uint32_t nrmMtx = worldview;
+          uint32_t nrmMtx = emitMatrix3(world);
 
-          std::array<uint32_t, 3> mtxIndices;
-          for (uint32_t i = 0; i < 3; i++) {
-            mtxIndices[i] = m_module.opCompositeExtract(m_vec4Type, nrmMtx, 1, &i);
-            mtxIndices[i] = m_module.opVectorShuffle(m_vec3Type, mtxIndices[i], mtxIndices[i], 3, indices.data());
-          }
-          nrmMtx = m_module.opCompositeConstruct(m_mat3Type, mtxIndices.size(), mtxIndices.data());
-
-          uint32_t vtxResult = emitVectorTimesMatrix(4, 4, vtx, worldview);
+          uint32_t vtxResult = emitVectorTimesMatrix(4, 4, vtx, world);
           uint32_t nrmResult = m_module.opVectorTimesMatrix(m_vec3Type, normal, nrmMtx);
 
           uint32_t weight;
@@ -1047,22 +1043,19 @@ namespace dxvk {
           m_module.decorate(vtxSum, spv::DecorationNoContraction);
         }
 
-        vtx    = vtxSum;
-        normal = nrmSum;
+        // Blend matrices are in world space, the per-view
+        // view matrix gets applied to the blended result
+        vtx    = emitVectorTimesMatrix(4, 4, vtxSum, m_vs.constants.view);
+        normal = m_module.opVectorTimesMatrix(m_vec3Type, nrmSum, emitMatrix3(m_vs.constants.view));
       }
       else {
-        vtx = emitVectorTimesMatrix(4, 4, vtx, m_vs.constants.worldview);
-
-        uint32_t nrmMtx = m_vs.constants.normal;
+        vtx = emitVectorTimesMatrix(4, 4, vtx, m_vs.constants.world);
+        vtx = emitVectorTimesMatrix(4, 4, vtx, m_vs.constants.view);
 
-        std::array<uint32_t, 3> mtxIndices;
-        for (uint32_t i = 0; i < 3; i++) {
-          mtxIndices[i] = m_module.opCompositeExtract(m_vec4Type, nrmMtx, 1, &i);
-          mtxIndices[i] = m_module.opVectorShuffle(m_vec3Type, mtxIndices[i], mtxIndices[i], 3, indices.data());
-        }
-        nrmMtx = m_module.opCompositeConstruct(m_mat3Type, mtxIndices.size(), mtxIndices.data());
-
-        normal = m_module.opMatrixTimesVector(m_vec3Type, nrmMtx, normal);
+        // The normal matrix is the inverse of the world-view matrix,
+        // i.e. the inverse view matrix times the inverse world matrix
+        normal = m_module.opMatrixTimesVector(m_vec3Type, emitMatrix3(m_vs.constants.inverseWorld), normal);
+        normal = m_module.opMatrixTimesVector(m_vec3Type, emitMatrix3(m_vs.constants.inverseView), normal);
       }
 
       // Some games rely no normals not being normal.
@@ -1297,9 +1290,14 @@ namespace dxvk {
 
         uint32_t isDirectional3 = m_module.opCompositeConstruct(bool3_t, members.size(), members.data());
 
+        // Lights are in world space, move them to the view space of the current view
+                 position  = emitVectorTimesMatrix(4, 4, position, m_vs.constants.view);
+
         uint32_t vtx3      = m_module.opVectorShuffle(m_vec3Type, vtx, vtx, 3, indices.data());
                  position  = m_module.opVectorShuffle(m_vec3Type, position, position, 3, indices.data());
                  direction = m_module.opVectorShuffle(m_vec3Type, direction, direction, 3, indices.data());
+                 direction = m_module.opVectorTimesMatrix(m_vec3Type, direction, emitMatrix3(m_vs.constants.view));
+                 direction = m_module.opNormalize(m_vec3Type, direction);
 
         uint32_t delta  = m_module.opFSub(m_vec3Type, position, vtx3);
         uint32_t d      = m_module.opLength(m_floatType, delta);
@@ -1484,18 +1482,73 @@ namespace dxvk {
   }
 
 
-  void D3D9FFShaderCompiler::emitBaseBufferDecl() {
-    // Constant Buffer for VS.
-    std::array<uint32_t, uint32_t(D3D9FFVSMembers::MemberCount)> members = {
-      m_mat4Type, // World
+  void D3D9FFShaderCompiler::emitViewTypeDecl() {
+    std::array<uint32_t, uint32_t(D3D9FFVSViewMembers::MemberCount)> view_members = {
       m_mat4Type, // View
       m_mat4Type, // InverseView
       m_mat4Type, // Proj
+    };
+
+    m_vs.viewType =
+      m_module.defStructTypeUnique(view_members.size(), view_members.data());
+
+    m_module.setDebugName(m_vs.viewType, "view_t");
+
+    for (uint32_t i = 0; i < view_members.size(); i++) {
+      m_module.memberDecorateOffset(m_vs.viewType, i, i * sizeof(Matrix4));
+      m_module.memberDecorateMatrixStride(m_vs.viewType, i, 16);
+      m_module.memberDecorate(m_vs.viewType, i, spv::DecorationRowMajor);
+    }
+
+    m_module.setDebugMemberName(m_vs.viewType, 0, "View");
+    m_module.setDebugMemberName(m_vs.viewType, 1, "InverseView");
+    m_module.setDebugMemberName(m_vs.viewType, 2, "Projection");
+  }
 
-      m_mat4Type, // World2
-      m_mat4Type, // View2
-      m_mat4Type, // InverseView2
-      m_mat4Type, // Proj2
+
+  void D3D9FFShaderCompiler::emitViewBufferDecl() {
+    // Per-view transforms, indexed by the view index. These live in their
+    // own buffer so that view updates do not touch the main constants.
+    const uint32_t viewArrayType = m_module.defArrayTypeUnique(
+      m_vs.viewType, m_module.constu32(caps::MaxViewCount));
+    m_module.decorateArrayStride(viewArrayType, sizeof(D3D9FixedFunctionView));
+
+    const uint32_t structType =
+      m_module.defStructTypeUnique(1, &viewArrayType);
+
+    m_module.decorateBlock(structType);
+    m_module.memberDecorateOffset(structType, 0, 0);
+
+    m_module.setDebugName(structType, "D3D9FixedFunctionViews");
+    m_module.setDebugMemberName(structType, 0, "Views");
+
+    m_vs.viewBuffer = m_module.newVar(
+      m_module.defPointerType(structType, spv::StorageClassUniform),
+      spv::StorageClassUniform);
+
+    m_module.setDebugName(m_vs.viewBuffer, "views");
+
+    const uint32_t bindingId = computeResourceSlotId(
+      DxsoProgramType::VertexShader, DxsoBindingType::ConstantBuffer,
+      DxsoConstantBuffers::VSFixedFunctionViews);
+
+    m_module.decorateDescriptorSet(m_vs.viewBuffer, 0);
+    m_module.decorateBinding(m_vs.viewBuffer, bindingId);
+
+    DxvkBindingInfo binding = { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER };
+    binding.resourceBinding = bindingId;
+    binding.viewType        = VK_IMAGE_VIEW_TYPE_MAX_ENUM;
+    binding.access          = VK_ACCESS_UNIFORM_READ_BIT;
+    binding.uboSet          = VK_TRUE;
+    m_bindings.push_back(binding);
+  }
+
+
+  void D3D9FFShaderCompiler::emitBaseBufferDecl() {
+    // Constant Buffer for VS.
+    std::array<uint32_t, uint32_t(D3D9FFVSMembers::MemberCount)> members = {
+      m_mat4Type, // World
+      m_mat4Type, // InverseWorld
 
       m_mat4Type, // Texture0
       m_mat4Type, // Texture1
@@ -1536,7 +1589,7 @@ namespace dxvk {
 
     uint32_t offset = 0;
 
-    for (uint32_t i = 0; i < uint32_t(D3D9FFVSMembers::InverseOffset); i++) {
+    for (uint32_t i = uint32_t(D3D9FFVSMembers::WorldMatrix); i < uint32_t(D3D9FFVSMembers::InverseOffset); i++) {
       m_module.memberDecorateOffset(structType, i, offset);
       offset += sizeof(Matrix4);
       m_module.memberDecorateMatrixStride(structType, i, 16);
@@ -1566,15 +1619,8 @@ namespace dxvk {
 
     m_module.setDebugName(structType, "D3D9FixedFunctionVS");
     uint32_t member = 0;
-    m_module.setDebugMemberName(structType, member++, "WorldView");
-    m_module.setDebugMemberName(structType, member++, "Normal");
-    m_module.setDebugMemberName(structType, member++, "InverseView");
-    m_module.setDebugMemberName(structType, member++, "Projection");
-
-    m_module.setDebugMemberName(structType, member++, "WorldView2");
-    m_module.setDebugMemberName(structType, member++, "Normal2");
-    m_module.setDebugMemberName(structType, member++, "InverseView2");
-    m_module.setDebugMemberName(structType, member++, "Projection2");
+    m_module.setDebugMemberName(structType, member++, "World");
+    m_module.setDebugMemberName(structType, member++, "InverseWorld");
 
     m_module.setDebugMemberName(structType, member++, "TexcoordTransform0");
     m_module.setDebugMemberName(structType, member++, "TexcoordTransform1");
@@ -1643,7 +1689,7 @@ namespace dxvk {
     m_module.memberDecorateOffset(structType, 0, 0);
 
     m_module.setDebugName(structType, "D3D9FF_VertexBlendData");
-    m_module.setDebugMemberName(structType, 0, "WorldViewArray");
+    m_module.setDebugMemberName(structType, 0, "WorldArray");
 
     m_vs.vertexBlendData = m_module.newVar(
       m_module.defPointerType(structType, spv::StorageClassUniform),
@@ -1675,18 +1721,45 @@ namespace dxvk {
 
     // VS Caps
     m_module.enableCapability(spv::CapabilityClipDistance);
-    uint32_t viewIndex;
-    if (m_multiViewFF) {
+
+    // Without multiview, all per-view data is read from the first view
+    uint32_t viewIndex = m_module.constu32(0);
+
+    if (m_vsKey.Data.Contents.ViewCount > 1 && m_vsKey.Data.Contents.InstancedViews) {
+      m_module.enableCapability(spv::CapabilityMultiViewport);
+      m_module.enableExtension("SPV_EXT_shader_viewport_index_layer");
+      m_module.enableCapability(spv::CapabilityShaderViewportIndexLayerEXT);
+
+      uint32_t ptrType = m_module.defPointerType(m_uint32Type, spv::StorageClassInput);
+      uint32_t instanceIndexPtr = m_module.newVar(ptrType, spv::StorageClassInput);
+      m_module.setDebugName(instanceIndexPtr, "InstanceIndex");
+      m_module.decorateBuiltIn(instanceIndexPtr, spv::BuiltInInstanceIndex);
+
+      // Draws are replicated once per view, consecutive
+      // instances render the same vertices for each view
+      viewIndex = m_module.opUMod(m_uint32Type,
+        m_module.opLoad(m_uint32Type, instanceIndexPtr),
+        m_module.constu32(m_vsKey.Data.Contents.ViewCount));
+
+      uint32_t outPtrType = m_module.defPointerType(m_uint32Type, spv::StorageClassOutput);
+      uint32_t viewportIndexPtr = m_module.newVar(outPtrType, spv::StorageClassOutput);
+      m_module.setDebugName(viewportIndexPtr, "o_viewport");
+      m_module.decorateBuiltIn(viewportIndexPtr, spv::BuiltInViewportIndex);
+      m_module.opStore(viewportIndexPtr, viewIndex);
+    } else if (m_vsKey.Data.Contents.ViewCount > 1) {
       m_module.enableCapability(spv::CapabilityMultiView);
-      m_module.enableCapability(spv::CapabilityVariablePointers);
 
-	  uint32_t ptrType = m_module.defPointerType(m_uint32Type, spv::StorageClassInput);
-	  viewIndex = m_module.newVar(ptrType, spv::StorageClassInput);
-	  m_module.setDebugName(viewIndex, "ViewIndex");
-	  m_module.decorateBuiltIn(viewIndex, spv::BuiltInViewIndex);
+      uint32_t ptrType = m_module.defPointerType(m_uint32Type, spv::StorageClassInput);
+      uint32_t viewIndexPtr = m_module.newVar(ptrType, spv::StorageClassInput);
+      m_module.setDebugName(viewIndexPtr, "ViewIndex");
+      m_module.decorateBuiltIn(viewIndexPtr, spv::BuiltInViewIndex);
+
+      viewIndex = m_module.opLoad(m_uint32Type, viewIndexPtr);
     }
 
     emitLightTypeDecl();
+    emitViewTypeDecl();
+    emitViewBufferDecl();
     emitBaseBufferDecl();
 
     if (m_vsKey.Data.Contents.VertexBlendMode == D3D9FF_VertexBlendMode_Normal)
@@ -1698,24 +1771,26 @@ namespace dxvk {
 
       uint32_t typePtr = m_module.defPointerType(type, spv::StorageClassUniform);
 
-      if (m_multiViewFF && idx <= uint32_t(D3D9FFVSMembers::ProjMatrix)) {
-        // Conditionally select the correct matrix
-        // This is probably much slower than accessing with idx+ViewIndex*4 directly, but opAccessChain doesn't dynamically accessing into a structure
-        uint32_t offset2  = m_module.constu32(idx + 4);
-        uint32_t view1Ptr = m_module.opAccessChain(typePtr, m_vs.constantBuffer, 1, &offset);
-        uint32_t view1    = m_module.opLoad(type, view1Ptr);
-        uint32_t view2Ptr = m_module.opAccessChain(typePtr, m_vs.constantBuffer, 1, &offset2);
-        uint32_t view2    = m_module.opLoad(type, view2Ptr);
-        uint32_t cond     = m_module.opIEqual(m_boolType, m_module.opLoad(m_uint32Type, viewIndex), m_module.constu32(0));
-        return m_module.opSelect(type, cond, view1, view2);
-      }
       return m_module.opLoad(type, m_module.opAccessChain(typePtr, m_vs.constantBuffer, 1, &offset));
     };
 
-    m_vs.constants.worldview = LoadConstant(m_mat4Type, uint32_t(D3D9FFVSMembers::WorldViewMatrix));
-    m_vs.constants.normal    = LoadConstant(m_mat4Type, uint32_t(D3D9FFVSMembers::NormalMatrix));
-    m_vs.constants.inverseView = LoadConstant(m_mat4Type, uint32_t(D3D9FFVSMembers::InverseViewMatrix));
-    m_vs.constants.proj      = LoadConstant(m_mat4Type, uint32_t(D3D9FFVSMembers::ProjMatrix));
+    auto LoadViewConstant = [&](uint32_t type, uint32_t idx) {
+      std::array<uint32_t, 3> indices = {
+        m_module.constu32(0),
+        viewIndex,
+        m_module.constu32(idx),
+      };
+
+      uint32_t typePtr = m_module.defPointerType(type, spv::StorageClassUniform);
+
+      return m_module.opLoad(type, m_module.opAccessChain(typePtr, m_vs.viewBuffer, indices.size(), indices.data()));
+    };
+
+    m_vs.constants.world        = LoadConstant(m_mat4Type, uint32_t(D3D9FFVSMembers::WorldMatrix));
+    m_vs.constants.inverseWorld = LoadConstant(m_mat4Type, uint32_t(D3D9FFVSMembers::InverseWorldMatrix));
+    m_vs.constants.view         = LoadViewConstant(m_mat4Type, uint32_t(D3D9FFVSViewMembers::ViewMatrix));
+    m_vs.constants.inverseView  = LoadViewConstant(m_mat4Type, uint32_t(D3D9FFVSViewMembers::InverseViewMatrix));
+    m_vs.constants.proj         = LoadViewConstant(m_mat4Type, uint32_t(D3D9FFVSViewMembers::ProjMatrix));
 
     for (uint32_t i = 0; i < caps::TextureStageCount; i++)
       m_vs.constants.texcoord[i] = LoadConstant(m_mat4Type, uint32_t(D3D9FFVSMembers::Texcoord0) + i);
@@ -2404,7 +2479,7 @@ namespace dxvk {
 
 
   void D3D9FFShaderCompiler::emitVsClipping(uint32_t vtx) {
-    uint32_t worldPos = emitMatrixTimesVector(4, 4, m_vs.constants.inverseView, vtx);
+    uint32_t worldPos = emitVectorTimesMatrix(4, 4, vtx, m_vs.constants.inverseView);
 
     uint32_t clipPlaneCountId = m_module.constu32(caps::MaxClipPlanes);
     
@@ -2526,6 +2601,19 @@ namespace dxvk {
   }
 
 
+  uint32_t D3D9FFShaderCompiler::emitMatrix3(uint32_t matrix) {
+    std::array<uint32_t, 3> indices = { 0, 1, 2 };
+    std::array<uint32_t, 3> columns;
+
+    for (uint32_t i = 0; i < 3; i++) {
+      columns[i] = m_module.opCompositeExtract(m_vec4Type, matrix, 1, &i);
+      columns[i] = m_module.opVectorShuffle(m_vec3Type, columns[i], columns[i], indices.size(), indices.data());
+    }
+
+    return m_module.opCompositeConstruct(m_mat3Type, columns.size(), columns.data());
+  }
+
+
   D3D9FFShader::D3D9FFShader(
           D3D9DeviceEx*         pDevice,
     const D3D9FFShaderKeyVS&    Key) {
@@ -2536,7 +2624,7 @@ namespace dxvk {
 
     D3D9FFShaderCompiler compiler(
       pDevice->GetDXVKDevice(),
-      Key, name, pDevice->MultiViewFF(),
+      Key, name,
       pDevice->GetOptions());
 
     m_shader = compiler.compile();
@@ -2559,7 +2647,7 @@ namespace dxvk {
 
     D3D9FFShaderCompiler compiler(
       pDevice->GetDXVKDevice(),
-      Key, name, false,
+      Key, name,
       pDevice->GetOptions());
 
     m_shader = compiler.compile();
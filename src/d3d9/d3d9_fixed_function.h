@@ -135,7 +135,8 @@ namespace dxvk {
 
         uint32_t Projected : 8;
 
-        uint32_t MultiView : 1;
+        uint32_t ViewCount : 3;
+        uint32_t InstancedViews : 1;
       } Contents;
 
       uint32_t Primitive[5];
@@ -166,4 +166,141 @@ namespace dxvk::hud {
     return position;
   }
 
+  HudImportedImageCache::HudImportedImageCache(D3D9DeviceEx* device)
+          : m_device          (device)
+          , m_statsText       ("") {}
+
+
+  void HudImportedImageCache::update(dxvk::high_resolution_clock::time_point time) {
+    D3D9ImportedImageStats stats = m_device->GetImportedImageStats();
+
+    m_statsText = str::format(
+      "Hits: ", stats.hits,
+      " Misses: ", stats.misses
+    );
+  }
+
+
+  HudPos HudImportedImageCache::render(
+          HudRenderer&      renderer,
+          HudPos            position) {
+    position.y += 16.0f;
+
+    renderer.drawText(16.0f,
+      { position.x, position.y },
+      { 0.0f, 1.0f, 0.75f, 1.0f },
+      "VR Images:");
+
+    renderer.drawText(16.0f,
+      { position.x + 155.0f, position.y },
+      { 1.0f, 1.0f, 1.0f, 1.0f },
+      m_statsText);
+
+    position.y += 8.0f;
+    return position;
+  }
+
+  HudUPBuffer::HudUPBuffer(D3D9DeviceEx* device)
+          : m_device          (device)
+          , m_statsText       ("") {}
+
+
+  void HudUPBuffer::update(dxvk::high_resolution_clock::time_point time) {
+    D3D9UPBufferStats stats = m_device->GetUPBufferStats();
+
+    m_statsText = str::format(
+      stats.bytesPerFrame >> 10, " kB/frame, ",
+      stats.wrapsPerFrame, " wraps/frame, ",
+      stats.bufferSize >> 20, " MB"
+    );
+  }
+
+
+  HudPos HudUPBuffer::render(
+          HudRenderer&      renderer,
+          HudPos            position) {
+    position.y += 16.0f;
+
+    renderer.drawText(16.0f,
+      { position.x, position.y },
+      { 0.0f, 1.0f, 0.75f, 1.0f },
+      "UP buffer:");
+
+    renderer.drawText(16.0f,
+      { position.x + 155.0f, position.y },
+      { 1.0f, 1.0f, 1.0f, 1.0f },
+      m_statsText);
+
+    position.y += 8.0f;
+    return position;
+  }
+
+  HudVRFrameTimings::HudVRFrameTimings(D3D9DeviceEx* device)
+          : m_device          (device)
+          , m_waitText        ("")
+          , m_gpuText         ("") {}
+
+
+  void HudVRFrameTimings::update(dxvk::high_resolution_clock::time_point time) {
+    // The most recent frames usually still have their GPU
+    // queries in flight, so show the newest resolved one
+    std::array<D3D9VRFrameTiming, D3D9VRFrameTimings::MaxFrames> frames;
+    uint32_t count = m_device->GetVRFrameTimings().GetFrames(frames.data(), uint32_t(frames.size()));
+
+    if (!count)
+      return;
+
+    const D3D9VRFrameTiming& last = frames[count - 1];
+
+    auto toMs = [] (uint64_t us) {
+      return str::format(us / 1000, ".", (us / 100) % 10);
+    };
+
+    m_waitText = str::format(
+      "CS: ", toMs(last.waitUs[uint32_t(D3D9VRWaitType::CsSync)]),
+      " Submit: ", toMs(last.waitUs[uint32_t(D3D9VRWaitType::Submit)]
+                      + last.waitUs[uint32_t(D3D9VRWaitType::QueueLock)]),
+      " Idle: ", toMs(last.waitUs[uint32_t(D3D9VRWaitType::QueueIdle)]),
+      " Lag: ", last.csSequenceLag);
+
+    for (uint32_t i = count; i; i--) {
+      if (frames[i - 1].gpuCopyMs >= 0.0f) {
+        m_gpuText = str::format(toMs(uint64_t(frames[i - 1].gpuCopyMs * 1000.0f)), " ms");
+        break;
+      }
+    }
+  }
+
+
+  HudPos HudVRFrameTimings::render(
+          HudRenderer&      renderer,
+          HudPos            position) {
+    position.y += 16.0f;
+
+    renderer.drawText(16.0f,
+      { position.x, position.y },
+      { 0.0f, 1.0f, 0.75f, 1.0f },
+      "VR wait (ms):");
+
+    renderer.drawText(16.0f,
+      { position.x + 180.0f, position.y },
+      { 1.0f, 1.0f, 1.0f, 1.0f },
+      m_waitText);
+
+    position.y += 24.0f;
+
+    renderer.drawText(16.0f,
+      { position.x, position.y },
+      { 0.0f, 1.0f, 0.75f, 1.0f },
+      "VR GPU copy:");
+
+    renderer.drawText(16.0f,
+      { position.x + 180.0f, position.y },
+      { 1.0f, 1.0f, 1.0f, 1.0f },
+      m_gpuText);
+
+    position.y += 8.0f;
+    return position;
+  }
+
 }
@@ -104,4 +104,71 @@ namespace dxvk::hud {
 
     };
 
+    /**
+     * \brief HUD item to display external image wrapper cache stats
+     */
+    class HudImportedImageCache : public HudItem {
+    public:
+
+        HudImportedImageCache(D3D9DeviceEx* device);
+
+        void update(dxvk::high_resolution_clock::time_point time);
+
+        HudPos render(
+                HudRenderer&      renderer,
+                HudPos            position);
+
+    private:
+
+        D3D9DeviceEx* m_device;
+
+        std::string m_statsText;
+
+    };
+
+    /**
+     * \brief HUD item to display UP buffer usage
+     */
+    class HudUPBuffer : public HudItem {
+    public:
+
+        HudUPBuffer(D3D9DeviceEx* device);
+
+        void update(dxvk::high_resolution_clock::time_point time);
+
+        HudPos render(
+                HudRenderer&      renderer,
+                HudPos            position);
+
+    private:
+
+        D3D9DeviceEx* m_device;
+
+        std::string m_statsText;
+
+    };
+
+    /**
+     * \brief HUD item to display VR submit timings
+     */
+    class HudVRFrameTimings : public HudItem {
+    public:
+
+        HudVRFrameTimings(D3D9DeviceEx* device);
+
+        void update(dxvk::high_resolution_clock::time_point time);
+
+        HudPos render(
+                HudRenderer&      renderer,
+                HudPos            position);
+
+    private:
+
+        D3D9DeviceEx* m_device;
+
+        std::string m_waitText;
+        std::string m_gpuText;
+
+    };
+
 }
\ No newline at end of file
@@ -154,6 +154,10 @@ namespace dxvk {
     /// Disable counting losable resources and rejecting calls to Reset() if any are still alive
     bool countLosableResources;
 
+    /// Run ProcessVertices on the CPU instead of using
+    /// the GPU stream output path whenever possible
+    bool cpuProcessVertices;
+
     /// Ensure that for the same D3D commands the output VK commands
     /// don't change between runs. Useful for comparative benchmarking,
     /// can negatively affect performance.
@@ -1,5 +1,7 @@
 #include "d3d9_sampler.h"
 
+#include <algorithm>
+
 namespace dxvk {
 
   size_t D3D9SamplerKeyHash::operator () (const D3D9SamplerKey& key) const {
@@ -41,4 +43,121 @@ namespace dxvk {
         && a.Depth          == b.Depth;
   }
 
-}
\ No newline at end of file
+
+
+  D3D9SamplerCache::D3D9SamplerCache() {
+
+  }
+
+
+  D3D9SamplerCache::~D3D9SamplerCache() {
+
+  }
+
+
+  Rc<DxvkSampler> D3D9SamplerCache::Find(const D3D9SamplerKey& Key) {
+    if (unlikely(m_entries.empty()))
+      return nullptr;
+
+    Entry& entry = m_entries[FindSlot(Key)];
+
+    if (entry.sampler == nullptr)
+      return nullptr;
+
+    entry.lastUse = ++m_useId;
+    return entry.sampler;
+  }
+
+
+  void D3D9SamplerCache::Insert(
+    const D3D9SamplerKey&   Key,
+    const Rc<DxvkSampler>&  Sampler) {
+    if (m_count >= m_maxCount)
+      EvictUnused();
+
+    // Keep the load factor at or below one half
+    if (2 * size_t(m_count + 1) > m_entries.size())
+      Rehash(std::max<size_t>(2 * m_entries.size(), 64));
+
+    Entry& entry = m_entries[FindSlot(Key)];
+    entry.key     = Key;
+    entry.sampler = Sampler;
+    entry.lastUse = ++m_useId;
+
+    m_count += 1;
+  }
+
+
+  size_t D3D9SamplerCache::FindSlot(const D3D9SamplerKey& Key) const {
+    D3D9SamplerKeyEq eq;
+
+    size_t mask = m_entries.size() - 1;
+    size_t slot = Key.Hash & mask;
+
+    while (m_entries[slot].sampler != nullptr) {
+      const Entry& entry = m_entries[slot];
+
+      if (entry.key.Hash == Key.Hash && eq(entry.key, Key))
+        break;
+
+      slot = (slot + 1) & mask;
+    }
+
+    return slot;
+  }
+
+
+  void D3D9SamplerCache::Rehash(size_t Capacity) {
+    std::vector<Entry> entries = std::exchange(m_entries, std::vector<Entry>(Capacity));
+
+    for (auto& entry : entries) {
+      if (entry.sampler != nullptr)
+        m_entries[FindSlot(entry.key)] = std::move(entry);
+    }
+  }
+
+
+  void D3D9SamplerCache::EvictUnused() {
+    // Evict down to three quarters of the limit so
+    // that this does not run on every insertion
+    uint32_t targetCount = m_maxCount - m_maxCount / 4;
+
+    std::vector<uint64_t> candidates;
+
+    for (const auto& entry : m_entries) {
+      if (entry.sampler != nullptr && !IsInUse(entry.sampler))
+        candidates.push_back(entry.lastUse);
+    }
+
+    if (candidates.empty() || m_count <= targetCount)
+      return;
+
+    size_t evictCount = std::min<size_t>(m_count - targetCount, candidates.size());
+
+    std::nth_element(candidates.begin(),
+      candidates.begin() + (evictCount - 1), candidates.end());
+
+    uint64_t maxEvictedUse = candidates[evictCount - 1];
+
+    for (auto& entry : m_entries) {
+      if (entry.sampler != nullptr && entry.lastUse <= maxEvictedUse && !IsInUse(entry.sampler)) {
+        entry.sampler = nullptr;
+        m_count -= 1;
+      }
+    }
+
+    // Removing entries breaks probe sequences
+    Rehash(m_entries.size());
+  }
+
+
+  bool D3D9SamplerCache::IsInUse(const Rc<DxvkSampler>& Sampler) {
+    // New references are only ever taken on the CS thread, other
+    // threads can only release them. Anything beyond the reference
+    // held by the cache means that the sampler is still bound to
+    // the context or used by a command list that has not retired.
+    Sampler->incRef();
+    return Sampler->decRef() > 1;
+  }
+
+}
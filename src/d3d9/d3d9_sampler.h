@@ -5,9 +5,12 @@
 #include "d3d9_util.h"
 
 #include "../dxvk/dxvk_hash.h"
+#include "../dxvk/dxvk_sampler.h"
 
 #include "../util/util_math.h"
 
+#include <vector>
+
 namespace dxvk {
 
   struct D3D9SamplerKey {
@@ -22,6 +25,10 @@ namespace dxvk {
     DWORD MaxMipLevel;
     D3DCOLOR BorderColor;
     bool Depth;
+
+    /// Hash of all other members, computed
+    /// by \ref NormalizeSamplerKey
+    size_t Hash;
   };
 
   struct D3D9SamplerKeyHash {
@@ -70,6 +77,91 @@ namespace dxvk {
      && key.AddressW != D3DTADDRESS_BORDER) {
       key.BorderColor = 0;
     }
+
+    key.Hash = D3D9SamplerKeyHash()(key);
   }
 
+
+  /**
+   * \brief Sampler cache
+   *
+   * Open-addressing hash table that maps normalized sampler
+   * keys to samplers, using the hash stored in the key. Once
+   * the number of samplers exceeds the given limit, samplers
+   * that are no longer referenced by any context or pending
+   * command list are evicted, least recently used first.
+   * Not thread-safe, only meant to be used on the CS thread.
+   */
+  class D3D9SamplerCache {
+
+  public:
+
+    D3D9SamplerCache();
+
+    ~D3D9SamplerCache();
+
+    /**
+     * \brief Sets maximum number of cached samplers
+     *
+     * The cache may exceed this if all
+     * samplers are still in use.
+     * \param [in] MaxCount Sampler limit
+     */
+    void SetMaxCount(uint32_t MaxCount) {
+      m_maxCount = MaxCount;
+    }
+
+    /**
+     * \brief Number of cached samplers
+     * \returns Sampler count
+     */
+    uint32_t GetCount() const {
+      return m_count;
+    }
+
+    /**
+     * \brief Looks up sampler
+     *
+     * Marks the sampler as used if found.
+     * \param [in] Key Normalized sampler key
+     * \returns Sampler, or \c nullptr if not cached
+     */
+    Rc<DxvkSampler> Find(const D3D9SamplerKey& Key);
+
+    /**
+     * \brief Adds sampler
+     *
+     * The key must not be in the cache yet. May evict
+     * unused samplers to stay within the limit.
+     * \param [in] Key Normalized sampler key
+     * \param [in] Sampler The sampler
+     */
+    void Insert(
+      const D3D9SamplerKey&   Key,
+      const Rc<DxvkSampler>&  Sampler);
+
+  private:
+
+    struct Entry {
+      D3D9SamplerKey  key;
+      Rc<DxvkSampler> sampler;
+      uint64_t        lastUse;
+    };
+
+    std::vector<Entry>  m_entries;
+
+    uint32_t            m_count    = 0;
+    uint32_t            m_maxCount = ~0u;
+    uint64_t            m_useId    = 0;
+
+    size_t FindSlot(const D3D9SamplerKey& Key) const;
+
+    void Rehash(size_t Capacity);
+
+    void EvictUnused();
+
+    static bool IsInUse(const Rc<DxvkSampler>& Sampler);
+
+  };
+
 }
\ No newline at end of file
@@ -54,7 +54,11 @@ namespace dxvk {
     const D3D9ConstantLayout& constantLayout = ShaderStage == VK_SHADER_STAGE_VERTEX_BIT
       ? pDevice->GetVertexConstantLayout()
       : pDevice->GetPixelConstantLayout();
-    m_shader       = pModule->compile(*pDxsoModuleInfo, name, AnalysisInfo, constantLayout);
+    // The multiview variant, if any, gets compiled separately below
+    DxsoModuleInfo moduleInfo = *pDxsoModuleInfo;
+    moduleInfo.multiView = DxsoMultiViewInfo();
+
+    m_shader       = pModule->compile(moduleInfo, name, AnalysisInfo, constantLayout);
     m_isgn         = pModule->isgn();
     m_usedSamplers = pModule->usedSamplers();
 
@@ -71,6 +75,7 @@ namespace dxvk {
     m_constants = pModule->constants();
     m_maxDefinedConst = pModule->maxDefinedConstant();
 
+    m_key = Key;
     m_shader->setShaderKey(Key);
 
     if (dumpPath.size() != 0) {
@@ -81,7 +86,61 @@ namespace dxvk {
       m_shader->dump(dumpStream);
     }
 
+    // Use externally patched code from a previous run if there is
+    // any, so that the state cache sees the patched shader right away
+    Rc<DxvkShader> patchedShader;
+
+    if (ShaderStage == VK_SHADER_STAGE_VERTEX_BIT)
+      patchedShader = pDevice->GetShaderPatchCache().ApplyCachedPatch(Key, m_shader);
+
+    if (patchedShader != nullptr)
+      m_shader = std::move(patchedShader);
+
     pDevice->GetDXVKDevice()->registerShader(m_shader);
+
+    // Patched code only exists in single-view form, so patched
+    // shaders do not get a multiview variant. See SetPatchedShader.
+    if (ShaderStage == VK_SHADER_STAGE_VERTEX_BIT && pDxsoModuleInfo->multiView.enabled()
+     && !D3D9ShaderPatchCache::IsPatched(Key, m_shader)) {
+      const DxvkShaderKey multiViewKey = GetMultiViewShaderKey(Key, pDxsoModuleInfo->multiView);
+      const std::string multiViewName = multiViewKey.toString();
+
+      m_multiViewShader = pModule->compile(*pDxsoModuleInfo, multiViewName, AnalysisInfo, constantLayout);
+      m_multiViewShader->setShaderKey(multiViewKey);
+
+      if (pDxsoModuleInfo->multiView.instanced)
+        m_instancedViewCount = pDxsoModuleInfo->multiView.viewCount;
+
+      // Both variants share one constant buffer, so make sure
+      // the per-view registers of every view get uploaded.
+      m_meta.maxConstIndexF = std::max(m_meta.maxConstIndexF, pModule->meta().maxConstIndexF);
+
+      if (dumpPath.size() != 0) {
+        std::ofstream dumpStream(
+          str::topath(str::format(dumpPath, "/", multiViewName, ".spv").c_str()).c_str(),
+          std::ios_base::binary | std::ios_base::trunc);
+
+        m_multiViewShader->dump(dumpStream);
+      }
+
+      pDevice->GetDXVKDevice()->registerShader(m_multiViewShader);
+    }
+  }
+
+
+  DxvkShaderKey GetMultiViewShaderKey(
+    const DxvkShaderKey&        Key,
+    const DxsoMultiViewInfo&    MultiView) {
+    const Sha1Hash& hash = Key.sha1();
+
+    std::array<Sha1Data, 2> chunks = {{
+      { &hash,      sizeof(hash)      },
+      { &MultiView, sizeof(MultiView) },
+    }};
+
+    return DxvkShaderKey(
+      VkShaderStageFlagBits(Key.type()),
+      Sha1Hash::compute(chunks.size(), chunks.data()));
   }
 
 
@@ -106,10 +165,17 @@ namespace dxvk {
     DxsoAnalysisInfo info = module.analyze();
     *pLength = info.bytecodeByteLength;
 
-    DxvkShaderKey lookupKey = DxvkShaderKey(
+    DxvkShaderKey shaderKey = DxvkShaderKey(
       ShaderStage,
       Sha1Hash::compute(pShaderBytecode, info.bytecodeByteLength));
 
+    // Shaders with a multiview variant are cached separately,
+    // since the variant depends on the multiview layout
+    DxvkShaderKey lookupKey = ShaderStage == VK_SHADER_STAGE_VERTEX_BIT
+                           && pDxbcModuleInfo->multiView.enabled()
+      ? GetMultiViewShaderKey(shaderKey, pDxbcModuleInfo->multiView)
+      : shaderKey;
+
     // Use the shader's unique key for the lookup
     { std::unique_lock<dxvk::mutex> lock(m_mutex);
       
@@ -123,7 +189,7 @@ namespace dxvk {
     // This shader has not been compiled yet, so we have to create a
     // new module. This takes a while, so we won't lock the structure.
     *pShaderModule = D3D9CommonShader(
-      pDevice, ShaderStage, lookupKey,
+      pDevice, ShaderStage, shaderKey,
       pDxbcModuleInfo, pShaderBytecode,
       info, &module);
     
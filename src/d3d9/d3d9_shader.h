@@ -2,6 +2,7 @@
 
 #include "d3d9_resource.h"
 #include "../dxso/dxso_module.h"
+#include "../dxso/dxso_modinfo.h"
 #include "d3d9_util.h"
 #include "d3d9_mem.h"
 
@@ -37,6 +38,49 @@ namespace dxvk {
       return m_shader;
     }
 
+    /**
+     * \brief Key of the original shader
+     *
+     * Differs from the key of the DXVK shader
+     * if the shader code was patched externally.
+     * \returns Shader key
+     */
+    const DxvkShaderKey& GetShaderKey() const {
+      return m_key;
+    }
+
+    /**
+     * \brief Multiview shader variant
+     *
+     * Only present for vertex shaders that were created
+     * while a multiview constant layout was set on the
+     * device. Reads per-view constants by \c ViewIndex.
+     * \returns Multiview shader, or \c nullptr
+     */
+    Rc<DxvkShader> GetMultiViewShader() const {
+      return m_multiViewShader;
+    }
+
+    Rc<DxvkShader> GetShader(bool MultiView) const {
+      return MultiView && m_multiViewShader != nullptr
+        ? m_multiViewShader
+        : m_shader;
+    }
+
+    /**
+     * \brief Replaces the shader with externally patched code
+     *
+     * Patched code only exists in single-view form and cannot be
+     * turned into a multiview variant, so the multiview variant
+     * gets dropped and multiview draws use the patched shader.
+     * \param [in] Shader Patched shader
+     */
+    void SetPatchedShader(const Rc<DxvkShader>& Shader) {
+      m_shader = Shader;
+      m_multiViewShader = nullptr;
+      m_instancedViewCount = 1;
+    }
+
     std::string GetName() const {
       return m_shader->debugName();
     }
@@ -57,6 +101,16 @@ namespace dxvk {
 
     uint32_t GetMaxDefinedConstant() const { return m_maxDefinedConst; }
 
+    /**
+     * \brief Number of views rendered via instancing
+     *
+     * Greater than one if the multiview variant derives the
+     * view index from the instance index, in which case each
+     * draw must be replicated once per view.
+     * \returns View count
+     */
+    uint32_t GetInstancedViewCount() const { return m_instancedViewCount; }
+
   private:
 
     DxsoIsgn              m_isgn;
@@ -67,8 +121,11 @@ namespace dxvk {
     DxsoShaderMetaInfo    m_meta;
     DxsoDefinedConstants  m_constants;
     uint32_t              m_maxDefinedConst;
+    uint32_t              m_instancedViewCount = 1;
 
+    DxvkShaderKey         m_key;
     Rc<DxvkShader>        m_shader;
+    Rc<DxvkShader>        m_multiViewShader;
 
   };
 
@@ -215,6 +272,17 @@ namespace dxvk {
     
   };
 
+  /**
+   * \brief Computes the key of a multiview shader variant
+   *
+   * \param [in] Key Key of the original shader
+   * \param [in] MultiView Multiview layout of the variant
+   * \returns Key of the multiview variant
+   */
+  DxvkShaderKey GetMultiViewShaderKey(
+    const DxvkShaderKey&        Key,
+    const DxsoMultiViewInfo&    MultiView);
+
   template<typename T>
   const D3D9CommonShader* GetCommonShader(const T& pShader) {
     return pShader != nullptr ? pShader->GetCommonShader() : nullptr;
@@ -0,0 +1,242 @@
+#include "d3d9_shader_patch_cache.h"
+
+#include "../util/util_env.h"
+
+namespace dxvk {
+
+  void D3D9ShaderPatchCache::SetPatchHash(uint64_t PatchHash) {
+    std::lock_guard<dxvk::mutex> lock(m_mutex);
+
+    if (m_enable && m_patchHash == PatchHash)
+      return;
+
+    m_enable    = true;
+    m_patchHash = PatchHash;
+
+    m_entries.clear();
+    ReadCacheFile();
+
+    Logger::info(str::format("D3D9: Loaded ", m_entries.size(), " patched shaders for patch ",
+      std::hex, PatchHash, std::dec));
+  }
+
+
+  Rc<DxvkShader> D3D9ShaderPatchCache::ApplyCachedPatch(
+    const DxvkShaderKey&  Key,
+    const Rc<DxvkShader>& Shader) {
+    std::lock_guard<dxvk::mutex> lock(m_mutex);
+
+    if (!m_enable)
+      return nullptr;
+
+    auto entry = m_entries.find(Key);
+
+    if (entry == m_entries.end())
+      return nullptr;
+
+    return ReplaceCode(Key, Shader, entry->second.data(), entry->second.size());
+  }
+
+
+  Rc<DxvkShader> D3D9ShaderPatchCache::PatchShader(
+    const DxvkShaderKey&  Key,
+    const Rc<DxvkShader>& Shader,
+    const uint32_t*       pCode,
+          uint32_t        CodeSize) {
+    D3D9ShaderPatch patch = { Key, Shader, pCode, CodeSize };
+    PatchShaders(1, &patch);
+    return patch.shader;
+  }
+
+
+  void D3D9ShaderPatchCache::PatchShaders(
+          uint32_t        Count,
+          D3D9ShaderPatch* pPatches) {
+    std::lock_guard<dxvk::mutex> lock(m_mutex);
+
+    std::ofstream file;
+    bool fileOpened = false;
+
+    for (uint32_t i = 0; i < Count; i++) {
+      D3D9ShaderPatch& patch = pPatches[i];
+
+      patch.shader = ReplaceCode(patch.key, patch.shader, patch.code, patch.codeSize);
+
+      if (!m_enable || !NeedsWrite(patch.key, patch.code, patch.codeSize))
+        continue;
+
+      m_entries[patch.key] = std::vector<uint32_t>(patch.code, patch.code + patch.codeSize);
+
+      if (!fileOpened) {
+        file = OpenCacheFileForWrite();
+        fileOpened = true;
+      }
+
+      if (file)
+        WriteCacheEntry(file, patch.key, patch.code, patch.codeSize);
+    }
+  }
+
+
+  bool D3D9ShaderPatchCache::NeedsWrite(
+    const DxvkShaderKey&  Key,
+    const uint32_t*       pCode,
+          uint32_t        CodeSize) const {
+    auto entry = m_entries.find(Key);
+
+    return entry == m_entries.end()
+        || entry->second.size() != CodeSize
+        || std::memcmp(entry->second.data(), pCode, CodeSize * sizeof(uint32_t));
+  }
+
+
+  Rc<DxvkShader> D3D9ShaderPatchCache::ReplaceCode(
+    const DxvkShaderKey&  Key,
+    const Rc<DxvkShader>& Shader,
+    const uint32_t*       pCode,
+          uint32_t        CodeSize) {
+    DxvkShaderCreateInfo info = Shader->info();
+
+    // DXVK shaders copy the binding info into a more clever container,
+    // dig it out here so that it can be passed to the constructor again
+    const DxvkBindingLayout& bindings = Shader->getBindings();
+    std::vector<DxvkBindingInfo> bindingInfos(info.bindingCount);
+
+    for (uint32_t i = 0; i < info.bindingCount; i++)
+      bindingInfos[i] = bindings.getBinding(DxvkDescriptorSets::VsAll, i);
+
+    info.bindings = bindingInfos.data();
+
+    Rc<DxvkShader> patched = new DxvkShader(info, SpirvCodeBuffer(CodeSize, pCode));
+
+    Sha1Hash codeHash = Sha1Hash::compute(pCode, CodeSize * sizeof(uint32_t));
+    patched->setShaderKey(GetPatchedShaderKey(Key, m_patchHash, codeHash));
+    return patched;
+  }
+
+
+  void D3D9ShaderPatchCache::ReadCacheFile() {
+    std::ifstream file(GetCacheFileName().c_str(), std::ios_base::binary);
+    m_fileValid = false;
+
+    D3D9ShaderPatchCacheHeader expected;
+    D3D9ShaderPatchCacheHeader header;
+
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header))
+     || std::memcmp(header.magic, expected.magic, sizeof(header.magic))
+     || header.version != expected.version)
+      return;
+
+    m_fileValid = true;
+
+    D3D9ShaderPatchCacheEntryHeader entry;
+
+    while (file.read(reinterpret_cast<char*>(&entry), sizeof(entry))) {
+      if (!entry.codeSize || entry.codeSize > MaxCodeSize)
+        break;
+
+      std::vector<uint32_t> code(entry.codeSize);
+
+      if (!file.read(reinterpret_cast<char*>(code.data()), code.size() * sizeof(uint32_t)))
+        break;
+
+      if (entry.patchHash != m_patchHash)
+        continue;
+
+      if (Sha1Hash::compute(code.data(), code.size() * sizeof(uint32_t)) != entry.codeHash) {
+        Logger::warn("D3D9: Invalid patched shader in cache file");
+        continue;
+      }
+
+      DxvkShaderKey key(VkShaderStageFlagBits(entry.stage), entry.originalHash);
+      m_entries[key] = std::move(code);
+    }
+  }
+
+
+  std::ofstream D3D9ShaderPatchCache::OpenCacheFileForWrite() {
+    std::ofstream file;
+
+    if (m_fileValid) {
+      file = std::ofstream(GetCacheFileName().c_str(),
+        std::ios_base::binary | std::ios_base::app);
+    } else {
+      file = std::ofstream(GetCacheFileName().c_str(),
+        std::ios_base::binary | std::ios_base::trunc);
+
+      if (!file && env::createDirectory(GetCacheDir())) {
+        file = std::ofstream(GetCacheFileName().c_str(),
+          std::ios_base::binary | std::ios_base::trunc);
+      }
+
+      if (file) {
+        D3D9ShaderPatchCacheHeader header;
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+      }
+    }
+
+    if (!file)
+      Logger::warn("D3D9: Failed to open patched shader cache file");
+
+    return file;
+  }
+
+
+  void D3D9ShaderPatchCache::WriteCacheEntry(
+          std::ofstream&  File,
+    const DxvkShaderKey&  Key,
+    const uint32_t*       pCode,
+          uint32_t        CodeSize) {
+    D3D9ShaderPatchCacheEntryHeader entry;
+    entry.stage        = Key.type();
+    entry.codeSize     = CodeSize;
+    entry.patchHash    = m_patchHash;
+    entry.originalHash = Key.sha1();
+    entry.codeHash     = Sha1Hash::compute(pCode, CodeSize * sizeof(uint32_t));
+
+    File.write(reinterpret_cast<const char*>(&entry), sizeof(entry));
+    File.write(reinterpret_cast<const char*>(pCode), CodeSize * sizeof(uint32_t));
+
+    m_fileValid = bool(File);
+  }
+
+
+  DxvkShaderKey D3D9ShaderPatchCache::GetPatchedShaderKey(
+    const DxvkShaderKey&  Key,
+          uint64_t        PatchHash,
+    const Sha1Hash&       CodeHash) {
+    const Sha1Hash& hash = Key.sha1();
+
+    std::array<Sha1Data, 3> chunks = {{
+      { &hash,      sizeof(hash)      },
+      { &PatchHash, sizeof(PatchHash) },
+      { &CodeHash,  sizeof(CodeHash)  },
+    }};
+
+    return DxvkShaderKey(
+      VkShaderStageFlagBits(Key.type()),
+      Sha1Hash::compute(chunks.size(), chunks.data()));
+  }
+
+
+  std::string D3D9ShaderPatchCache::GetCacheDir() {
+    std::string path = env::getEnvVar("DXVK_SHADER_PATCH_CACHE_PATH");
+
+    if (path.empty())
+      path = env::getEnvVar("DXVK_STATE_CACHE_PATH");
+
+    return path;
+  }
+
+
+  str::path_string D3D9ShaderPatchCache::GetCacheFileName() {
+    std::string path = GetCacheDir();
+
+    if (!path.empty() && *path.rbegin() != '/')
+      path += '/';
+
+    path += env::getExeBaseName() + ".dxvk-spvpatch";
+    return str::topath(path.c_str());
+  }
+
+}
@@ -0,0 +1,177 @@
+#pragma once
+
+#include "../dxvk/dxvk_hash.h"
+#include "../dxvk/dxvk_shader.h"
+
+#include "../util/thread.h"
+
+#include <fstream>
+#include <unordered_map>
+
+namespace dxvk {
+
+  /**
+   * \brief Patched SPIR-V cache file header
+   */
+  struct D3D9ShaderPatchCacheHeader {
+    char     magic[4]   = { 'D', 'X', 'S', 'P' };
+    uint32_t version    = 1;
+  };
+
+  static_assert(sizeof(D3D9ShaderPatchCacheHeader) == 8);
+
+  /**
+   * \brief Patched SPIR-V cache entry header
+   *
+   * Followed by \c codeSize dwords of SPIR-V code.
+   */
+  struct D3D9ShaderPatchCacheEntryHeader {
+    uint32_t stage;
+    uint32_t codeSize;
+    uint64_t patchHash;
+    Sha1Hash originalHash;
+    Sha1Hash codeHash;
+  };
+
+  /**
+   * \brief Shader code replacement
+   *
+   * On success, \c shader gets replaced with the patched shader.
+   */
+  struct D3D9ShaderPatch {
+    DxvkShaderKey   key;
+    Rc<DxvkShader>  shader;
+    const uint32_t* code;
+    uint32_t        codeSize;
+  };
+
+  /**
+   * \brief Persistent cache for externally patched shaders
+   *
+   * External tools can replace the SPIR-V code of a vertex shader
+   * at runtime. Patching creates a new shader object rather than
+   * modifying the original, since pipelines and pipeline libraries
+   * are looked up by shader object.
+   *
+   * Patched code is stored on disk, keyed by the key of the original
+   * shader and a hash identifying the patch, so that it can be
+   * applied as soon as the shader gets created on the next run.
+   * Patched shaders get a key derived from the original key and the
+   * patched code, which keeps state cache entries for pipelines
+   * using them valid across runs.
+   */
+  class D3D9ShaderPatchCache {
+
+  public:
+
+    /// Upper bound for the size of a cached shader, in dwords
+    constexpr static uint32_t MaxCodeSize = 1u << 22;
+
+    /**
+     * \brief Enables the cache for the given patch
+     *
+     * Loads all entries matching the patch hash from disk.
+     * Shaders patched or created afterwards use this hash.
+     * \param [in] PatchHash Identifies the external patch
+     */
+    void SetPatchHash(uint64_t PatchHash);
+
+    /**
+     * \brief Applies cached patched code to a shader
+     *
+     * \param [in] Key Key of the original shader
+     * \param [in] Shader Shader to patch
+     * \returns Patched shader, or \c nullptr if
+     *    there is no cached code for the shader
+     */
+    Rc<DxvkShader> ApplyCachedPatch(
+      const DxvkShaderKey&  Key,
+      const Rc<DxvkShader>& Shader);
+
+    /**
+     * \brief Replaces the code of a shader
+     *
+     * Writes the patched code to disk if the cache is enabled.
+     * \param [in] Key Key of the original shader
+     * \param [in] Shader Shader to patch
+     * \param [in] pCode SPIR-V code
+     * \param [in] CodeSize Code size, in dwords
+     * \returns Patched shader
+     */
+    Rc<DxvkShader> PatchShader(
+      const DxvkShaderKey&  Key,
+      const Rc<DxvkShader>& Shader,
+      const uint32_t*       pCode,
+            uint32_t        CodeSize);
+
+    /**
+     * \brief Replaces the code of multiple shaders
+     *
+     * Same as \ref PatchShader, but only locks the
+     * cache and opens the cache file once.
+     * \param [in] Count Number of shaders
+     * \param [in,out] pPatches Shaders and their new code
+     */
+    void PatchShaders(
+            uint32_t        Count,
+            D3D9ShaderPatch* pPatches);
+
+    /**
+     * \brief Checks whether a shader is patched
+     *
+     * \param [in] Key Key of the original shader
+     * \param [in] Shader The shader
+     * \returns \c true if the shader code was replaced
+     */
+    static bool IsPatched(
+      const DxvkShaderKey&  Key,
+      const Rc<DxvkShader>& Shader) {
+      return !Shader->getShaderKey().eq(Key);
+    }
+
+  private:
+
+    dxvk::mutex       m_mutex;
+
+    bool              m_enable    = false;
+    uint64_t          m_patchHash = 0;
+    bool              m_fileValid = false;
+
+    std::unordered_map<
+      DxvkShaderKey,
+      std::vector<uint32_t>,
+      DxvkHash, DxvkEq> m_entries;
+
+    Rc<DxvkShader> ReplaceCode(
+      const DxvkShaderKey&  Key,
+      const Rc<DxvkShader>& Shader,
+      const uint32_t*       pCode,
+            uint32_t        CodeSize);
+
+    void ReadCacheFile();
+
+    bool NeedsWrite(
+      const DxvkShaderKey&  Key,
+      const uint32_t*       pCode,
+            uint32_t        CodeSize) const;
+
+    std::ofstream OpenCacheFileForWrite();
+
+    void WriteCacheEntry(
+            std::ofstream&  File,
+      const DxvkShaderKey&  Key,
+      const uint32_t*       pCode,
+            uint32_t        CodeSize);
+
+    static DxvkShaderKey GetPatchedShaderKey(
+      const DxvkShaderKey&  Key,
+            uint64_t        PatchHash,
+      const Sha1Hash&       CodeHash);
+
+    static std::string GetCacheDir();
+
+    static str::path_string GetCacheFileName();
+
+  };
+
+}
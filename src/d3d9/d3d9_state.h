@@ -72,15 +72,16 @@ namespace dxvk {
     Vector4 inverseExtent;
   };
 
+  // Position and direction are stored in world space, the
+  // vertex shader transforms them with each view's matrix.
   struct D3D9Light {
-    D3D9Light(const D3DLIGHT9& light, Matrix4 viewMtx) {
+    D3D9Light(const D3DLIGHT9& light) {
       Diffuse  = Vector4(light.Diffuse.r,  light.Diffuse.g,  light.Diffuse.b,  light.Diffuse.a);
       Specular = Vector4(light.Specular.r, light.Specular.g, light.Specular.b, light.Specular.a);
       Ambient  = Vector4(light.Ambient.r,  light.Ambient.g,  light.Ambient.b,  light.Ambient.a);
 
-      Position  = viewMtx * Vector4(light.Position.x,  light.Position.y,  light.Position.z,  1.0f);
+      Position  = Vector4(light.Position.x,  light.Position.y,  light.Position.z,  1.0f);
       Direction = Vector4(light.Direction.x, light.Direction.y, light.Direction.z, 0.0f);
-      Direction = normalize(viewMtx * Direction);
 
       Type         = light.Type;
       Range        = light.Range;
@@ -110,16 +111,23 @@ namespace dxvk {
   };
 
 
-  struct D3D9FixedFunctionVS {
-    Matrix4 WorldView;
-    Matrix4 NormalMatrix;
+  struct D3D9FixedFunctionView {
+    Matrix4 View;
     Matrix4 InverseView;
     Matrix4 Projection;
+  };
+
+
+  struct D3D9FixedFunctionViews {
+    // Indexed by ViewIndex, only the first
+    // view is used without multiview.
+    std::array<D3D9FixedFunctionView, caps::MaxViewCount> Views;
+  };
+
 
-    Matrix4 WorldView2;
-    Matrix4 NormalMatrix2;
-    Matrix4 InverseView2;
-    Matrix4 Projection2;
+  struct D3D9FixedFunctionVS {
+    Matrix4 World;
+    Matrix4 InverseWorld;
 
     std::array<Matrix4, 8> TexcoordMatrices;
 
@@ -133,12 +141,12 @@ namespace dxvk {
 
 
   struct D3D9FixedFunctionVertexBlendDataHW {
-    Matrix4 WorldView[8];
+    Matrix4 World[8];
   };
 
 
   struct D3D9FixedFunctionVertexBlendDataSW {
-    Matrix4 WorldView[256];
+    Matrix4 World[256];
   };
 
 
@@ -307,8 +315,7 @@ namespace dxvk {
           std::memcpy(set->fConsts[StartRegister].data, pConstantData, size);
         }
         else {
-          for (UINT i = 0; i < Count; i++)
-            set->fConsts[StartRegister + i] = replaceNaN(pConstantData + (i * 4));
+          replaceNaN(&set->fConsts[StartRegister], pConstantData, Count);
         }
       }
       else if constexpr (ConstantType == D3D9ConstantType::Int) {
@@ -317,16 +324,20 @@ namespace dxvk {
         std::memcpy(set->iConsts[StartRegister].data, pConstantData, size);
       }
       else {
-        for (uint32_t i = 0; i < Count; i++) {
+        static_assert(sizeof(T) == sizeof(uint32_t));
+
+        // Convert up to one bitfield dword worth of constants at a time
+        for (uint32_t i = 0; i < Count; ) {
           const uint32_t constantIdx = StartRegister + i;
           const uint32_t arrayIdx    = constantIdx / 32;
           const uint32_t bitIdx      = constantIdx % 32;
+          const uint32_t bitCount    = std::min(Count - i, 32u - bitIdx);
 
-          const uint32_t bit = 1u << bitIdx;
+          const uint32_t mask = (bitCount < 32 ? (1u << bitCount) - 1u : ~0u) << bitIdx;
+          const uint32_t bits = bit::dnez(reinterpret_cast<const uint32_t*>(&pConstantData[i]), bitCount) << bitIdx;
 
-          set->bConsts[arrayIdx] &= ~bit;
-          if (pConstantData[i])
-            set->bConsts[arrayIdx] |= bit;
+          set->bConsts[arrayIdx] = (set->bConsts[arrayIdx] & ~mask) | bits;
+          i += bitCount;
         }
       }
 
@@ -15,6 +15,9 @@ namespace dxvk {
     : D3D9StateBlockBase(pDevice)
     , m_deviceState     (pDevice->GetRawState()) {
     CaptureType(Type);
+
+    if (Type != D3D9StateBlockType::None)
+      CompileDeltas();
   }
 
   D3D9StateBlock::~D3D9StateBlock() {
@@ -56,6 +59,8 @@ namespace dxvk {
 
 
   HRESULT STDMETHODCALLTYPE D3D9StateBlock::Apply() {
+    D3D9DeviceLock lock = m_parent->LockDevice();
+
     m_applying = true;
 
     if (m_captures.flags.test(D3D9CapturedStateFlag::VertexDecl) && m_state.vertexDecl != nullptr)
@@ -370,6 +375,102 @@ namespace dxvk {
   }
 
 
+  void D3D9StateBlock::CompileDeltas() {
+    m_deltas.clear();
+
+    auto AddDeltas = [this] (
+            D3D9StateDeltaType  Type,
+            uint32_t            Stage,
+      const auto&               Captures,
+            uint32_t            StateCount) {
+      for (uint32_t i = 0; i < Captures.dwordCount(); i++) {
+        uint32_t mask = Captures.dword(i);
+
+        if (!mask)
+          continue;
+
+        D3D9StateDelta delta;
+        delta.type  = Type;
+        delta.stage = uint16_t(Stage);
+        delta.first = uint16_t(i * 32);
+        delta.count = uint16_t(std::min(StateCount - i * 32, 32u));
+        delta.mask  = mask;
+        m_deltas.push_back(delta);
+      }
+    };
+
+    m_deltaOffsets[uint32_t(D3D9StateDeltaType::RenderState)] = m_deltas.size();
+
+    if (m_captures.flags.test(D3D9CapturedStateFlag::RenderStates))
+      AddDeltas(D3D9StateDeltaType::RenderState, 0, m_captures.renderStates, RenderStateCount);
+
+    m_deltaOffsets[uint32_t(D3D9StateDeltaType::SamplerState)] = m_deltas.size();
+
+    if (m_captures.flags.test(D3D9CapturedStateFlag::SamplerStates)) {
+      for (uint32_t samplerIdx : bit::BitMask(m_captures.samplers.dword(0)))
+        AddDeltas(D3D9StateDeltaType::SamplerState, samplerIdx, m_captures.samplerStates[samplerIdx], SamplerStateCount);
+    }
+
+    m_deltaOffsets[uint32_t(D3D9StateDeltaType::TextureStageState)] = m_deltas.size();
+
+    if (m_captures.flags.test(D3D9CapturedStateFlag::TextureStages)) {
+      for (uint32_t stageIdx : bit::BitMask(m_captures.textureStages.dword(0)))
+        AddDeltas(D3D9StateDeltaType::TextureStageState, stageIdx, m_captures.textureStageStates[stageIdx], TextureStageStateCount);
+    }
+
+    m_deltaOffsets[uint32_t(D3D9StateDeltaType::Count)] = m_deltas.size();
+    m_deltasValid = true;
+  }
+
+
+  bool D3D9StateBlock::ApplyDeltas(D3D9DeviceEx* pDst, D3D9StateDeltaType Type) {
+    // While recording, every state needs to go to the recording
+    // state block, so we can't skip states matching the device.
+    if (unlikely(!m_deltasValid || pDst->IsRecordingState()))
+      return false;
+
+    uint32_t begin = m_deltaOffsets[uint32_t(Type)];
+    uint32_t end   = m_deltaOffsets[uint32_t(Type) + 1];
+
+    for (uint32_t i = begin; i < end; i++) {
+      const D3D9StateDelta& delta = m_deltas[i];
+
+      const DWORD* src = GetDeltaStates(m_state, delta);
+      const DWORD* cur = GetDeltaStates(*m_deviceState, delta);
+
+      // Device setters ignore redundant values anyway, so
+      // only call them for states that actually change.
+      uint32_t changed = delta.mask & bit::dcmpne(
+        reinterpret_cast<const uint32_t*>(src),
+        reinterpret_cast<const uint32_t*>(cur),
+        delta.count);
+
+      for (uint32_t idx : bit::BitMask(changed)) {
+        uint32_t state = delta.first + idx;
+
+        switch (Type) {
+          case D3D9StateDeltaType::RenderState:
+            pDst->SetRenderState(D3DRENDERSTATETYPE(state), src[idx]);
+            break;
+
+          case D3D9StateDeltaType::SamplerState:
+            pDst->SetStateSamplerState(delta.stage, D3DSAMPLERSTATETYPE(state), src[idx]);
+            break;
+
+          case D3D9StateDeltaType::TextureStageState:
+            pDst->SetStateTextureStageState(delta.stage, D3D9TextureStageStateTypes(state), src[idx]);
+            break;
+
+          default:
+            break;
+        }
+      }
+    }
+
+    return true;
+  }
+
+
   void D3D9StateBlock::CapturePixelRenderStates() {
     m_captures.flags.set(D3D9CapturedStateFlag::RenderStates);
 
@@ -66,6 +66,30 @@ namespace dxvk {
     bit::bitvector                                      lightEnabledChanges;
   };
 
+  enum class D3D9StateDeltaType : uint16_t {
+    RenderState,
+    SamplerState,
+    TextureStageState,
+
+    Count
+  };
+
+  /**
+   * \brief Precompiled state block delta
+   *
+   * Describes up to 32 consecutive DWORD states of one
+   * kind that are captured by a state block, so that
+   * applying the block does not need to walk all of
+   * the capture bit sets.
+   */
+  struct D3D9StateDelta {
+    D3D9StateDeltaType type;
+    uint16_t           stage;
+    uint16_t           first;
+    uint16_t           count;
+    uint32_t           mask;
+  };
+
   enum class D3D9StateBlockType :uint32_t {
     None,
     VertexState,
@@ -196,7 +220,8 @@ namespace dxvk {
       if (m_captures.flags.test(D3D9CapturedStateFlag::Indices))
         dst->SetIndices(src->indices.ptr());
 
-      if (m_captures.flags.test(D3D9CapturedStateFlag::RenderStates)) {
+      if (m_captures.flags.test(D3D9CapturedStateFlag::RenderStates)
+       && !ApplyDeltas(dst, D3D9StateDeltaType::RenderState)) {
         for (uint32_t i = 0; i < m_captures.renderStates.dwordCount(); i++) {
           for (uint32_t rs : bit::BitMask(m_captures.renderStates.dword(i))) {
             uint32_t idx = i * 32 + rs;
@@ -206,7 +231,8 @@ namespace dxvk {
         }
       }
 
-      if (m_captures.flags.test(D3D9CapturedStateFlag::SamplerStates)) {
+      if (m_captures.flags.test(D3D9CapturedStateFlag::SamplerStates)
+       && !ApplyDeltas(dst, D3D9StateDeltaType::SamplerState)) {
         for (uint32_t samplerIdx : bit::BitMask(m_captures.samplers.dword(0))) {
           for (uint32_t stateIdx : bit::BitMask(m_captures.samplerStates[samplerIdx].dword(0)))
             dst->SetStateSamplerState(samplerIdx, D3DSAMPLERSTATETYPE(stateIdx), src->samplerStates[samplerIdx][stateIdx]);
@@ -256,7 +282,8 @@ namespace dxvk {
         }
       }
 
-      if (m_captures.flags.test(D3D9CapturedStateFlag::TextureStages)) {
+      if (m_captures.flags.test(D3D9CapturedStateFlag::TextureStages)
+       && !ApplyDeltas(dst, D3D9StateDeltaType::TextureStageState)) {
         for (uint32_t stageIdx : bit::BitMask(m_captures.textureStages.dword(0))) {
           for (uint32_t stateIdx : bit::BitMask(m_captures.textureStageStates[stageIdx].dword(0)))
             dst->SetStateTextureStageState(stageIdx, D3D9TextureStageStateTypes(stateIdx), src->textureStages[stageIdx][stateIdx]);
@@ -394,8 +421,38 @@ namespace dxvk {
       return m_applying;
     }
 
+    /**
+     * \brief Compiles captured DWORD states into delta lists
+     *
+     * Must be called once the set of captured states is final,
+     * i.e. after creating or recording the state block. Apply
+     * then only calls device setters for states whose value
+     * differs from the current device state.
+     */
+    void CompileDeltas();
+
   private:
 
+    bool ApplyDeltas(D3D9StateBlock* pDst, D3D9StateDeltaType Type) {
+      return false;
+    }
+
+    bool ApplyDeltas(D3D9DeviceEx* pDst, D3D9StateDeltaType Type);
+
+    template <typename State>
+    static const DWORD* GetDeltaStates(const State& state, const D3D9StateDelta& delta) {
+      switch (delta.type) {
+        case D3D9StateDeltaType::RenderState:
+          return &state.renderStates[delta.first];
+        case D3D9StateDeltaType::SamplerState:
+          return &state.samplerStates[delta.stage][delta.first];
+        case D3D9StateDeltaType::TextureStageState:
+          return &state.textureStages[delta.stage][delta.first];
+        default:
+          return nullptr;
+      }
+    }
+
     void CapturePixelRenderStates();
     void CapturePixelSamplerStates();
     void CapturePixelShaderStates();
@@ -413,6 +470,10 @@ namespace dxvk {
 
     bool                 m_applying = false;
 
+    std::vector<D3D9StateDelta> m_deltas;
+    std::array<uint32_t, uint32_t(D3D9StateDeltaType::Count) + 1> m_deltaOffsets = { };
+    bool                 m_deltasValid = false;
+
   };
 
 }
\ No newline at end of file
@@ -12,10 +12,11 @@ namespace dxvk {
           D3D9DeviceEx*             pDevice,
     const D3D9_COMMON_TEXTURE_DESC* pDesc,
           IUnknown*                 pContainer,
+    const D3D9_COMMON_TEXTURE_IMPORT_INFO* pImport,
           HANDLE*                   pSharedHandle)
     : D3D9SurfaceBase(
         pDevice,
-        new D3D9CommonTexture( pDevice, this, pDesc, D3DRTYPE_SURFACE, pSharedHandle),
+        new D3D9CommonTexture( pDevice, this, pDesc, D3DRTYPE_SURFACE, pImport, pSharedHandle),
         0, 0,
         nullptr,
         pContainer) { }
@@ -21,6 +21,7 @@ namespace dxvk {
             D3D9DeviceEx*             pDevice,
       const D3D9_COMMON_TEXTURE_DESC* pDesc,
             IUnknown*                 pContainer,
+      const D3D9_COMMON_TEXTURE_IMPORT_INFO* pImport,
             HANDLE*                   pSharedHandle);
 
     D3D9Surface(
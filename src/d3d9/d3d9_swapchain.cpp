@@ -1050,7 +1050,7 @@ namespace dxvk {
     for (uint32_t i = 0; i < NumBuffers; i++) {
       D3D9Surface* surface;
       try {
-        surface = new D3D9Surface(m_parent, &desc, this, nullptr);
+        surface = new D3D9Surface(m_parent, &desc, this, nullptr, nullptr);
         m_parent->IncrementLosableCounter();
       } catch (const DxvkError& e) {
         DestroyBackBuffers();
@@ -1102,6 +1102,9 @@ namespace dxvk {
       m_hud->addItem<hud::HudSamplerCount>("samplers", -1, m_parent);
       m_hud->addItem<hud::HudFixedFunctionShaders>("ffshaders", -1, m_parent);
       m_hud->addItem<hud::HudSWVPState>("swvp", -1, m_parent);
+      m_hud->addItem<hud::HudUPBuffer>("upbuffer", -1, m_parent);
+      m_hud->addItem<hud::HudImportedImageCache>("vrimages", -1, m_parent);
+      m_hud->addItem<hud::HudVRFrameTimings>("vrtiming", -1, m_parent);
 
 #ifdef D3D9_ALLOW_UNMAPPING
       m_hud->addItem<hud::HudTextureMemory>("memory", -1, m_parent);
@@ -0,0 +1,1427 @@
+#include "d3d9_swvp_cpu.h"
+#include "d3d9_util.h"
+
+#include "../dxso/dxso_code.h"
+#include "../dxso/dxso_header.h"
+
+#include "../util/util_env.h"
+#include "../util/util_small_vector.h"
+
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+namespace dxvk {
+
+  static bool IsDynamicCondition(const DxsoRegister& Reg) {
+    return Reg.id.type != DxsoRegisterType::ConstBool;
+  }
+
+
+  D3D9SWVPProgram::D3D9SWVPProgram(const void* pShaderBytecode) {
+    DxsoReader reader(reinterpret_cast<const char*>(pShaderBytecode));
+
+    DxsoHeader header(reader);
+    DxsoCode   code(reader);
+
+    m_info = header.info();
+
+    if (m_info.type() != DxsoProgramTypes::VertexShader) {
+      m_supported = false;
+      return;
+    }
+
+    // Shaders below 3.0 write to fixed output registers
+    if (m_info.majorVersion() < 3) {
+      m_outputSemantics[OutputSlotRasterizer + RasterOutPosition]  = { DxsoUsage::Position,  0 };
+      m_outputSemantics[OutputSlotRasterizer + RasterOutFog]       = { DxsoUsage::Fog,       0 };
+      m_outputSemantics[OutputSlotRasterizer + RasterOutPointSize] = { DxsoUsage::PointSize, 0 };
+
+      for (uint32_t i = 0; i < 2; i++)
+        m_outputSemantics[OutputSlotAttribute + i] = { DxsoUsage::Color, i };
+
+      for (uint32_t i = 0; i < 8; i++)
+        m_outputSemantics[OutputSlotTexcoord + i] = { DxsoUsage::Texcoord, i };
+
+      m_outputMask = (1u << (OutputSlotTexcoord + 8)) - 1;
+    }
+
+    DxsoDecodeContext decoder(m_info);
+    DxsoCodeIter iter = code.iter();
+
+    while (m_supported && decoder.decodeInstruction(iter))
+      m_supported = ProcessInstruction(decoder.getInstructionContext());
+
+    if (!m_blockStack.empty() || !m_loopBreaks.empty())
+      m_supported = false;
+
+    // Not needed after decoding
+    m_blockStack  = std::vector<uint32_t>();
+    m_loopBreaks  = std::vector<std::vector<uint32_t>>();
+  }
+
+
+  uint32_t D3D9SWVPProgram::FindOutput(DxsoSemantic Semantic) const {
+    if (Semantic.usage == DxsoUsage::PositionT)
+      Semantic.usage = DxsoUsage::Position;
+
+    for (uint32_t i : bit::BitMask(m_outputMask)) {
+      if (m_outputSemantics[i] == Semantic)
+        return i;
+    }
+
+    return MaxOutputs;
+  }
+
+
+  void D3D9SWVPProgram::ApplyDefinitions(
+          Vector4*        pFloats,
+          uint32_t        FloatCount,
+          Vector4i*       pInts,
+          uint32_t        IntCount,
+          uint32_t*       pBools,
+          uint32_t        BoolCount) const {
+    for (const auto& def : m_floatDefs) {
+      if (def.reg < FloatCount)
+        pFloats[def.reg] = Vector4(def.value.float32);
+    }
+
+    for (const auto& def : m_intDefs) {
+      if (def.reg < IntCount)
+        pInts[def.reg] = Vector4i(def.value.int32);
+    }
+
+    for (const auto& def : m_boolDefs) {
+      if (def.reg < BoolCount) {
+        uint32_t bit = 1u << (def.reg % 32);
+
+        pBools[def.reg / 32] &= ~bit;
+
+        if (def.value.uint32[0])
+          pBools[def.reg / 32] |= bit;
+      }
+    }
+  }
+
+
+  bool D3D9SWVPProgram::ProcessInstruction(
+    const DxsoInstructionContext& Ctx) {
+    const DxsoOpcode opcode = Ctx.instruction.opcode;
+
+    switch (opcode) {
+      case DxsoOpcode::Nop:
+      case DxsoOpcode::Comment:
+      case DxsoOpcode::End:
+        return true;
+
+      case DxsoOpcode::Dcl: {
+        uint32_t num = Ctx.dst.id.num;
+
+        if (Ctx.dst.id.type == DxsoRegisterType::Input && num < DxsoMaxInterfaceRegs) {
+          m_inputSemantics[num] = Ctx.dcl.semantic;
+          m_inputMask |= 1u << num;
+        } else if (Ctx.dst.id.type == DxsoRegisterType::Output && num < MaxOutputs) {
+          m_outputSemantics[num] = Ctx.dcl.semantic;
+          m_outputMask |= 1u << num;
+        }
+        return true;
+      }
+
+      case DxsoOpcode::Def:
+        m_floatDefs.push_back({ Ctx.dst.id.num, Ctx.def });
+        return true;
+
+      case DxsoOpcode::DefI:
+        m_intDefs.push_back({ Ctx.dst.id.num, Ctx.def });
+        return true;
+
+      case DxsoOpcode::DefB:
+        m_boolDefs.push_back({ Ctx.dst.id.num, Ctx.def });
+        return true;
+
+      case DxsoOpcode::Mov:
+      case DxsoOpcode::Mova:
+      case DxsoOpcode::Add:
+      case DxsoOpcode::Sub:
+      case DxsoOpcode::Mad:
+      case DxsoOpcode::Mul:
+      case DxsoOpcode::Rcp:
+      case DxsoOpcode::Rsq:
+      case DxsoOpcode::Dp3:
+      case DxsoOpcode::Dp4:
+      case DxsoOpcode::Min:
+      case DxsoOpcode::Max:
+      case DxsoOpcode::Slt:
+      case DxsoOpcode::Sge:
+      case DxsoOpcode::Exp:
+      case DxsoOpcode::ExpP:
+      case DxsoOpcode::Log:
+      case DxsoOpcode::LogP:
+      case DxsoOpcode::Lit:
+      case DxsoOpcode::Dst:
+      case DxsoOpcode::Lrp:
+      case DxsoOpcode::Frc:
+      case DxsoOpcode::M4x4:
+      case DxsoOpcode::M4x3:
+      case DxsoOpcode::M3x4:
+      case DxsoOpcode::M3x3:
+      case DxsoOpcode::M3x2:
+      case DxsoOpcode::Pow:
+      case DxsoOpcode::Crs:
+      case DxsoOpcode::Sgn:
+      case DxsoOpcode::Abs:
+      case DxsoOpcode::Nrm:
+      case DxsoOpcode::SinCos:
+      case DxsoOpcode::SetP:
+      case DxsoOpcode::If:
+      case DxsoOpcode::Ifc:
+      case DxsoOpcode::Else:
+      case DxsoOpcode::EndIf:
+      case DxsoOpcode::Rep:
+      case DxsoOpcode::Loop:
+      case DxsoOpcode::EndRep:
+      case DxsoOpcode::EndLoop:
+      case DxsoOpcode::Break:
+      case DxsoOpcode::BreakC:
+      case DxsoOpcode::BreakP:
+        break;
+
+      default:
+        // Texture fetches, subroutines and pixel shader
+        // instructions are left to the GPU implementation
+        return false;
+    }
+
+    // Source modifiers that only exist in pixel shaders
+    for (uint32_t i = 0; i < Ctx.src.size(); i++) {
+      if (Ctx.src[i].modifier == DxsoRegModifier::Dz
+       || Ctx.src[i].modifier == DxsoRegModifier::Dw)
+        return false;
+    }
+
+    uint32_t index = uint32_t(m_instructions.size());
+
+    D3D9SWVPInstruction& ins = m_instructions.emplace_back();
+    ins.opcode     = opcode;
+    ins.comparison = Ctx.instruction.specificData.comparison;
+    ins.predicated = Ctx.instruction.predicated;
+    ins.pred       = Ctx.pred;
+    ins.dst        = Ctx.dst;
+    ins.target     = 0;
+
+    for (uint32_t i = 0; i < ins.src.size(); i++)
+      ins.src[i] = Ctx.src[i];
+
+    switch (opcode) {
+      case DxsoOpcode::If:
+        m_dynamicFlowControl |= IsDynamicCondition(ins.src[0]);
+        m_blockStack.push_back(index);
+        break;
+
+      case DxsoOpcode::Ifc:
+        m_dynamicFlowControl = true;
+        m_blockStack.push_back(index);
+        break;
+
+      case DxsoOpcode::Else:
+        if (m_blockStack.empty())
+          return false;
+
+        m_instructions[m_blockStack.back()].target = index + 1;
+        m_blockStack.back() = index;
+        break;
+
+      case DxsoOpcode::EndIf:
+        if (m_blockStack.empty())
+          return false;
+
+        m_instructions[m_blockStack.back()].target = index;
+        m_blockStack.pop_back();
+        break;
+
+      case DxsoOpcode::Rep:
+      case DxsoOpcode::Loop:
+        m_blockStack.push_back(index);
+        m_loopBreaks.emplace_back();
+        break;
+
+      case DxsoOpcode::EndRep:
+      case DxsoOpcode::EndLoop: {
+        if (m_blockStack.empty() || m_loopBreaks.empty())
+          return false;
+
+        uint32_t start = m_blockStack.back();
+
+        m_instructions[start].target = index;
+        m_instructions[index].target = start;
+
+        for (uint32_t breakIndex : m_loopBreaks.back())
+          m_instructions[breakIndex].target = index + 1;
+
+        m_blockStack.pop_back();
+        m_loopBreaks.pop_back();
+        break;
+      }
+
+      case DxsoOpcode::Break:
+      case DxsoOpcode::BreakC:
+      case DxsoOpcode::BreakP:
+        if (m_loopBreaks.empty())
+          return false;
+
+        m_dynamicFlowControl |= opcode != DxsoOpcode::Break;
+        m_loopBreaks.back().push_back(index);
+        break;
+
+      default:
+        break;
+    }
+
+    return true;
+  }
+
+
+  static float HalfToFloat(uint16_t Value) {
+    uint32_t sign     = uint32_t(Value & 0x8000u) << 16;
+    uint32_t exponent = (Value >> 10) & 0x1fu;
+    uint32_t mantissa = Value & 0x3ffu;
+    uint32_t bits;
+
+    if (exponent == 0) {
+      float result = float(mantissa) * (1.0f / 16777216.0f);
+      return sign ? -result : result;
+    } else if (exponent == 31) {
+      bits = sign | 0x7f800000u | (mantissa << 13);
+    } else {
+      bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+    }
+
+    float result;
+    std::memcpy(&result, &bits, sizeof(result));
+    return result;
+  }
+
+
+  static uint16_t FloatToHalf(float Value) {
+    uint32_t bits;
+    std::memcpy(&bits, &Value, sizeof(bits));
+
+    uint32_t sign     = (bits >> 16) & 0x8000u;
+    int32_t  exponent = int32_t((bits >> 23) & 0xffu) - 127 + 15;
+    uint32_t mantissa = bits & 0x7fffffu;
+
+    if (((bits >> 23) & 0xffu) == 0xffu)
+      return uint16_t(sign | 0x7c00u | (mantissa ? 0x200u : 0u));
+
+    if (exponent >= 31)
+      return uint16_t(sign | 0x7c00u);
+
+    if (exponent <= 0) {
+      if (exponent < -10)
+        return uint16_t(sign);
+
+      mantissa |= 0x800000u;
+
+      uint32_t shift  = uint32_t(14 - exponent);
+      uint32_t result = mantissa >> shift;
+
+      if ((mantissa >> (shift - 1)) & 1u)
+        result += 1;
+
+      return uint16_t(sign | result);
+    }
+
+    uint32_t result = sign | (uint32_t(exponent) << 10) | (mantissa >> 13);
+
+    // Rounding may carry into the exponent, which is correct
+    if (mantissa & 0x1000u)
+      result += 1;
+
+    return uint16_t(result);
+  }
+
+
+  static Vector4 DecodeVertexElement(D3DDECLTYPE Type, const uint8_t* pData) {
+    Vector4 result(0.0f, 0.0f, 0.0f, 1.0f);
+
+    auto load = [pData] (auto& value, uint32_t index) {
+      std::memcpy(&value, pData + index * sizeof(value), sizeof(value));
+      return value;
+    };
+
+    switch (Type) {
+      case D3DDECLTYPE_FLOAT4: result.w = load(result.w, 3); [[fallthrough]];
+      case D3DDECLTYPE_FLOAT3: result.z = load(result.z, 2); [[fallthrough]];
+      case D3DDECLTYPE_FLOAT2: result.y = load(result.y, 1); [[fallthrough]];
+      case D3DDECLTYPE_FLOAT1: result.x = load(result.x, 0); break;
+
+      case D3DDECLTYPE_D3DCOLOR:
+        result = Vector4(float(pData[2]), float(pData[1]), float(pData[0]), float(pData[3])) * (1.0f / 255.0f);
+        break;
+
+      case D3DDECLTYPE_UBYTE4:
+        result = Vector4(float(pData[0]), float(pData[1]), float(pData[2]), float(pData[3]));
+        break;
+
+      case D3DDECLTYPE_UBYTE4N:
+        result = Vector4(float(pData[0]), float(pData[1]), float(pData[2]), float(pData[3])) * (1.0f / 255.0f);
+        break;
+
+      case D3DDECLTYPE_SHORT2:
+      case D3DDECLTYPE_SHORT4:
+      case D3DDECLTYPE_SHORT2N:
+      case D3DDECLTYPE_SHORT4N: {
+        uint32_t count = (Type == D3DDECLTYPE_SHORT2 || Type == D3DDECLTYPE_SHORT2N) ? 2 : 4;
+        bool normalize = Type == D3DDECLTYPE_SHORT2N || Type == D3DDECLTYPE_SHORT4N;
+
+        for (uint32_t i = 0; i < count; i++) {
+          int16_t value;
+          float f = float(load(value, i));
+          result[i] = normalize ? std::max(f / 32767.0f, -1.0f) : f;
+        }
+        break;
+      }
+
+      case D3DDECLTYPE_USHORT2N:
+      case D3DDECLTYPE_USHORT4N: {
+        uint32_t count = Type == D3DDECLTYPE_USHORT2N ? 2 : 4;
+
+        for (uint32_t i = 0; i < count; i++) {
+          uint16_t value;
+          result[i] = float(load(value, i)) / 65535.0f;
+        }
+        break;
+      }
+
+      case D3DDECLTYPE_UDEC3:
+      case D3DDECLTYPE_DEC3N: {
+        uint32_t value;
+        load(value, 0);
+
+        for (uint32_t i = 0; i < 3; i++) {
+          uint32_t bits = (value >> (10 * i)) & 0x3ffu;
+
+          if (Type == D3DDECLTYPE_UDEC3) {
+            result[i] = float(bits);
+          } else {
+            int32_t signedBits = int32_t(bits << 22) >> 22;
+            result[i] = std::max(float(signedBits) / 511.0f, -1.0f);
+          }
+        }
+        break;
+      }
+
+      case D3DDECLTYPE_FLOAT16_2:
+      case D3DDECLTYPE_FLOAT16_4: {
+        uint32_t count = Type == D3DDECLTYPE_FLOAT16_2 ? 2 : 4;
+
+        for (uint32_t i = 0; i < count; i++) {
+          uint16_t value;
+          result[i] = HalfToFloat(load(value, i));
+        }
+        break;
+      }
+
+      default:
+        break;
+    }
+
+    return result;
+  }
+
+
+  static void EncodeVertexElement(D3DDECLTYPE Type, uint8_t* pData, const Vector4& Value) {
+    auto store = [pData] (auto value, uint32_t index) {
+      std::memcpy(pData + index * sizeof(value), &value, sizeof(value));
+    };
+
+    auto unorm = [] (float value, float scale) {
+      return std::floor(fclamp(value, 0.0f, 1.0f) * scale + 0.5f);
+    };
+
+    auto snorm = [] (float value, float scale) {
+      float scaled = fclamp(value, -1.0f, 1.0f) * scale;
+      return scaled < 0.0f ? std::ceil(scaled - 0.5f) : std::floor(scaled + 0.5f);
+    };
+
+    switch (Type) {
+      case D3DDECLTYPE_FLOAT4: store(Value.w, 3); [[fallthrough]];
+      case D3DDECLTYPE_FLOAT3: store(Value.z, 2); [[fallthrough]];
+      case D3DDECLTYPE_FLOAT2: store(Value.y, 1); [[fallthrough]];
+      case D3DDECLTYPE_FLOAT1: store(Value.x, 0); break;
+
+      case D3DDECLTYPE_D3DCOLOR:
+        pData[0] = uint8_t(unorm(Value.z, 255.0f));
+        pData[1] = uint8_t(unorm(Value.y, 255.0f));
+        pData[2] = uint8_t(unorm(Value.x, 255.0f));
+        pData[3] = uint8_t(unorm(Value.w, 255.0f));
+        break;
+
+      case D3DDECLTYPE_UBYTE4:
+        for (uint32_t i = 0; i < 4; i++)
+          pData[i] = uint8_t(fclamp(Value[i], 0.0f, 255.0f));
+        break;
+
+      case D3DDECLTYPE_UBYTE4N:
+        for (uint32_t i = 0; i < 4; i++)
+          pData[i] = uint8_t(unorm(Value[i], 255.0f));
+        break;
+
+      case D3DDECLTYPE_SHORT2:
+      case D3DDECLTYPE_SHORT4: {
+        uint32_t count = Type == D3DDECLTYPE_SHORT2 ? 2 : 4;
+
+        for (uint32_t i = 0; i < count; i++)
+          store(int16_t(fclamp(Value[i], -32768.0f, 32767.0f)), i);
+        break;
+      }
+
+      case D3DDECLTYPE_SHORT2N:
+      case D3DDECLTYPE_SHORT4N: {
+        uint32_t count = Type == D3DDECLTYPE_SHORT2N ? 2 : 4;
+
+        for (uint32_t i = 0; i < count; i++)
+          store(int16_t(snorm(Value[i], 32767.0f)), i);
+        break;
+      }
+
+      case D3DDECLTYPE_USHORT2N:
+      case D3DDECLTYPE_USHORT4N: {
+        uint32_t count = Type == D3DDECLTYPE_USHORT2N ? 2 : 4;
+
+        for (uint32_t i = 0; i < count; i++)
+          store(uint16_t(unorm(Value[i], 65535.0f)), i);
+        break;
+      }
+
+      case D3DDECLTYPE_UDEC3:
+      case D3DDECLTYPE_DEC3N: {
+        uint32_t value = 0;
+
+        for (uint32_t i = 0; i < 3; i++) {
+          uint32_t bits = Type == D3DDECLTYPE_UDEC3
+            ? uint32_t(fclamp(Value[i], 0.0f, 1023.0f))
+            : uint32_t(int32_t(snorm(Value[i], 511.0f)));
+
+          value |= (bits & 0x3ffu) << (10 * i);
+        }
+
+        store(value, 0);
+        break;
+      }
+
+      case D3DDECLTYPE_FLOAT16_2:
+      case D3DDECLTYPE_FLOAT16_4: {
+        uint32_t count = Type == D3DDECLTYPE_FLOAT16_2 ? 2 : 4;
+
+        for (uint32_t i = 0; i < count; i++)
+          store(FloatToHalf(Value[i]), i);
+        break;
+      }
+
+      default:
+        break;
+    }
+  }
+
+
+  /**
+   * \brief Vertex shader interpreter
+   *
+   * Registers are stored component-major with one entry per
+   * vertex, so that each operation is a simple loop over \c W
+   * vertices that the compiler can turn into vector code.
+   */
+  template <uint32_t W>
+  class D3D9SWVPExecutor {
+
+  public:
+
+    D3D9SWVPExecutor(
+      const D3D9SWVPJob&    Job,
+      const Vector4*        pFloatConsts,
+      const Vector4i*       pIntConsts,
+      const uint32_t*       pBoolConsts)
+    : m_job         (Job),
+      m_program     (*Job.program),
+      m_floatConsts (pFloatConsts),
+      m_intConsts   (pIntConsts),
+      m_boolConsts  (pBoolConsts),
+      m_mulz        (Job.floatEmulation != D3D9FloatEmulation::Disabled),
+      m_clamp       (Job.floatEmulation == D3D9FloatEmulation::Enabled) { }
+
+    void Run(uint32_t First, uint32_t Count) {
+      m_count = Count;
+
+      std::memset(&m_temps,   0, sizeof(m_temps));
+      std::memset(&m_outputs, 0, sizeof(m_outputs));
+      std::memset(&m_addr,    0, sizeof(m_addr));
+      std::memset(&m_pred,    0, sizeof(m_pred));
+      m_loopCounter = 0;
+
+      LoadInputs(First);
+      Execute();
+      StoreOutputs(First);
+    }
+
+  private:
+
+    struct Vec {
+      float c[4][W];
+    };
+
+    struct LoopState {
+      uint32_t start;
+      int32_t  remaining;
+      int32_t  step;
+      int32_t  prevCounter;
+    };
+
+    const D3D9SWVPJob&      m_job;
+    const D3D9SWVPProgram&  m_program;
+
+    const Vector4*          m_floatConsts;
+    const Vector4i*         m_intConsts;
+    const uint32_t*         m_boolConsts;
+
+    bool                    m_mulz;
+    bool                    m_clamp;
+
+    uint32_t                m_count = 0;
+
+    std::array<Vec, DxsoMaxTempRegs>                m_temps;
+    std::array<Vec, DxsoMaxInterfaceRegs>           m_inputs;
+    std::array<Vec, D3D9SWVPProgram::MaxOutputs>    m_outputs;
+
+    int32_t                 m_addr[4][W];
+    uint32_t                m_pred[4][W];
+    int32_t                 m_loopCounter = 0;
+
+    float Mul(float A, float B) const {
+      return (m_mulz && (A == 0.0f || B == 0.0f)) ? 0.0f : A * B;
+    }
+
+    float ClampMax(float Value) const {
+      return m_clamp ? std::min(Value, FLT_MAX) : Value;
+    }
+
+    void LoadInputs(uint32_t First) {
+      std::memset(&m_inputs, 0, sizeof(m_inputs));
+
+      for (const auto& input : m_job.inputs) {
+        Vec& reg = m_inputs[input.reg];
+
+        for (uint32_t l = 0; l < m_count; l++) {
+          uint32_t vertex = input.instanced ? 0 : First + l;
+
+          Vector4 value = vertex < input.vertexLimit
+            ? DecodeVertexElement(input.type, input.data + size_t(vertex) * input.stride)
+            : Vector4(0.0f);
+
+          for (uint32_t i = 0; i < 4; i++)
+            reg.c[i][l] = value[i];
+        }
+      }
+    }
+
+    void StoreOutputs(uint32_t First) {
+      for (const auto& output : m_job.outputs) {
+        const Vec& reg = m_outputs[output.slot];
+
+        for (uint32_t l = 0; l < m_count; l++) {
+          uint32_t vertex = First - m_job.firstVertex + l;
+
+          Vector4 value(reg.c[0][l], reg.c[1][l], reg.c[2][l], reg.c[3][l]);
+
+          EncodeVertexElement(output.type,
+            m_job.dstData + size_t(vertex) * m_job.dstStride + output.offset,
+            value);
+        }
+      }
+    }
+
+    int32_t RelativeOffset(const DxsoRegister& Reg, uint32_t Lane) const {
+      if (!Reg.hasRelative)
+        return 0;
+
+      if (Reg.relative.id.type == DxsoRegisterType::Loop)
+        return m_loopCounter;
+
+      return m_addr[Reg.relative.swizzle[0]][Lane];
+    }
+
+    static bool IsConstantRegister(DxsoRegisterType Type, uint32_t* pBase) {
+      switch (Type) {
+        case DxsoRegisterType::Const:  *pBase = 0;    return true;
+        case DxsoRegisterType::Const2: *pBase = 2048; return true;
+        case DxsoRegisterType::Const3: *pBase = 4096; return true;
+        case DxsoRegisterType::Const4: *pBase = 6144; return true;
+        default: return false;
+      }
+    }
+
+    bool GetBool(uint32_t Index) const {
+      return Index < m_job.boolConstCount
+        && (m_boolConsts[Index / 32] & (1u << (Index % 32)));
+    }
+
+    void Fetch(const DxsoRegister& Reg, Vec& Out) const {
+      uint32_t base = 0;
+
+      if (IsConstantRegister(Reg.id.type, &base)) {
+        for (uint32_t l = 0; l < W; l++) {
+          uint32_t index = base + Reg.id.num + RelativeOffset(Reg, l);
+
+          Vector4 value = index < m_job.floatConstCount
+            ? m_floatConsts[index]
+            : Vector4(0.0f);
+
+          for (uint32_t i = 0; i < 4; i++)
+            Out.c[i][l] = value[i];
+        }
+        return;
+      }
+
+      switch (Reg.id.type) {
+        case DxsoRegisterType::Temp:
+        case DxsoRegisterType::Input: {
+          bool isTemp = Reg.id.type == DxsoRegisterType::Temp;
+
+          const Vec* regs  = isTemp ? m_temps.data() : m_inputs.data();
+          uint32_t   count = isTemp ? DxsoMaxTempRegs : DxsoMaxInterfaceRegs;
+
+          if (!Reg.hasRelative) {
+            Out = Reg.id.num < count ? regs[Reg.id.num] : Vec();
+            return;
+          }
+
+          for (uint32_t l = 0; l < W; l++) {
+            uint32_t index = Reg.id.num + RelativeOffset(Reg, l);
+
+            for (uint32_t i = 0; i < 4; i++)
+              Out.c[i][l] = index < count ? regs[index].c[i][l] : 0.0f;
+          }
+          return;
+        }
+
+        case DxsoRegisterType::ConstInt: {
+          Vector4i value = Reg.id.num < m_job.intConstCount
+            ? m_intConsts[Reg.id.num]
+            : Vector4i(0);
+
+          for (uint32_t i = 0; i < 4; i++) {
+            for (uint32_t l = 0; l < W; l++)
+              Out.c[i][l] = float(value[i]);
+          }
+          return;
+        }
+
+        case DxsoRegisterType::ConstBool: {
+          float value = GetBool(Reg.id.num) ? 1.0f : 0.0f;
+
+          for (uint32_t i = 0; i < 4; i++) {
+            for (uint32_t l = 0; l < W; l++)
+              Out.c[i][l] = value;
+          }
+          return;
+        }
+
+        case DxsoRegisterType::Loop: {
+          for (uint32_t i = 0; i < 4; i++) {
+            for (uint32_t l = 0; l < W; l++)
+              Out.c[i][l] = float(m_loopCounter);
+          }
+          return;
+        }
+
+        case DxsoRegisterType::Addr: {
+          for (uint32_t i = 0; i < 4; i++) {
+            for (uint32_t l = 0; l < W; l++)
+              Out.c[i][l] = float(m_addr[i][l]);
+          }
+          return;
+        }
+
+        case DxsoRegisterType::Predicate: {
+          for (uint32_t i = 0; i < 4; i++) {
+            for (uint32_t l = 0; l < W; l++)
+              Out.c[i][l] = m_pred[i][l] ? 1.0f : 0.0f;
+          }
+          return;
+        }
+
+        default:
+          Out = Vec();
+          return;
+      }
+    }
+
+    void Load(const DxsoRegister& Reg, Vec& Out) const {
+      Vec raw;
+      Fetch(Reg, raw);
+
+      for (uint32_t i = 0; i < 4; i++) {
+        uint32_t component = Reg.swizzle[i];
+
+        for (uint32_t l = 0; l < W; l++) {
+          float x = raw.c[component][l];
+
+          switch (Reg.modifier) {
+            case DxsoRegModifier::None:                               break;
+            case DxsoRegModifier::Neg:     x = -x;                    break;
+            case DxsoRegModifier::Bias:    x = x - 0.5f;              break;
+            case DxsoRegModifier::BiasNeg: x = -(x - 0.5f);           break;
+            case DxsoRegModifier::Sign:    x = 2.0f * x - 1.0f;       break;
+            case DxsoRegModifier::SignNeg: x = -(2.0f * x - 1.0f);    break;
+            case DxsoRegModifier::Comp:    x = 1.0f - x;              break;
+            case DxsoRegModifier::X2:      x = 2.0f * x;              break;
+            case DxsoRegModifier::X2Neg:   x = -2.0f * x;             break;
+            case DxsoRegModifier::Abs:     x = std::abs(x);           break;
+            case DxsoRegModifier::AbsNeg:  x = -std::abs(x);          break;
+            case DxsoRegModifier::Not:     x = x == 0.0f ? 1.0f : 0.0f; break;
+            default:                                                  break;
+          }
+
+          Out.c[i][l] = x;
+        }
+      }
+    }
+
+    void LoadRow(const DxsoRegister& Reg, uint32_t Row, Vec& Out) const {
+      DxsoRegister reg = Reg;
+      reg.id.num += Row;
+      Load(reg, Out);
+    }
+
+    Vec* GetOutputPtr(const DxsoRegister& Reg) {
+      uint32_t index = Reg.id.num;
+
+      switch (Reg.id.type) {
+        case DxsoRegisterType::Temp:
+          return index < DxsoMaxTempRegs ? &m_temps[index] : nullptr;
+
+        case DxsoRegisterType::RasterizerOut:
+          index += D3D9SWVPProgram::OutputSlotRasterizer;
+          break;
+
+        case DxsoRegisterType::AttributeOut:
+          index += D3D9SWVPProgram::OutputSlotAttribute;
+          break;
+
+        case DxsoRegisterType::Output:
+          if (m_program.GetInfo().majorVersion() < 3)
+            index += D3D9SWVPProgram::OutputSlotTexcoord;
+          else if (Reg.hasRelative)
+            index += m_loopCounter;
+          break;
+
+        default:
+          return nullptr;
+      }
+
+      return index < D3D9SWVPProgram::MaxOutputs ? &m_outputs[index] : nullptr;
+    }
+
+    void Store(const D3D9SWVPInstruction& Ins, const Vec& Value) {
+      const DxsoRegister& dst = Ins.dst;
+
+      DxsoRegMask mask = dst.mask;
+
+      if (dst.id == DxsoRegisterId { DxsoRegisterType::RasterizerOut, RasterOutFog }
+       || dst.id == DxsoRegisterId { DxsoRegisterType::RasterizerOut, RasterOutPointSize })
+        mask = DxsoRegMask(true, false, false, false);
+
+      Vec pred;
+
+      if (Ins.predicated)
+        Load(Ins.pred, pred);
+
+      auto writeLane = [&] (uint32_t i, uint32_t l) {
+        return !Ins.predicated || pred.c[i][l] != 0.0f;
+      };
+
+      if (dst.id.type == DxsoRegisterType::Addr) {
+        // Shader model 1.1 truncates towards negative infinity
+        bool floor = m_program.GetInfo().majorVersion() < 2
+                  && m_program.GetInfo().minorVersion() < 2;
+
+        for (uint32_t i = 0; i < 4; i++) {
+          if (!mask[i])
+            continue;
+
+          for (uint32_t l = 0; l < W; l++) {
+            if (writeLane(i, l)) {
+              float value = floor ? std::floor(Value.c[i][l]) : std::floor(Value.c[i][l] + 0.5f);
+              m_addr[i][l] = int32_t(fclamp(value, -65536.0f, 65536.0f));
+            }
+          }
+        }
+        return;
+      }
+
+      if (dst.id.type == DxsoRegisterType::Predicate) {
+        for (uint32_t i = 0; i < 4; i++) {
+          if (!mask[i])
+            continue;
+
+          for (uint32_t l = 0; l < W; l++) {
+            if (writeLane(i, l))
+              m_pred[i][l] = Value.c[i][l] != 0.0f;
+          }
+        }
+        return;
+      }
+
+      Vec* target = GetOutputPtr(dst);
+
+      if (!target)
+        return;
+
+      for (uint32_t i = 0; i < 4; i++) {
+        if (!mask[i])
+          continue;
+
+        for (uint32_t l = 0; l < W; l++) {
+          float value = Value.c[i][l];
+
+          // Saturate flushes NaN to zero
+          if (dst.saturate)
+            value = value > 0.0f ? std::min(value, 1.0f) : 0.0f;
+
+          if (writeLane(i, l))
+            target->c[i][l] = value;
+        }
+      }
+    }
+
+    bool EvalComparison(DxsoComparison Comparison, float A, float B) const {
+      uint32_t bits = uint32_t(Comparison);
+
+      return ((bits & 4) && A <  B)
+          || ((bits & 2) && A == B)
+          || ((bits & 1) && A >  B);
+    }
+
+    bool EvalCondition(const D3D9SWVPInstruction& Ins) const {
+      if (Ins.opcode == DxsoOpcode::Ifc || Ins.opcode == DxsoOpcode::BreakC) {
+        Vec a, b;
+        Load(Ins.src[0], a);
+        Load(Ins.src[1], b);
+        return EvalComparison(Ins.comparison, a.c[0][0], b.c[0][0]);
+      }
+
+      // Boolean constants are uniform, predicates are only
+      // used here if the program runs one vertex at a time
+      Vec value;
+      Load(Ins.src[0], value);
+      return value.c[0][0] != 0.0f;
+    }
+
+    void Execute() {
+      const auto& instructions = m_program.GetInstructions();
+
+      small_vector<LoopState, 4> loops;
+
+      uint32_t pc = 0;
+
+      while (pc < instructions.size()) {
+        const D3D9SWVPInstruction& ins = instructions[pc];
+
+        switch (ins.opcode) {
+          case DxsoOpcode::If:
+          case DxsoOpcode::Ifc:
+            pc = EvalCondition(ins) ? pc + 1 : ins.target;
+            break;
+
+          case DxsoOpcode::Else:
+            pc = ins.target;
+            break;
+
+          case DxsoOpcode::EndIf:
+            pc += 1;
+            break;
+
+          case DxsoOpcode::Rep:
+          case DxsoOpcode::Loop: {
+            Vector4i counter(0);
+
+            const DxsoRegister& reg = ins.opcode == DxsoOpcode::Rep ? ins.src[0] : ins.src[1];
+
+            if (reg.id.num < m_job.intConstCount)
+              counter = m_intConsts[reg.id.num];
+
+            // D3D9 caps loops at 255 iterations
+            int32_t count = std::min(counter.x, 255);
+
+            if (count <= 0) {
+              pc = ins.target + 1;
+              break;
+            }
+
+            LoopState loop;
+            loop.start       = pc + 1;
+            loop.remaining   = count;
+            loop.step        = ins.opcode == DxsoOpcode::Loop ? counter.z : 0;
+            loop.prevCounter = m_loopCounter;
+            loops.push_back(loop);
+
+            if (ins.opcode == DxsoOpcode::Loop)
+              m_loopCounter = counter.y;
+
+            pc += 1;
+            break;
+          }
+
+          case DxsoOpcode::EndRep:
+          case DxsoOpcode::EndLoop: {
+            LoopState& loop = loops[loops.size() - 1];
+
+            if (--loop.remaining > 0) {
+              m_loopCounter += loop.step;
+              pc = loop.start;
+            } else {
+              m_loopCounter = loop.prevCounter;
+              loops.pop_back();
+              pc += 1;
+            }
+            break;
+          }
+
+          case DxsoOpcode::Break:
+          case DxsoOpcode::BreakC:
+          case DxsoOpcode::BreakP:
+            if (ins.opcode == DxsoOpcode::Break || EvalCondition(ins)) {
+              m_loopCounter = loops[loops.size() - 1].prevCounter;
+              loops.pop_back();
+              pc = ins.target;
+            } else {
+              pc += 1;
+            }
+            break;
+
+          default:
+            ExecuteAlu(ins);
+            pc += 1;
+        }
+      }
+    }
+
+    void ExecuteAlu(const D3D9SWVPInstruction& Ins) {
+      Vec a, b, c, r = { };
+
+      auto forEach = [&] (auto&& fn) {
+        for (uint32_t i = 0; i < 4; i++) {
+          for (uint32_t l = 0; l < W; l++)
+            r.c[i][l] = fn(i, l);
+        }
+      };
+
+      auto dot = [&] (const Vec& x, const Vec& y, uint32_t count, uint32_t l) {
+        float result = 0.0f;
+
+        for (uint32_t i = 0; i < count; i++)
+          result += Mul(x.c[i][l], y.c[i][l]);
+
+        return result;
+      };
+
+      switch (Ins.opcode) {
+        case DxsoOpcode::Mov:
+        case DxsoOpcode::Mova:
+          Load(Ins.src[0], r);
+          break;
+
+        case DxsoOpcode::Add:
+          Load(Ins.src[0], a); Load(Ins.src[1], b);
+          forEach([&] (uint32_t i, uint32_t l) { return a.c[i][l] + b.c[i][l]; });
+          break;
+
+        case DxsoOpcode::Sub:
+          Load(Ins.src[0], a); Load(Ins.src[1], b);
+          forEach([&] (uint32_t i, uint32_t l) { return a.c[i][l] - b.c[i][l]; });
+          break;
+
+        case DxsoOpcode::Mul:
+          Load(Ins.src[0], a); Load(Ins.src[1], b);
+          forEach([&] (uint32_t i, uint32_t l) { return Mul(a.c[i][l], b.c[i][l]); });
+          break;
+
+        case DxsoOpcode::Mad:
+          Load(Ins.src[0], a); Load(Ins.src[1], b); Load(Ins.src[2], c);
+          forEach([&] (uint32_t i, uint32_t l) { return Mul(a.c[i][l], b.c[i][l]) + c.c[i][l]; });
+          break;
+
+        case DxsoOpcode::Min:
+          Load(Ins.src[0], a); Load(Ins.src[1], b);
+          forEach([&] (uint32_t i, uint32_t l) { return std::min(a.c[i][l], b.c[i][l]); });
+          break;
+
+        case DxsoOpcode::Max:
+          Load(Ins.src[0], a); Load(Ins.src[1], b);
+          forEach([&] (uint32_t i, uint32_t l) { return std::max(a.c[i][l], b.c[i][l]); });
+          break;
+
+        case DxsoOpcode::Slt:
+          Load(Ins.src[0], a); Load(Ins.src[1], b);
+          forEach([&] (uint32_t i, uint32_t l) { return a.c[i][l] < b.c[i][l] ? 1.0f : 0.0f; });
+          break;
+
+        case DxsoOpcode::Sge:
+          Load(Ins.src[0], a); Load(Ins.src[1], b);
+          forEach([&] (uint32_t i, uint32_t l) { return a.c[i][l] >= b.c[i][l] ? 1.0f : 0.0f; });
+          break;
+
+        case DxsoOpcode::Rcp:
+          Load(Ins.src[0], a);
+          forEach([&] (uint32_t i, uint32_t l) { return ClampMax(1.0f / a.c[i][l]); });
+          break;
+
+        case DxsoOpcode::Rsq:
+          Load(Ins.src[0], a);
+          forEach([&] (uint32_t i, uint32_t l) { return ClampMax(1.0f / std::sqrt(std::abs(a.c[i][l]))); });
+          break;
+
+        case DxsoOpcode::Dp3:
+          Load(Ins.src[0], a); Load(Ins.src[1], b);
+          forEach([&] (uint32_t i, uint32_t l) { return dot(a, b, 3, l); });
+          break;
+
+        case DxsoOpcode::Dp4:
+          Load(Ins.src[0], a); Load(Ins.src[1], b);
+          forEach([&] (uint32_t i, uint32_t l) { return dot(a, b, 4, l); });
+          break;
+
+        case DxsoOpcode::ExpP:
+          if (m_program.GetInfo().majorVersion() < 2) {
+            Load(Ins.src[0], a);
+            forEach([&] (uint32_t i, uint32_t l) {
+              float x = a.c[0][l];
+
+              switch (i) {
+                case 0:  return ClampMax(std::exp2(std::floor(x)));
+                case 1:  return x - std::floor(x);
+                case 2:  return ClampMax(std::exp2(x));
+                default: return 1.0f;
+              }
+            });
+            break;
+          }
+          [[fallthrough]];
+
+        case DxsoOpcode::Exp:
+          Load(Ins.src[0], a);
+          forEach([&] (uint32_t i, uint32_t l) { return ClampMax(std::exp2(a.c[i][l])); });
+          break;
+
+        case DxsoOpcode::Log:
+        case DxsoOpcode::LogP:
+          Load(Ins.src[0], a);
+          forEach([&] (uint32_t i, uint32_t l) {
+            float x = std::log2(std::abs(a.c[i][l]));
+            return m_clamp ? std::max(x, -FLT_MAX) : x;
+          });
+          break;
+
+        case DxsoOpcode::Lit:
+          Load(Ins.src[0], a);
+          forEach([&] (uint32_t i, uint32_t l) {
+            float x = a.c[0][l];
+            float y = a.c[1][l];
+            float w = fclamp(a.c[3][l], -127.9961f, 127.9961f);
+
+            switch (i) {
+              case 1:  return std::max(x, 0.0f);
+              case 2:  return (x >= 0.0f && y >= 0.0f) ? std::pow(std::max(y, 0.0f), w) : 0.0f;
+              default: return 1.0f;
+            }
+          });
+          break;
+
+        case DxsoOpcode::Dst:
+          Load(Ins.src[0], a); Load(Ins.src[1], b);
+          forEach([&] (uint32_t i, uint32_t l) {
+            switch (i) {
+              case 1:  return Mul(a.c[1][l], b.c[1][l]);
+              case 2:  return a.c[2][l];
+              case 3:  return b.c[3][l];
+              default: return 1.0f;
+            }
+          });
+          break;
+
+        case DxsoOpcode::Lrp:
+          Load(Ins.src[0], a); Load(Ins.src[1], b); Load(Ins.src[2], c);
+          forEach([&] (uint32_t i, uint32_t l) { return c.c[i][l] + a.c[i][l] * (b.c[i][l] - c.c[i][l]); });
+          break;
+
+        case DxsoOpcode::Frc:
+          Load(Ins.src[0], a);
+          forEach([&] (uint32_t i, uint32_t l) { return a.c[i][l] - std::floor(a.c[i][l]); });
+          break;
+
+        case DxsoOpcode::Pow:
+          Load(Ins.src[0], a); Load(Ins.src[1], b);
+          forEach([&] (uint32_t i, uint32_t l) { return std::pow(std::abs(a.c[i][l]), b.c[i][l]); });
+          break;
+
+        case DxsoOpcode::Crs:
+          Load(Ins.src[0], a); Load(Ins.src[1], b);
+          forEach([&] (uint32_t i, uint32_t l) {
+            if (i > 2)
+              return 0.0f;
+
+            uint32_t j = (i + 1) % 3;
+            uint32_t k = (i + 2) % 3;
+            return Mul(a.c[j][l], b.c[k][l]) - Mul(a.c[k][l], b.c[j][l]);
+          });
+          break;
+
+        case DxsoOpcode::Abs:
+          Load(Ins.src[0], a);
+          forEach([&] (uint32_t i, uint32_t l) { return std::abs(a.c[i][l]); });
+          break;
+
+        case DxsoOpcode::Sgn:
+          Load(Ins.src[0], a);
+          forEach([&] (uint32_t i, uint32_t l) {
+            float x = a.c[i][l];
+            return x > 0.0f ? 1.0f : (x < 0.0f ? -1.0f : 0.0f);
+          });
+          break;
+
+        case DxsoOpcode::Nrm:
+          Load(Ins.src[0], a);
+          forEach([&] (uint32_t i, uint32_t l) {
+            float lengthSqr = a.c[0][l] * a.c[0][l]
+                            + a.c[1][l] * a.c[1][l]
+                            + a.c[2][l] * a.c[2][l];
+            return Mul(a.c[i][l], ClampMax(1.0f / std::sqrt(lengthSqr)));
+          });
+          break;
+
+        case DxsoOpcode::SinCos:
+          Load(Ins.src[0], a);
+          forEach([&] (uint32_t i, uint32_t l) {
+            switch (i) {
+              case 0:  return std::cos(a.c[0][l]);
+              case 1:  return std::sin(a.c[0][l]);
+              default: return 0.0f;
+            }
+          });
+          break;
+
+        case DxsoOpcode::M4x4:
+        case DxsoOpcode::M4x3:
+        case DxsoOpcode::M3x4:
+        case DxsoOpcode::M3x3:
+        case DxsoOpcode::M3x2: {
+          uint32_t dotCount = (Ins.opcode == DxsoOpcode::M4x4 || Ins.opcode == DxsoOpcode::M4x3) ? 4 : 3;
+          uint32_t rowCount = Ins.opcode == DxsoOpcode::M3x2 ? 2
+                            : (Ins.opcode == DxsoOpcode::M4x3 || Ins.opcode == DxsoOpcode::M3x3) ? 3 : 4;
+
+          Load(Ins.src[0], a);
+
+          for (uint32_t i = 0; i < rowCount; i++) {
+            LoadRow(Ins.src[1], i, b);
+
+            for (uint32_t l = 0; l < W; l++)
+              r.c[i][l] = dot(a, b, dotCount, l);
+          }
+          break;
+        }
+
+        case DxsoOpcode::SetP:
+          Load(Ins.src[0], a); Load(Ins.src[1], b);
+          forEach([&] (uint32_t i, uint32_t l) {
+            return EvalComparison(Ins.comparison, a.c[i][l], b.c[i][l]) ? 1.0f : 0.0f;
+          });
+          break;
+
+        default:
+          return;
+      }
+
+      Store(Ins, r);
+    }
+
+  };
+
+
+  template <uint32_t W>
+  static void ExecuteVertices(
+    const D3D9SWVPJob&    Job,
+    const Vector4*        pFloatConsts,
+    const Vector4i*       pIntConsts,
+    const uint32_t*       pBoolConsts,
+          uint32_t        First,
+          uint32_t        Count) {
+    D3D9SWVPExecutor<W> executor(Job, pFloatConsts, pIntConsts, pBoolConsts);
+
+    for (uint32_t i = 0; i < Count; i += W)
+      executor.Run(First + i, std::min(Count - i, W));
+  }
+
+
+  D3D9SWVPProcessor::D3D9SWVPProcessor() {
+
+  }
+
+
+  D3D9SWVPProcessor::~D3D9SWVPProcessor() {
+    { std::unique_lock lock(m_workerMutex);
+      m_stopWorkers = true;
+    }
+
+    m_workerCond.notify_all();
+
+    for (auto& worker : m_workers)
+      worker.join();
+  }
+
+
+  bool D3D9SWVPProcessor::FindProgram(
+    const DxvkShaderKey&  Key,
+          Rc<D3D9SWVPProgram>* pProgram) {
+    std::lock_guard lock(m_programMutex);
+
+    auto entry = m_programs.find(Key);
+
+    if (entry == m_programs.end())
+      return false;
+
+    *pProgram = entry->second->IsSupported() ? entry->second : nullptr;
+    return true;
+  }
+
+
+  Rc<D3D9SWVPProgram> D3D9SWVPProcessor::GetProgram(
+    const DxvkShaderKey&  Key,
+    const void*           pShaderBytecode) {
+    std::lock_guard lock(m_programMutex);
+
+    auto entry = m_programs.find(Key);
+
+    if (entry == m_programs.end()) {
+      Rc<D3D9SWVPProgram> program = new D3D9SWVPProgram(pShaderBytecode);
+
+      if (!program->IsSupported())
+        Logger::warn(str::format("D3D9SWVPProcessor: Shader ", Key.toString(), " not supported"));
+
+      entry = m_programs.insert({ Key, std::move(program) }).first;
+    }
+
+    return entry->second->IsSupported() ? entry->second : nullptr;
+  }
+
+
+  void D3D9SWVPProcessor::ProcessVertices(
+    const D3D9SWVPJob&    Job) {
+    // Resolve local constant definitions once per job
+    m_floatConsts.assign(Job.floatConsts, Job.floatConsts + Job.floatConstCount);
+    m_intConsts.assign(Job.intConsts, Job.intConsts + Job.intConstCount);
+    m_boolConsts.assign(Job.boolConsts, Job.boolConsts + divCeil(Job.boolConstCount, 32u));
+
+    Job.program->ApplyDefinitions(
+      m_floatConsts.data(), Job.floatConstCount,
+      m_intConsts.data(), Job.intConstCount,
+      m_boolConsts.data(), Job.boolConstCount);
+
+    m_batchCount = divCeil(Job.vertexCount, BatchSize);
+    m_nextBatch.store(0u, std::memory_order_relaxed);
+
+    if (m_batchCount > 1) {
+      StartWorkers();
+
+      { std::unique_lock lock(m_workerMutex);
+        m_job    = &Job;
+        m_jobId += 1;
+      }
+
+      m_workerCond.notify_all();
+    }
+
+    ProcessBatches(Job);
+
+    if (m_batchCount > 1) {
+      std::unique_lock lock(m_workerMutex);
+
+      m_doneCond.wait(lock, [this] {
+        return !m_activeWorkers;
+      });
+
+      m_job = nullptr;
+    }
+  }
+
+
+  void D3D9SWVPProcessor::StartWorkers() {
+    if (!m_workers.empty())
+      return;
+
+    // The calling thread takes part in processing as well
+    uint32_t workerCount = dxvk::thread::hardware_concurrency();
+    workerCount = std::clamp(workerCount, 2u, 8u) - 1;
+
+    m_workers.reserve(workerCount);
+
+    for (uint32_t i = 0; i < workerCount; i++)
+      m_workers.emplace_back([this] { RunWorker(); });
+  }
+
+
+  void D3D9SWVPProcessor::RunWorker() {
+    env::setThreadName("dxvk-swvp");
+
+    uint64_t lastJobId = 0;
+
+    while (true) {
+      const D3D9SWVPJob* job;
+
+      { std::unique_lock lock(m_workerMutex);
+
+        m_workerCond.wait(lock, [this, lastJobId] {
+          return m_stopWorkers || m_jobId != lastJobId;
+        });
+
+        if (m_stopWorkers)
+          return;
+
+        lastJobId = m_jobId;
+
+        // The job may already be complete by the time we wake up
+        if (!(job = m_job))
+          continue;
+
+        m_activeWorkers += 1;
+      }
+
+      ProcessBatches(*job);
+
+      { std::unique_lock lock(m_workerMutex);
+
+        if (!(--m_activeWorkers))
+          m_doneCond.notify_one();
+      }
+    }
+  }
+
+
+  void D3D9SWVPProcessor::ProcessBatches(
+    const D3D9SWVPJob&    Job) {
+    uint32_t batch;
+
+    while ((batch = m_nextBatch.fetch_add(1u, std::memory_order_relaxed)) < m_batchCount) {
+      uint32_t first = Job.firstVertex + batch * BatchSize;
+      uint32_t count = std::min(BatchSize, Job.vertexCount - batch * BatchSize);
+
+      if (Job.program->HasDynamicFlowControl()) {
+        ExecuteVertices<1>(Job, m_floatConsts.data(), m_intConsts.data(),
+          m_boolConsts.data(), first, count);
+      } else {
+        ExecuteVertices<4>(Job, m_floatConsts.data(), m_intConsts.data(),
+          m_boolConsts.data(), first, count);
+      }
+    }
+  }
+
+}
@@ -0,0 +1,280 @@
+#pragma once
+
+#include <atomic>
+#include <unordered_map>
+#include <vector>
+
+#include "d3d9_include.h"
+#include "d3d9_options.h"
+
+#include "../dxso/dxso_decoder.h"
+
+#include "../dxvk/dxvk_hash.h"
+#include "../dxvk/dxvk_shader_key.h"
+
+#include "../util/thread.h"
+#include "../util/util_vector.h"
+
+namespace dxvk {
+
+  /**
+   * \brief Decoded vertex shader instruction
+   *
+   * For flow control instructions, \c target stores the index
+   * of the instruction to continue with when the branch is
+   * taken, i.e. the matching \c else, \c endif or loop end.
+   */
+  struct D3D9SWVPInstruction {
+    DxsoOpcode                  opcode;
+    DxsoComparison              comparison;
+    bool                        predicated;
+    DxsoRegister                pred;
+    DxsoRegister                dst;
+    std::array<DxsoRegister, 3> src;
+    uint32_t                    target;
+  };
+
+  /**
+   * \brief Vertex shader decoded for CPU execution
+   *
+   * Decodes DXSO vertex shader bytecode into a flat instruction
+   * list with resolved branch targets. Shaders using features
+   * the interpreter does not handle, such as texture fetches or
+   * subroutines, are marked as unsupported.
+   */
+  class D3D9SWVPProgram : public RcObject {
+
+  public:
+
+    constexpr static uint32_t MaxOutputs = 16;
+
+    /// Output slots used by vertex shaders below 3.0
+    constexpr static uint32_t OutputSlotRasterizer = 0;
+    constexpr static uint32_t OutputSlotAttribute  = 3;
+    constexpr static uint32_t OutputSlotTexcoord   = 5;
+
+    D3D9SWVPProgram(const void* pShaderBytecode);
+
+    bool IsSupported() const {
+      return m_supported;
+    }
+
+    /**
+     * \brief Checks whether branches depend on vertex data
+     *
+     * Such programs are executed one vertex at a time.
+     * \returns \c true if any branch depends on vertex data
+     */
+    bool HasDynamicFlowControl() const {
+      return m_dynamicFlowControl;
+    }
+
+    const DxsoProgramInfo& GetInfo() const {
+      return m_info;
+    }
+
+    const std::vector<D3D9SWVPInstruction>& GetInstructions() const {
+      return m_instructions;
+    }
+
+    uint32_t GetInputMask() const {
+      return m_inputMask;
+    }
+
+    const DxsoSemantic& GetInputSemantic(uint32_t Reg) const {
+      return m_inputSemantics[Reg];
+    }
+
+    /**
+     * \brief Finds the output slot for a semantic
+     *
+     * \param [in] Semantic Output semantic
+     * \returns Output slot, or \c MaxOutputs if not written
+     */
+    uint32_t FindOutput(DxsoSemantic Semantic) const;
+
+    /**
+     * \brief Overrides constants with local definitions
+     *
+     * \param [in,out] pFloats Float constants
+     * \param [in] FloatCount Number of float constants
+     * \param [in,out] pInts Integer constants
+     * \param [in] IntCount Number of integer constants
+     * \param [in,out] pBools Boolean constant bit field
+     * \param [in] BoolCount Number of boolean constants
+     */
+    void ApplyDefinitions(
+            Vector4*        pFloats,
+            uint32_t        FloatCount,
+            Vector4i*       pInts,
+            uint32_t        IntCount,
+            uint32_t*       pBools,
+            uint32_t        BoolCount) const;
+
+  private:
+
+    struct Definition {
+      uint32_t       reg;
+      DxsoDefinition value;
+    };
+
+    DxsoProgramInfo                   m_info;
+
+    bool                              m_supported           = true;
+    bool                              m_dynamicFlowControl  = false;
+
+    std::vector<D3D9SWVPInstruction>  m_instructions;
+
+    uint32_t                          m_inputMask = 0u;
+    std::array<DxsoSemantic, DxsoMaxInterfaceRegs> m_inputSemantics = { };
+
+    uint32_t                          m_outputMask = 0u;
+    std::array<DxsoSemantic, MaxOutputs> m_outputSemantics = { };
+
+    std::vector<Definition>           m_floatDefs;
+    std::vector<Definition>           m_intDefs;
+    std::vector<Definition>           m_boolDefs;
+
+    std::vector<uint32_t>             m_blockStack;
+    std::vector<std::vector<uint32_t>> m_loopBreaks;
+
+    bool ProcessInstruction(
+      const DxsoInstructionContext& Ctx);
+
+  };
+
+
+  /**
+   * \brief Vertex input for CPU vertex processing
+   */
+  struct D3D9SWVPInputElement {
+    uint32_t        reg;
+    const uint8_t*  data;
+    uint32_t        stride;
+    uint32_t        vertexLimit;
+    D3DDECLTYPE     type;
+    bool            instanced;
+  };
+
+  /**
+   * \brief Vertex output for CPU vertex processing
+   */
+  struct D3D9SWVPOutputElement {
+    uint32_t        slot;
+    uint32_t        offset;
+    D3DDECLTYPE     type;
+  };
+
+  /**
+   * \brief CPU vertex processing job
+   *
+   * All pointers must remain valid until
+   * \ref D3D9SWVPProcessor::ProcessVertices returns.
+   */
+  struct D3D9SWVPJob {
+    const D3D9SWVPProgram*              program = nullptr;
+
+    const Vector4*                      floatConsts = nullptr;
+    uint32_t                            floatConstCount = 0;
+    const Vector4i*                     intConsts = nullptr;
+    uint32_t                            intConstCount = 0;
+    const uint32_t*                     boolConsts = nullptr;
+    uint32_t                            boolConstCount = 0;
+
+    std::vector<D3D9SWVPInputElement>   inputs;
+    std::vector<D3D9SWVPOutputElement>  outputs;
+
+    uint32_t                            firstVertex = 0;
+    uint32_t                            vertexCount = 0;
+
+    uint8_t*                            dstData = nullptr;
+    uint32_t                            dstStride = 0;
+
+    D3D9FloatEmulation                  floatEmulation = D3D9FloatEmulation::Disabled;
+  };
+
+
+  /**
+   * \brief CPU vertex processing
+   *
+   * Interprets vertex shaders on the CPU, four vertices at a
+   * time, and splits large jobs across a pool of worker threads.
+   * Does not depend on a Vulkan device, so that it can be used
+   * both as a fallback for \c ProcessVertices and as a reference.
+   */
+  class D3D9SWVPProcessor {
+
+  public:
+
+    D3D9SWVPProcessor();
+
+    ~D3D9SWVPProcessor();
+
+    /**
+     * \brief Looks up an already decoded program
+     *
+     * \param [in] Key Shader key
+     * \param [out] pProgram Program, or \c nullptr if the shader is not supported
+     * \returns \c true if the shader has been decoded before
+     */
+    bool FindProgram(
+      const DxvkShaderKey&  Key,
+            Rc<D3D9SWVPProgram>* pProgram);
+
+    /**
+     * \brief Retrieves decoded program for a shader
+     *
+     * \param [in] Key Shader key
+     * \param [in] pShaderBytecode Shader bytecode
+     * \returns Program, or \c nullptr if the shader is not supported
+     */
+    Rc<D3D9SWVPProgram> GetProgram(
+      const DxvkShaderKey&  Key,
+      const void*           pShaderBytecode);
+
+    /**
+     * \brief Processes vertices
+     *
+     * Blocks until all vertices have been written.
+     * \param [in] Job Job description
+     */
+    void ProcessVertices(
+      const D3D9SWVPJob&    Job);
+
+  private:
+
+    constexpr static uint32_t BatchSize = 256;
+
+    dxvk::mutex                     m_programMutex;
+
+    std::unordered_map<
+      DxvkShaderKey, Rc<D3D9SWVPProgram>,
+      DxvkHash, DxvkEq>             m_programs;
+
+    std::vector<Vector4>            m_floatConsts;
+    std::vector<Vector4i>           m_intConsts;
+    std::vector<uint32_t>           m_boolConsts;
+
+    dxvk::mutex                     m_workerMutex;
+    dxvk::condition_variable        m_workerCond;
+    dxvk::condition_variable        m_doneCond;
+    std::vector<dxvk::thread>       m_workers;
+
+    const D3D9SWVPJob*              m_job           = nullptr;
+    uint64_t                        m_jobId         = 0;
+    uint32_t                        m_activeWorkers = 0;
+    bool                            m_stopWorkers   = false;
+
+    std::atomic<uint32_t>           m_nextBatch     = { 0u };
+    uint32_t                        m_batchCount    = 0;
+
+    void StartWorkers();
+
+    void RunWorker();
+
+    void ProcessBatches(
+      const D3D9SWVPJob&    Job);
+
+  };
+
+}
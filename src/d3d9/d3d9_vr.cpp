@@ -7,8 +7,18 @@
 
 #include "d3d9_device.h"
 
+#include <cstring>
+#include <memory>
+#include <unordered_map>
+
 namespace dxvk {
 
+struct D3D9VRImportedImage
+{
+  D3D9_VK_IMAGE_IMPORT_DESC desc;
+  Com<IDirect3DSurface9>    surface;
+};
+
 class D3D9VR final : public ComObjectClamp<IDirect3DVR9>
 {
 public:
@@ -40,28 +50,30 @@ public:
 
     D3D9Surface* surface = static_cast<D3D9Surface*>(pSurface);
     auto* tex = surface->GetCommonTexture();
-    const auto& device = tex->Device();
-    const auto& dxvkdev = device->GetDXVKDevice();
-    DxvkImageCreateInfo info;
-    info.type = VK_IMAGE_TYPE_2D;
-    info.format = static_cast<VkFormat>(format);
-    info.sampleCount = VK_SAMPLE_COUNT_1_BIT;
-    info.extent = { dstWidth, dstHeight, 1 };
-    info.numLayers = 1;
-    info.mipLevels = 1;
-    info.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT;
-    info.stages = VK_PIPELINE_STAGE_TRANSFER_BIT;
-    info.access = VK_ACCESS_TRANSFER_WRITE_BIT;
-    info.tiling = VK_IMAGE_TILING_OPTIMAL;
-    info.layout = VK_IMAGE_LAYOUT_UNDEFINED;
-    info.shared = VK_FALSE;
-    info.viewFormats = reinterpret_cast<VkFormat*>(&format);
-    info.viewFormatCount = 1;
-
-    auto dstImg = Rc(new DxvkImage(device->GetDXVKDevice().ptr(), info, dst, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT));
+    auto* device = tex->Device();
+
+    D3D9DeviceLock lock = device->LockDevice();
+    device->GetVRFrameTimings().BeginGpuCopy();
+
+    auto dstImg = device->GetImportedImage(dst, VkFormat(format), VkExtent3D { dstWidth, dstHeight, 1u });
     return device->CopyTextureToVkImage(tex, dstImg);
   }
 
+  HRESULT STDMETHODCALLTYPE InvalidateVulkanImageCache(const VkImage* pImages, UINT imageCount)
+  {
+    D3D9DeviceLock lock = m_device->LockDevice();
+
+    if (pImages == nullptr) {
+      m_device->InvalidateImportedImages(VK_NULL_HANDLE);
+      return D3D_OK;
+    }
+
+    for (UINT i = 0; i < imageCount; i++)
+      m_device->InvalidateImportedImages(pImages[i]);
+
+    return D3D_OK;
+  }
+
   HRESULT STDMETHODCALLTYPE GetVRDesc(IDirect3DSurface9* pSurface,
                                       D3D9_TEXTURE_VR_DESC* pDesc)
   {
@@ -130,9 +142,13 @@ public:
   {
     if (flush) {
       m_device->Flush();
-      m_device->SynchronizeCsThread(DxvkCsThread::SynchronizeAll);
+      TimeWait(D3D9VRWaitType::CsSync, [&] {
+        m_device->SynchronizeCsThread(DxvkCsThread::SynchronizeAll);
+      });
     }
-    m_device->GetDXVKDevice()->waitForIdle();
+    TimeWait(D3D9VRWaitType::QueueIdle, [&] {
+      m_device->GetDXVKDevice()->waitForIdle();
+    });
     return D3D_OK;
   }
 
@@ -140,18 +156,34 @@ public:
   {
     if (flush) {
       m_device->Flush();
-      m_device->SynchronizeCsThread(DxvkCsThread::SynchronizeAll);
+      TimeWait(D3D9VRWaitType::CsSync, [&] {
+        m_device->SynchronizeCsThread(DxvkCsThread::SynchronizeAll);
+      });
     }
     auto device = m_device->GetDXVKDevice();
-    device->vkd()->vkQueueWaitIdle(device->queues().graphics.queueHandle);
+    TimeWait(D3D9VRWaitType::QueueIdle, [&] {
+      device->vkd()->vkQueueWaitIdle(device->queues().graphics.queueHandle);
+    });
     return D3D_OK;
   }
 
   HRESULT STDMETHODCALLTYPE BeginVRSubmit()
   {
     // m_device->Flush();
-    m_device->SynchronizeCsThread(DxvkCsThread::SynchronizeAll);
-    m_device->GetDXVKDevice()->lockSubmission();
+    {
+      D3D9DeviceLock lock = m_device->LockDevice();
+
+      auto& timings = m_device->GetVRFrameTimings();
+      timings.EndGpuCopy();
+      timings.RecordCsLag(m_device->GetCsSequenceLag());
+    }
+
+    TimeWait(D3D9VRWaitType::CsSync, [&] {
+      m_device->SynchronizeCsThread(DxvkCsThread::SynchronizeAll);
+    });
+    TimeWait(D3D9VRWaitType::Submit, [&] {
+      m_device->GetDXVKDevice()->lockSubmission();
+    });
 
     return D3D_OK;
   }
@@ -159,19 +191,26 @@ public:
   HRESULT STDMETHODCALLTYPE EndVRSubmit()
   {
     m_device->GetDXVKDevice()->unlockSubmission();
+
+    D3D9DeviceLock lock = m_device->LockDevice();
+    m_device->GetVRFrameTimings().EndFrame();
     return D3D_OK;
   }
 
   HRESULT STDMETHODCALLTYPE Flush()
   {
     m_device->Flush();
-    m_device->SynchronizeCsThread(DxvkCsThread::SynchronizeAll);
+    TimeWait(D3D9VRWaitType::CsSync, [&] {
+      m_device->SynchronizeCsThread(DxvkCsThread::SynchronizeAll);
+    });
     return D3D_OK;
   }
 
   HRESULT STDMETHODCALLTYPE LockSubmissionQueue()
   {
-    m_device->GetDXVKDevice()->lockSubmission();
+    TimeWait(D3D9VRWaitType::Submit, [&] {
+      m_device->GetDXVKDevice()->lockSubmission();
+    });
     return D3D_OK;
   }
 
@@ -216,9 +255,8 @@ public:
   {
     D3D9Shader<IDirect3DVertexShader9>* shader = reinterpret_cast<D3D9Shader<IDirect3DVertexShader9>*>(d3dShader);
     D3D9CommonShader const* common = shader->GetCommonShader();
-    Rc<DxvkShader> dxvkShader = common->GetShader();
 
-    const auto shaderKey = dxvkShader->getShaderKey().toString();
+    const auto shaderKey = common->GetShaderKey().toString();
     memcpy(out, shaderKey.c_str(), shaderKey.size());
 
     return D3D_OK;
@@ -229,15 +267,11 @@ public:
       D3D9Shader<IDirect3DVertexShader9>* shader = reinterpret_cast<D3D9Shader<IDirect3DVertexShader9>*>(d3dShader);
       D3D9CommonShader const* common = shader->GetCommonShader();
       Rc<DxvkShader> dxvkShader = common->GetShader();
-      SpirvCodeBuffer code = dxvkShader->getRawCode();
 
-      auto c = code.data();
-      if (out != nullptr) {
-          for(int i=0; i < code.dwords(); ++i) {
-              out[i] = c[i];
-          }
-      }
-      *size = code.dwords();
+      if (out != nullptr)
+        dxvkShader->getRawCode(out);
+
+      *size = dxvkShader->getRawCodeSize();
 
       return D3D_OK;
   }
@@ -260,30 +294,16 @@ public:
 
   HRESULT STDMETHODCALLTYPE PatchSPIRVToVertexShader(IDirect3DVertexShader9 *d3dShader, const uint32_t* data, uint32_t size)
   {
-      D3D9Shader<IDirect3DVertexShader9>* shader = reinterpret_cast<D3D9Shader<IDirect3DVertexShader9>*>(d3dShader);
-      D3D9CommonShader const* common = shader->GetCommonShader();
-      Rc<DxvkShader> dxvkShader = common->GetShader();
-  
-      SpirvCodeBuffer codeBuffer(size, data);
-      DxvkShaderCreateInfo info = dxvkShader->info();
-
-      // DXVK shaders copy the binding info into a more clever container
-      // We need to dig it out here and pass it into the constructor again in a DxvkBindingInfo array
-      auto bindings = dxvkShader->getBindings();
-      DxvkBindingInfo* bindingsCopy;
-
-	  if (info.bindingCount > 0) {
-        bindingsCopy = reinterpret_cast<DxvkBindingInfo*>(malloc(sizeof(DxvkBindingInfo) * info.bindingCount));
+      if (unlikely(d3dShader == nullptr || data == nullptr || size == 0))
+        return D3DERR_INVALIDCALL;
 
-        for (int i = 0; i < info.bindingCount; ++i)
-        {
-            bindingsCopy[i] = bindings.getBinding(DxvkDescriptorSets::VsAll, i);
-        }
+      D3D9Shader<IDirect3DVertexShader9>* shader = reinterpret_cast<D3D9Shader<IDirect3DVertexShader9>*>(d3dShader);
+      D3D9CommonShader* common = shader->GetCommonShader_mut();
 
-        info.bindings = bindingsCopy;
-	  }
+      D3D9DeviceLock lock = m_device->LockDevice();
 
-      *dxvkShader.ptr_mut() = DxvkShader(info, std::move(codeBuffer));
+      SetPatchedShader(common, m_device->GetShaderPatchCache().PatchShader(
+        common->GetShaderKey(), common->GetShader(), data, size));
 
       return D3D_OK;
   }
@@ -359,34 +379,459 @@ public:
   HRESULT STDMETHODCALLTYPE CopySurfaceLayers(IDirect3DSurface9 *srcSurface, IDirect3DSurface9** dsts, UINT layerCount)
   {
     // Assumes that `srcSurface` has `layerCount` layers and `dsts` contains `layerCount` of destination surfaces
+    if (unlikely(dsts == nullptr && layerCount))
+      return D3DERR_INVALIDCALL;
+
     D3D9DeviceLock lock = m_device->LockDevice();
     D3D9Surface* src = static_cast<D3D9Surface*>(srcSurface);
 
-    for(int i=0; i<layerCount; ++i) {
-      D3D9Surface* dst = static_cast<D3D9Surface*>(dsts[i]);
-      if (unlikely(src == nullptr || dst == nullptr))
-        return D3DERR_INVALIDCALL;
-      if (unlikely(src == dst))
+    small_vector<D3D9Surface*, caps::MaxViewCount> dstSurfaces;
+
+    for (UINT i = 0; i < layerCount; i++)
+      dstSurfaces.push_back(static_cast<D3D9Surface*>(dsts[i]));
+
+    m_device->GetVRFrameTimings().BeginGpuCopy();
+
+    return m_device->CopySurfaceLayers(src, dstSurfaces.data(), layerCount);
+  }
+
+  HRESULT STDMETHODCALLTYPE EnableMultiView(bool enable)
+  {
+    D3D9DeviceLock lock = m_device->LockDevice();
+    m_device->SetViewCountFF(enable ? 2 : 1);
+    m_device->SetViewMask(enable ? 0b11u : 0u);
+    return D3D_OK;
+  }
+
+  HRESULT STDMETHODCALLTYPE SetMultiViewMask(UINT viewMask)
+  {
+    if (unlikely(viewMask >> caps::MaxViewCount))
+      return D3DERR_INVALIDCALL;
+
+    D3D9DeviceLock lock = m_device->LockDevice();
+    m_device->SetViewMask(viewMask);
+    return D3D_OK;
+  }
+
+  HRESULT STDMETHODCALLTYPE SetFixedFunctionViewCount(UINT viewCount)
+  {
+    if (unlikely(viewCount == 0 || viewCount > caps::MaxViewCount))
+      return D3DERR_INVALIDCALL;
+
+    D3D9DeviceLock lock = m_device->LockDevice();
+    m_device->SetViewCountFF(viewCount);
+    return D3D_OK;
+  }
+
+  HRESULT STDMETHODCALLTYPE SetInstancedViewCount(UINT viewCount)
+  {
+    if (unlikely(viewCount == 0 || viewCount > caps::MaxViewCount))
+      return D3DERR_INVALIDCALL;
+
+    Rc<DxvkDevice> device = m_device->GetDXVKDevice();
+
+    if (viewCount > 1) {
+      const auto& limits = device->adapter()->deviceProperties().limits;
+
+      if (!device->features().vk12.shaderOutputViewportIndex || limits.maxViewports < viewCount)
+        return D3DERR_NOTAVAILABLE;
+
+      // Instance-rate attributes must advance once per view
+      if (!device->features().extVertexAttributeDivisor.vertexAttributeInstanceRateDivisor)
+        return D3DERR_NOTAVAILABLE;
+    }
+
+    D3D9DeviceLock lock = m_device->LockDevice();
+    m_device->SetInstancedViewCount(viewCount);
+    return D3D_OK;
+  }
+
+  HRESULT STDMETHODCALLTYPE SetViewTransforms(UINT firstView, UINT viewCount, const D3DMATRIX* pViews, const D3DMATRIX* pProjections)
+  {
+    if (unlikely(firstView >= caps::MaxViewCount || viewCount > caps::MaxViewCount - firstView))
+      return D3DERR_INVALIDCALL;
+
+    D3D9DeviceLock lock = m_device->LockDevice();
+    m_device->SetViewTransformsFF(firstView, viewCount, pViews, pProjections);
+    return D3D_OK;
+  }
+
+  HRESULT STDMETHODCALLTYPE SetMultiViewConstantLayout(const D3D9_MULTIVIEW_CONSTANT_LAYOUT* pLayout)
+  {
+    if (unlikely(pLayout == nullptr))
+      return D3DERR_INVALIDCALL;
+
+    const auto& layout = m_device->GetVertexConstantLayout();
+
+    DxsoMultiViewInfo info;
+    info.viewCount     = pLayout->ViewCount;
+    info.firstRegister = pLayout->FirstRegister;
+    info.registerCount = pLayout->RegisterCount;
+    info.viewStride    = pLayout->ViewStride;
+
+    if (info.enabled()) {
+      // The views must not overlap and the last view must fit into the constant buffer
+      uint32_t lastRegister = info.firstRegister + info.registerCount
+                            + (info.viewCount - 1) * info.viewStride;
+
+      if (unlikely(info.viewStride < info.registerCount || lastRegister > layout.floatCount))
         return D3DERR_INVALIDCALL;
+    }
 
-      if (auto ret = m_device->StretchRectInternal(src, nullptr, dst, nullptr, D3DTEXF_NONE, i); ret != D3D_OK) {
-          return ret;
+    D3D9DeviceLock lock = m_device->LockDevice();
+    m_device->SetMultiViewVS(info);
+    return D3D_OK;
+  }
+
+  HRESULT STDMETHODCALLTYPE CreateSurfacesFromVulkanImages(const D3D9_VK_IMAGE_IMPORT_DESC* pDesc, const VkImage* pImages, UINT imageCount, IDirect3DSurface9** ppSurfaces)
+  {
+    if (unlikely(pDesc == nullptr || pImages == nullptr || ppSurfaces == nullptr))
+      return D3DERR_INVALIDCALL;
+
+    for (UINT i = 0; i < imageCount; i++)
+      InitReturnPtr(&ppSurfaces[i]);
+
+    D3D9DeviceLock lock = m_device->LockDevice();
+
+    for (UINT i = 0; i < imageCount; i++) {
+      auto entry = m_importedImages.find(pImages[i]);
+
+      if (entry != m_importedImages.end()) {
+        const auto& desc = entry->second.desc;
+
+        // Image handles may be reused after the original image got destroyed
+        if (desc.Width == pDesc->Width && desc.Height == pDesc->Height
+         && desc.ArraySize == pDesc->ArraySize && desc.Format == pDesc->Format
+         && desc.Usage == pDesc->Usage && desc.Flags == pDesc->Flags) {
+          ppSurfaces[i] = entry->second.surface.ref();
+          continue;
+        }
+
+        m_importedImages.erase(entry);
+      }
+
+      D3D9_COMMON_TEXTURE_DESC desc;
+      desc.Width              = pDesc->Width;
+      desc.Height             = pDesc->Height;
+      desc.Depth              = 1;
+      desc.ArraySize          = std::max(pDesc->ArraySize, 1u);
+      desc.MipLevels          = 1;
+      desc.Usage              = D3DUSAGE_RENDERTARGET;
+      desc.Format             = EnumerateFormat(pDesc->Format);
+      desc.Pool               = D3DPOOL_DEFAULT;
+      desc.Discard            = FALSE;
+      desc.MultiSample        = D3DMULTISAMPLE_NONE;
+      desc.MultisampleQuality = 0;
+      desc.IsBackBuffer       = FALSE;
+      desc.IsAttachmentOnly   = TRUE;
+      desc.IsLockable         = FALSE;
+
+      D3D9_COMMON_TEXTURE_IMPORT_INFO importInfo;
+      importInfo.Image = pImages[i];
+      importInfo.Usage = pDesc->Usage;
+      importInfo.Flags = pDesc->Flags;
+
+      IDirect3DSurface9* surface = nullptr;
+
+      if (HRESULT hr = m_device->CreateRenderTargetFromVkImage(&desc, &importInfo, &surface); FAILED(hr)) {
+        for (UINT j = 0; j < i; j++) {
+          ppSurfaces[j]->Release();
+          ppSurfaces[j] = nullptr;
+        }
+
+        return hr;
       }
+
+      D3D9VRImportedImage& image = m_importedImages[pImages[i]];
+      image.desc    = *pDesc;
+      image.surface = surface;
+
+      ppSurfaces[i] = surface;
     }
 
     return D3D_OK;
   }
 
-  HRESULT STDMETHODCALLTYPE EnableMultiView(bool enable)
+  HRESULT STDMETHODCALLTYPE ReleaseVulkanImageSurfaces(const VkImage* pImages, UINT imageCount)
+  {
+    if (unlikely(pImages == nullptr && imageCount))
+      return D3DERR_INVALIDCALL;
+
+    D3D9DeviceLock lock = m_device->LockDevice();
+
+    for (UINT i = 0; i < imageCount; i++)
+      m_importedImages.erase(pImages[i]);
+
+    return D3D_OK;
+  }
+
+  HRESULT STDMETHODCALLTYPE GetVRSubmitSemaphore(VkSemaphore* pSemaphore)
   {
-      m_device->SetMultiViewFF(enable);
+    if (unlikely(pSemaphore == nullptr))
+      return D3DERR_INVALIDCALL;
+
+    *pSemaphore = GetSubmitFence()->handle();
+    return D3D_OK;
+  }
+
+  HRESULT STDMETHODCALLTYPE SignalVRSubmit(uint64_t* pValue)
+  {
+    const auto& fence = GetSubmitFence();
+
+    // Values must be signaled in order, so hold the device
+    // lock across both the increment and the CS command
+    D3D9DeviceLock lock = m_device->LockDevice();
+    uint64_t value = ++m_submitValue;
+
+    auto& timings = m_device->GetVRFrameTimings();
+    timings.RecordCsLag(m_device->GetCsSequenceLag());
+    timings.EndFrame();
+
+    m_device->SignalFence(fence, value);
+
+    if (pValue != nullptr)
+      *pValue = value;
+
+    return D3D_OK;
+  }
+
+  HRESULT STDMETHODCALLTYPE LockVRQueue()
+  {
+    TimeWait(D3D9VRWaitType::QueueLock, [&] {
+      m_device->GetDXVKDevice()->lockDeviceQueue();
+    });
+    return D3D_OK;
+  }
+
+  HRESULT STDMETHODCALLTYPE GetVRFrameTimings(D3D9_VR_FRAME_TIMING* pTimings, UINT* pCount)
+  {
+    if (unlikely(pCount == nullptr))
+      return D3DERR_INVALIDCALL;
+
+    auto& timings = m_device->GetVRFrameTimings();
+
+    if (pTimings == nullptr) {
+      *pCount = timings.GetFrames(nullptr, 0);
       return D3D_OK;
+    }
+
+    std::array<D3D9VRFrameTiming, D3D9VRFrameTimings::MaxFrames> frames;
+    uint32_t count = timings.GetFrames(frames.data(), std::min<UINT>(*pCount, frames.size()));
+
+    auto toMs = [] (uint64_t us) {
+      return float(us) / 1000.0f;
+    };
+
+    for (uint32_t i = 0; i < count; i++) {
+      const auto& frame = frames[i];
+
+      pTimings[i].FrameId         = frame.frameId;
+      pTimings[i].CsSyncMs        = toMs(frame.waitUs[uint32_t(D3D9VRWaitType::CsSync)]);
+      pTimings[i].SubmitWaitMs    = toMs(frame.waitUs[uint32_t(D3D9VRWaitType::Submit)]);
+      pTimings[i].QueueLockWaitMs = toMs(frame.waitUs[uint32_t(D3D9VRWaitType::QueueLock)]);
+      pTimings[i].QueueIdleWaitMs = toMs(frame.waitUs[uint32_t(D3D9VRWaitType::QueueIdle)]);
+      pTimings[i].CsSequenceLag   = frame.csSequenceLag;
+      pTimings[i].GpuCopyMs       = frame.gpuCopyMs;
+    }
+
+    *pCount = count;
+    return D3D_OK;
+  }
+
+  HRESULT STDMETHODCALLTYPE SetSPIRVPatchHash(uint64_t PatchHash)
+  {
+    m_device->GetShaderPatchCache().SetPatchHash(PatchHash);
+    return D3D_OK;
+  }
+
+  HRESULT STDMETHODCALLTYPE ApplyCachedSPIRVPatch(IDirect3DVertexShader9* d3dShader, BOOL* pPatched)
+  {
+    if (unlikely(d3dShader == nullptr || pPatched == nullptr))
+      return D3DERR_INVALIDCALL;
+
+    D3D9Shader<IDirect3DVertexShader9>* shader = reinterpret_cast<D3D9Shader<IDirect3DVertexShader9>*>(d3dShader);
+    D3D9CommonShader* common = shader->GetCommonShader_mut();
+
+    auto& cache = m_device->GetShaderPatchCache();
+
+    D3D9DeviceLock lock = m_device->LockDevice();
+
+    if (!D3D9ShaderPatchCache::IsPatched(common->GetShaderKey(), common->GetShader())) {
+      Rc<DxvkShader> patched = cache.ApplyCachedPatch(common->GetShaderKey(), common->GetShader());
+
+      if (patched != nullptr)
+        SetPatchedShader(common, patched);
+    }
+
+    *pPatched = D3D9ShaderPatchCache::IsPatched(common->GetShaderKey(), common->GetShader());
+    return D3D_OK;
+  }
+
+  HRESULT STDMETHODCALLTYPE UnlockVRQueue()
+  {
+    m_device->GetDXVKDevice()->unlockDeviceQueue();
+    return D3D_OK;
+  }
+
+  HRESULT STDMETHODCALLTYPE GetShaderInfos(IDirect3DVertexShader9* const* ppShaders, UINT shaderCount, D3D9_VR_SHADER_INFO* pInfos, const uint32_t** ppCode)
+  {
+    if (unlikely(ppShaders == nullptr || pInfos == nullptr))
+      return D3DERR_INVALIDCALL;
+
+    // Patching replaces shader code in place, so keep other threads
+    // from patching while we read, and only ever size the arena from
+    // the code we actually copy out.
+    D3D9DeviceLock deviceLock = m_device->LockDevice();
+    std::lock_guard<dxvk::mutex> lock(m_shaderCodeMutex);
+
+    std::vector<SpirvCodeBuffer> shaderCode;
+
+    if (ppCode != nullptr)
+      shaderCode.reserve(shaderCount);
+
+    size_t codeSize = 0;
+
+    for (UINT i = 0; i < shaderCount; i++) {
+      if (unlikely(ppShaders[i] == nullptr))
+        return D3DERR_INVALIDCALL;
+
+      D3D9Shader<IDirect3DVertexShader9>* shader = reinterpret_cast<D3D9Shader<IDirect3DVertexShader9>*>(ppShaders[i]);
+      D3D9CommonShader const* common = shader->GetCommonShader();
+      Rc<DxvkShader> dxvkShader = common->GetShader();
+
+      const auto shaderKey = common->GetShaderKey().toString();
+      std::strncpy(pInfos[i].Hash, shaderKey.c_str(), sizeof(pInfos[i].Hash) - 1);
+      pInfos[i].Hash[sizeof(pInfos[i].Hash) - 1] = '\0';
+
+      pInfos[i].CodeOffset    = uint32_t(codeSize);
+      pInfos[i].ConstantCount = common->GetMeta().maxConstIndexF;
+      pInfos[i].Patched       = D3D9ShaderPatchCache::IsPatched(common->GetShaderKey(), dxvkShader);
+
+      if (ppCode != nullptr) {
+        shaderCode.push_back(dxvkShader->getRawCode());
+        pInfos[i].CodeSize = shaderCode.back().dwords();
+      } else {
+        pInfos[i].CodeSize = uint32_t(dxvkShader->getRawCodeSize());
+      }
+
+      codeSize += pInfos[i].CodeSize;
+    }
+
+    if (ppCode == nullptr)
+      return D3D_OK;
+
+    if (m_shaderCodeCapacity < codeSize) {
+      m_shaderCode = std::make_unique<uint32_t[]>(codeSize);
+      m_shaderCodeCapacity = codeSize;
+    }
+
+    for (UINT i = 0; i < shaderCount; i++) {
+      std::memcpy(&m_shaderCode[pInfos[i].CodeOffset],
+        shaderCode[i].data(), shaderCode[i].size());
+    }
+
+    *ppCode = m_shaderCode.get();
+    return D3D_OK;
+  }
+
+  HRESULT STDMETHODCALLTYPE FreeShaderInfoCode()
+  {
+    std::lock_guard<dxvk::mutex> lock(m_shaderCodeMutex);
+
+    m_shaderCode = nullptr;
+    m_shaderCodeCapacity = 0;
+    return D3D_OK;
+  }
+
+  HRESULT STDMETHODCALLTYPE PatchSPIRVToVertexShaders(IDirect3DVertexShader9* const* ppShaders, const uint32_t* const* ppCode, const uint32_t* pCodeSizes, UINT shaderCount)
+  {
+    if (unlikely(ppShaders == nullptr || ppCode == nullptr || pCodeSizes == nullptr))
+      return D3DERR_INVALIDCALL;
+
+    std::vector<D3D9ShaderPatch> patches(shaderCount);
+    std::vector<D3D9CommonShader*> commons(shaderCount);
+
+    for (UINT i = 0; i < shaderCount; i++) {
+      if (unlikely(ppShaders[i] == nullptr || ppCode[i] == nullptr || pCodeSizes[i] == 0))
+        return D3DERR_INVALIDCALL;
+
+      D3D9Shader<IDirect3DVertexShader9>* shader = reinterpret_cast<D3D9Shader<IDirect3DVertexShader9>*>(ppShaders[i]);
+      D3D9CommonShader* common = shader->GetCommonShader_mut();
+
+      commons[i] = common;
+
+      patches[i].key      = common->GetShaderKey();
+      patches[i].shader   = common->GetShader();
+      patches[i].code     = ppCode[i];
+      patches[i].codeSize = pCodeSizes[i];
+    }
+
+    D3D9DeviceLock lock = m_device->LockDevice();
+    m_device->GetShaderPatchCache().PatchShaders(shaderCount, patches.data());
+
+    for (UINT i = 0; i < shaderCount; i++)
+      SetPatchedShader(commons[i], patches[i].shader);
+
+    return D3D_OK;
   }
 
 private:
   D3D9DeviceEx* m_device;
   D3D9DeviceLock m_lock;
   Rc<DxvkFence> m_fence;
+
+  Rc<DxvkFence> m_submitFence;
+  uint64_t m_submitValue = 0;
+  dxvk::mutex m_submitFenceMutex;
+
+  dxvk::mutex m_shaderCodeMutex;
+  std::unique_ptr<uint32_t[]> m_shaderCode;
+  size_t m_shaderCodeCapacity = 0;
+
+  /**
+   * \brief Makes a shader use patched code
+   *
+   * The patched shader is a new object, so it gets its own pipeline
+   * library and state cache registration rather than reusing those
+   * compiled for the original code. Must be called with the device
+   * lock held.
+   */
+  void SetPatchedShader(D3D9CommonShader* common, const Rc<DxvkShader>& patched)
+  {
+    if (common->GetMultiViewShader() != nullptr)
+      Logger::warn(str::format("D3D9VR: Dropping multiview variant of patched shader ", common->GetShaderKey().toString()));
+
+    common->SetPatchedShader(patched);
+
+    m_device->GetDXVKDevice()->registerShader(patched);
+    m_device->MarkVertexShaderDirty();
+  }
+
+  template<typename Fn>
+  void TimeWait(D3D9VRWaitType type, Fn&& fn)
+  {
+    auto t0 = dxvk::high_resolution_clock::now();
+    fn();
+    auto t1 = dxvk::high_resolution_clock::now();
+
+    m_device->GetVRFrameTimings().AddWaitTime(type, t1 - t0);
+  }
+
+  const Rc<DxvkFence>& GetSubmitFence()
+  {
+    std::lock_guard<dxvk::mutex> lock(m_submitFenceMutex);
+
+    if (m_submitFence == nullptr) {
+      DxvkFenceCreateInfo fenceInfo;
+      fenceInfo.initialValue = 0;
+
+      m_submitFence = m_device->GetDXVKDevice()->createFence(fenceInfo);
+    }
+
+    return m_submitFence;
+  }
+
+  std::unordered_map<VkImage, D3D9VRImportedImage> m_importedImages;
 };
 
 }
@@ -30,6 +30,61 @@ struct OXR_VK_DEVICE_DESC
   uint32_t QueueFamilyIndex;
 };
 
+struct D3D9_MULTIVIEW_CONSTANT_LAYOUT
+{
+  // Number of views. Less than 2 disables native multiview for vertex shaders.
+  uint32_t ViewCount;
+  // First float constant register holding per-view data, e.g. view and projection matrices.
+  uint32_t FirstRegister;
+  // Number of float constant registers holding per-view data.
+  uint32_t RegisterCount;
+  // Register distance between the per-view data of two consecutive views.
+  uint32_t ViewStride;
+};
+
+struct D3D9_VK_IMAGE_IMPORT_DESC
+{
+  uint32_t Width;
+  uint32_t Height;
+  // Number of array layers, e.g. 2 for a multiview swapchain.
+  uint32_t ArraySize;
+  // The image must have been created with the Vulkan format this D3D9 format maps to.
+  D3DFORMAT Format;
+  // Usage and create flags the images were created with. Usage must include color attachment.
+  VkImageUsageFlags Usage;
+  VkImageCreateFlags Flags;
+};
+
+struct D3D9_VR_FRAME_TIMING
+{
+  uint64_t FrameId;
+  // CPU time spent waiting for the CS thread.
+  float CsSyncMs;
+  // CPU time spent in BeginVRSubmit and LockSubmissionQueue waiting for pending submissions.
+  float SubmitWaitMs;
+  // CPU time spent in LockVRQueue.
+  float QueueLockWaitMs;
+  // CPU time spent in WaitDeviceIdle and WaitGraphicsQueueIdle.
+  float QueueIdleWaitMs;
+  // Number of CS chunks not yet executed when the frame was submitted.
+  uint64_t CsSequenceLag;
+  // GPU time from the first eye copy to the end of the frame, or negative if not available yet.
+  float GpuCopyMs;
+};
+
+struct D3D9_VR_SHADER_INFO
+{
+  // Null-terminated key of the original shader, as returned by GetShaderHash.
+  char Hash[64];
+  // Location of the SPIR-V code in the code buffer returned by GetShaderInfos, in dwords.
+  uint32_t CodeOffset;
+  uint32_t CodeSize;
+  // Same as GetShaderConstantCount.
+  uint32_t ConstantCount;
+  // TRUE if the shader code was replaced by PatchSPIRVToVertexShader or the patch cache.
+  BOOL Patched;
+};
+
 // Remember: this class is very similar to D3D9VkInteropDevice introduced later.
 //           Keep an eye on that class for sync changes.
 //
@@ -69,6 +124,88 @@ IDirect3DVR9 : public IUnknown
   virtual HRESULT STDMETHODCALLTYPE GetShaderConstantCount(IDirect3DVertexShader9 *d3dShader, uint32_t* out) = 0;
   virtual HRESULT STDMETHODCALLTYPE SetShaderConstantCount(IDirect3DVertexShader9 *d3dShader, uint32_t constantCount) = 0;
   virtual HRESULT STDMETHODCALLTYPE EnableMultiView(bool enable) = 0;
+
+  // Vertex shaders created after this call get a multiview variant that reads the given
+  // float constant registers at an offset of ViewIndex * ViewStride. The variant is bound
+  // instead of the original shader as long as the layout stays enabled.
+  virtual HRESULT STDMETHODCALLTYPE SetMultiViewConstantLayout(const D3D9_MULTIVIEW_CONSTANT_LAYOUT* pLayout) = 0;
+
+  // Number of views rendered by fixed-function vertex shaders, up to 4. Views take their view
+  // and projection matrices from SetViewTransforms, or D3DTS_VIEW and D3DTS_PROJECTION by default.
+  virtual HRESULT STDMETHODCALLTYPE SetFixedFunctionViewCount(UINT viewCount) = 0;
+
+  // Wraps externally owned images, e.g. OpenXR swapchain images, in render target surfaces
+  // so that the game can render into them directly. The images must be created with color
+  // attachment usage, copies and blits additionally need transfer usage. Images are expected
+  // to be in VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL outside of D3D9 submissions, and are
+  // neither cleared on import nor released on device reset. Surfaces are cached per image
+  // handle and are returned again on subsequent calls with the same description.
+  virtual HRESULT STDMETHODCALLTYPE CreateSurfacesFromVulkanImages(const D3D9_VK_IMAGE_IMPORT_DESC* pDesc, const VkImage* pImages, UINT imageCount, IDirect3DSurface9** ppSurfaces) = 0;
+
+  // Drops cached surfaces for the given images. Must be called before the images are destroyed.
+  virtual HRESULT STDMETHODCALLTYPE ReleaseVulkanImageSurfaces(const VkImage* pImages, UINT imageCount) = 0;
+
+  // CopySurfaceToVulkanImage caches its destination image wrappers per image handle, format
+  // and extent. Call this with the old images when recreating a swapchain, or with a null
+  // pointer to drop all cached wrappers.
+  virtual HRESULT STDMETHODCALLTYPE InvalidateVulkanImageCache(const VkImage* pImages, UINT imageCount) = 0;
+
+  // Asynchronous alternative to BeginVRSubmit/EndVRSubmit. GetVRSubmitSemaphore returns a
+  // timeline semaphore owned by the D3D9 device. SignalVRSubmit queues a signal of that
+  // semaphore after all rendering issued so far and flushes without waiting for the CS
+  // thread, returning the value the compositor should wait for on the GPU. Submissions to
+  // the shared queue must be wrapped in LockVRQueue/UnlockVRQueue, which only block while
+  // DXVK itself is submitting.
+  virtual HRESULT STDMETHODCALLTYPE GetVRSubmitSemaphore(VkSemaphore* pSemaphore) = 0;
+  virtual HRESULT STDMETHODCALLTYPE SignalVRSubmit(uint64_t* pValue) = 0;
+  virtual HRESULT STDMETHODCALLTYPE LockVRQueue() = 0;
+  virtual HRESULT STDMETHODCALLTYPE UnlockVRQueue() = 0;
+
+  // Returns timings for up to *pCount of the most recent VR frames, oldest first. A frame ends
+  // with EndVRSubmit or SignalVRSubmit. If pTimings is null, returns the number of frames available.
+  virtual HRESULT STDMETHODCALLTYPE GetVRFrameTimings(D3D9_VR_FRAME_TIMING* pTimings, UINT* pCount) = 0;
+
+  // Enables the on-disk cache for PatchSPIRVToVertexShader. PatchHash identifies the patch, e.g.
+  // a hash of the patcher version and its settings. Patched code is stored per original shader
+  // and patch hash, and vertex shaders created afterwards get the cached code applied right away.
+  // Set this before creating any shaders so that the state cache can precompile their pipelines.
+  virtual HRESULT STDMETHODCALLTYPE SetSPIRVPatchHash(uint64_t PatchHash) = 0;
+
+  // Applies cached patched code to a shader created before SetSPIRVPatchHash, if there is any.
+  // *pPatched is set to TRUE if the shader is patched, in which case patching can be skipped.
+  virtual HRESULT STDMETHODCALLTYPE ApplyCachedSPIRVPatch(IDirect3DVertexShader9* d3dShader, BOOL* pPatched) = 0;
+
+  // Batched GetShaderHash, GetSPIRVShaderCode and GetShaderConstantCount. If ppCode is not null,
+  // it receives a buffer holding the code of all shaders, which stays valid until the next call
+  // to GetShaderInfos or FreeShaderInfoCode.
+  virtual HRESULT STDMETHODCALLTYPE GetShaderInfos(IDirect3DVertexShader9* const* ppShaders, UINT shaderCount, D3D9_VR_SHADER_INFO* pInfos, const uint32_t** ppCode) = 0;
+  virtual HRESULT STDMETHODCALLTYPE FreeShaderInfoCode() = 0;
+
+  // Batched PatchSPIRVToVertexShader. pCodeSizes are in dwords.
+  virtual HRESULT STDMETHODCALLTYPE PatchSPIRVToVertexShaders(IDirect3DVertexShader9* const* ppShaders, const uint32_t* const* ppCode, const uint32_t* pCodeSizes, UINT shaderCount) = 0;
+
+  // Alternative to native multiview for devices where VK_KHR_multiview is slow or missing. With
+  // more than one view, every draw is replicated into one instance per view and vertex shaders
+  // select their view by instance index. Views are rendered side by side into a single-layer
+  // render target: view N uses the current viewport and scissor rect offset by N viewport widths.
+  // While enabled, fixed-function shaders render this many views; the count set through
+  // SetFixedFunctionViewCount applies again once instancing is disabled. Programmable vertex shaders
+  // need a multiview constant layout and must be created after this call. Returns
+  // D3DERR_NOTAVAILABLE if the device cannot export the viewport index from vertex shaders
+  // or lacks instance rate divisors for per-instance vertex attributes.
+  virtual HRESULT STDMETHODCALLTYPE SetInstancedViewCount(UINT viewCount) = 0;
+
+  // Sets the view and projection matrices of fixed-function views firstView to firstView + viewCount - 1.
+  // These are stored in a separate small constant buffer, so per-frame eye pose updates do not
+  // re-upload the remaining fixed-function constants. Passing nullptr for either array resets
+  // the respective matrices of these views to D3DTS_VIEW or D3DTS_PROJECTION.
+  virtual HRESULT STDMETHODCALLTYPE SetViewTransforms(UINT firstView, UINT viewCount, const D3DMATRIX* pViews, const D3DMATRIX* pProjections) = 0;
+
+  // Sets the native multiview view mask, e.g. 0x3 for stereo or 0xF for quad views. Each set bit
+  // renders one view into the corresponding layer of the bound render targets, which must have
+  // enough layers, see CreateMultiViewRenderTarget. Zero disables native multiview. EnableMultiView
+  // sets this to 0x3 or 0. Pipelines are compiled and cached per view mask.
+  virtual HRESULT STDMETHODCALLTYPE SetMultiViewMask(UINT viewMask) = 0;
 };
 #ifdef _MSC_VER
 struct __declspec(uuid("7e272b32-a49c-46c7-b1a4-ef52936bec87")) IDirect3DVR9;
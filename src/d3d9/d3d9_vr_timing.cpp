@@ -0,0 +1,117 @@
+#include "d3d9_vr_timing.h"
+#include "d3d9_device.h"
+
+namespace dxvk {
+
+  D3D9VRFrameTimings::D3D9VRFrameTimings(D3D9DeviceEx* pDevice)
+    : m_device(pDevice) { }
+
+
+  void D3D9VRFrameTimings::AddWaitTime(
+          D3D9VRWaitType                        Type,
+          dxvk::high_resolution_clock::duration Duration) {
+    std::lock_guard<dxvk::mutex> lock(m_mutex);
+
+    m_current.waitUs[uint32_t(Type)] += std::chrono::duration_cast<std::chrono::microseconds>(Duration).count();
+  }
+
+
+  void D3D9VRFrameTimings::RecordCsLag(uint64_t Lag) {
+    std::lock_guard<dxvk::mutex> lock(m_mutex);
+
+    m_current.csSequenceLag = std::max(m_current.csSequenceLag, Lag);
+  }
+
+
+  void D3D9VRFrameTimings::BeginGpuCopy() {
+    std::lock_guard<dxvk::mutex> lock(m_mutex);
+
+    if (m_gpuCopyStarted)
+      return;
+
+    FrameSlot& slot = CurrentSlot();
+
+    if (slot.gpuBegin == nullptr) {
+      Rc<DxvkDevice> device = m_device->GetDXVKDevice();
+      slot.gpuBegin = device->createGpuQuery(VK_QUERY_TYPE_TIMESTAMP, 0, 0);
+      slot.gpuEnd   = device->createGpuQuery(VK_QUERY_TYPE_TIMESTAMP, 0, 0);
+    }
+
+    m_device->WriteTimestamp(slot.gpuBegin);
+    m_gpuCopyStarted = true;
+  }
+
+
+  void D3D9VRFrameTimings::EndGpuCopy() {
+    std::lock_guard<dxvk::mutex> lock(m_mutex);
+    WriteGpuCopyEnd();
+  }
+
+
+  void D3D9VRFrameTimings::EndFrame() {
+    std::lock_guard<dxvk::mutex> lock(m_mutex);
+    WriteGpuCopyEnd();
+
+    FrameSlot& slot = CurrentSlot();
+    slot.timing = m_current;
+    slot.timing.frameId = m_frameCount;
+    slot.gpuPending = m_gpuCopyStarted;
+
+    m_current = D3D9VRFrameTiming();
+    m_gpuCopyStarted = false;
+    m_gpuCopyEnded   = false;
+    m_frameCount += 1;
+  }
+
+
+  void D3D9VRFrameTimings::WriteGpuCopyEnd() {
+    if (!m_gpuCopyStarted || m_gpuCopyEnded)
+      return;
+
+    m_device->WriteTimestamp(CurrentSlot().gpuEnd);
+    m_gpuCopyEnded = true;
+  }
+
+
+  uint32_t D3D9VRFrameTimings::GetFrames(
+          D3D9VRFrameTiming*  pFrames,
+          uint32_t            MaxCount) {
+    std::lock_guard<dxvk::mutex> lock(m_mutex);
+
+    uint32_t available = uint32_t(std::min<uint64_t>(m_frameCount, MaxFrames));
+
+    if (pFrames == nullptr)
+      return available;
+
+    uint32_t count = std::min(available, MaxCount);
+    uint64_t first = m_frameCount - count;
+
+    for (uint32_t i = 0; i < count; i++) {
+      FrameSlot& slot = m_frames[(first + i) % MaxFrames];
+      ResolveGpuTime(slot);
+      pFrames[i] = slot.timing;
+    }
+
+    return count;
+  }
+
+
+  void D3D9VRFrameTimings::ResolveGpuTime(FrameSlot& Slot) {
+    if (!Slot.gpuPending)
+      return;
+
+    DxvkQueryData begin = { };
+    DxvkQueryData end   = { };
+
+    if (Slot.gpuBegin->getData(begin) != DxvkGpuQueryStatus::Available
+     || Slot.gpuEnd->getData(end) != DxvkGpuQueryStatus::Available)
+      return;
+
+    const auto& limits = m_device->GetDXVKDevice()->adapter()->deviceProperties().limits;
+
+    uint64_t ticks = end.timestamp.time - begin.timestamp.time;
+    Slot.timing.gpuCopyMs = float(double(ticks) * double(limits.timestampPeriod) / 1'000'000.0);
+    Slot.gpuPending = false;
+  }
+
+}
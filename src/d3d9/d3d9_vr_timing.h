@@ -0,0 +1,131 @@
+#pragma once
+
+#include "../dxvk/dxvk_include.h"
+#include "../dxvk/dxvk_gpu_query.h"
+
+#include "../util/thread.h"
+#include "../util/util_time.h"
+
+#include <array>
+
+namespace dxvk {
+
+  class D3D9DeviceEx;
+
+  /**
+   * \brief Blocking operations on the VR submit path
+   */
+  enum class D3D9VRWaitType : uint32_t {
+    CsSync,     ///< Waiting for the CS thread
+    Submit,     ///< Waiting for pending submissions and the queue lock
+    QueueLock,  ///< Waiting for the queue lock only
+    QueueIdle,  ///< Waiting for the device or queue to go idle
+
+    Count
+  };
+
+  /**
+   * \brief Timings of a single VR frame
+   */
+  struct D3D9VRFrameTiming {
+    uint64_t frameId = 0;
+    std::array<uint64_t, size_t(D3D9VRWaitType::Count)> waitUs = { };
+    uint64_t csSequenceLag = 0;
+    float    gpuCopyMs = -1.0f;
+  };
+
+  /**
+   * \brief VR frame timing history
+   *
+   * Records how long the VR submit path blocks on the CPU, how far
+   * the CS thread lags behind when a frame is submitted, and how long
+   * the GPU spends on the eye copies, for the last \c MaxFrames frames.
+   */
+  class D3D9VRFrameTimings {
+
+  public:
+
+    constexpr static uint32_t MaxFrames = 64;
+
+    D3D9VRFrameTimings(D3D9DeviceEx* pDevice);
+
+    /**
+     * \brief Adds blocking time to the current frame
+     */
+    void AddWaitTime(
+            D3D9VRWaitType                        Type,
+            dxvk::high_resolution_clock::duration Duration);
+
+    /**
+     * \brief Records CS thread lag at submission time
+     *
+     * \param [in] Lag Number of CS chunks not yet executed
+     */
+    void RecordCsLag(uint64_t Lag);
+
+    /**
+     * \brief Marks the start of the eye copies
+     *
+     * Writes a GPU timestamp before the first copy of the frame.
+     * Must be called with the device lock held.
+     */
+    void BeginGpuCopy();
+
+    /**
+     * \brief Marks the end of the eye copies
+     *
+     * Writes the closing GPU timestamp if any copies were recorded.
+     * Must be called with the device lock held.
+     */
+    void EndGpuCopy();
+
+    /**
+     * \brief Completes the current frame
+     *
+     * Ends the eye copies if that did not happen yet and moves
+     * the frame into the history. Must be called with the device
+     * lock held.
+     */
+    void EndFrame();
+
+    /**
+     * \brief Retrieves completed frames
+     *
+     * \param [out] pFrames Frame timings, oldest first. May be \c nullptr.
+     * \param [in] MaxCount Number of entries that fit into \c pFrames
+     * \returns Number of frames written, or available if \c pFrames is \c nullptr
+     */
+    uint32_t GetFrames(
+            D3D9VRFrameTiming*  pFrames,
+            uint32_t            MaxCount);
+
+  private:
+
+    struct FrameSlot {
+      D3D9VRFrameTiming timing;
+      Rc<DxvkGpuQuery>  gpuBegin;
+      Rc<DxvkGpuQuery>  gpuEnd;
+      bool              gpuPending = false;
+    };
+
+    D3D9DeviceEx*                   m_device;
+    dxvk::mutex                     m_mutex;
+
+    std::array<FrameSlot, MaxFrames> m_frames;
+    uint64_t                        m_frameCount = 0;
+
+    D3D9VRFrameTiming               m_current;
+    bool                            m_gpuCopyStarted = false;
+    bool                            m_gpuCopyEnded   = false;
+
+    FrameSlot& CurrentSlot() {
+      return m_frames[m_frameCount % MaxFrames];
+    }
+
+    void WriteGpuCopyEnd();
+
+    void ResolveGpuTime(FrameSlot& Slot);
+
+  };
+
+}
@@ -470,6 +470,18 @@ namespace dxvk {
       m_module.defFunctionType(
         m_module.defVoidType(), 0, nullptr));
     this->emitFunctionLabel();
+
+    if (isMultiView()) {
+      // Load this once at the start of vs_main so that
+      // the value dominates every constant access.
+      uint32_t viewIndex = m_moduleInfo.multiView.instanced
+        ? emitInstancedViewIndex()
+        : emitNativeViewIndex();
+
+      m_vs.viewIndex = m_module.opBitcast(
+        getScalarTypeId(DxsoScalarType::Sint32),
+        viewIndex);
+    }
   }
 
 
@@ -898,7 +910,13 @@ namespace dxvk {
     switch (reg.id.type) {
       case DxsoRegisterType::Const:
         if (!relative) {
-          m_meta.maxConstIndexF = std::max(m_meta.maxConstIndexF, reg.id.num + 1);
+          uint32_t lastReg = reg.id.num;
+
+          // The constants of the last view must get uploaded too
+          if (isMultiView() && m_moduleInfo.multiView.contains(reg.id.num))
+            lastReg += (m_moduleInfo.multiView.viewCount - 1) * m_moduleInfo.multiView.viewStride;
+
+          m_meta.maxConstIndexF = std::max(m_meta.maxConstIndexF, lastReg + 1);
           m_meta.maxConstIndexF = std::min(m_meta.maxConstIndexF, m_layout->floatCount);
         } else {
           m_meta.maxConstIndexF = m_layout->floatCount;
@@ -923,6 +941,9 @@ namespace dxvk {
 
     uint32_t relativeIdx = this->emitArrayIndex(reg.id.num, relative);
 
+    if (reg.id.type == DxsoRegisterType::Const && isMultiView())
+      relativeIdx = this->emitMultiViewConstantIndex(relativeIdx, reg, relative);
+
     if (reg.id.type != DxsoRegisterType::ConstBool) {
       uint32_t structIdx;
       uint32_t cBufferId;
@@ -1013,6 +1034,84 @@ namespace dxvk {
   }
 
 
+  uint32_t DxsoCompiler::emitNativeViewIndex() {
+    m_module.enableCapability(spv::CapabilityMultiView);
+
+    uint32_t uintType = getScalarTypeId(DxsoScalarType::Uint32);
+    uint32_t viewIndexPtr = m_module.newVar(
+      m_module.defPointerType(uintType, spv::StorageClassInput),
+      spv::StorageClassInput);
+
+    m_module.setDebugName(viewIndexPtr, "ViewIndex");
+    m_module.decorateBuiltIn(viewIndexPtr, spv::BuiltInViewIndex);
+
+    return m_module.opLoad(uintType, viewIndexPtr);
+  }
+
+
+  uint32_t DxsoCompiler::emitInstancedViewIndex() {
+    m_module.enableCapability(spv::CapabilityMultiViewport);
+    m_module.enableExtension("SPV_EXT_shader_viewport_index_layer");
+    m_module.enableCapability(spv::CapabilityShaderViewportIndexLayerEXT);
+
+    uint32_t uintType = getScalarTypeId(DxsoScalarType::Uint32);
+
+    uint32_t instanceIndexPtr = m_module.newVar(
+      m_module.defPointerType(uintType, spv::StorageClassInput),
+      spv::StorageClassInput);
+
+    m_module.setDebugName(instanceIndexPtr, "InstanceIndex");
+    m_module.decorateBuiltIn(instanceIndexPtr, spv::BuiltInInstanceIndex);
+
+    // Draws are replicated so that consecutive instances
+    // render the same D3D9 instance for different views.
+    uint32_t viewIndex = m_module.opUMod(uintType,
+      m_module.opLoad(uintType, instanceIndexPtr),
+      m_module.constu32(m_moduleInfo.multiView.viewCount));
+
+    uint32_t viewportIndexPtr = m_module.newVar(
+      m_module.defPointerType(uintType, spv::StorageClassOutput),
+      spv::StorageClassOutput);
+
+    m_module.setDebugName(viewportIndexPtr, "o_viewport");
+    m_module.decorateBuiltIn(viewportIndexPtr, spv::BuiltInViewportIndex);
+    m_module.opStore(viewportIndexPtr, viewIndex);
+
+    return viewIndex;
+  }
+
+
+  uint32_t DxsoCompiler::emitMultiViewConstantIndex(
+          uint32_t          index,
+    const DxsoBaseRegister& reg,
+    const DxsoBaseRegister* relative) {
+    const DxsoMultiViewInfo& multiView = m_moduleInfo.multiView;
+
+    if (!relative && !multiView.contains(reg.id.num))
+      return index;
+
+    uint32_t intType  = getScalarTypeId(DxsoScalarType::Sint32);
+    uint32_t boolType = m_module.defBoolType();
+
+    uint32_t viewOffset = m_module.opIMul(intType,
+      m_vs.viewIndex, m_module.consti32(multiView.viewStride));
+    uint32_t viewIdx = m_module.opIAdd(intType, index, viewOffset);
+
+    if (!relative)
+      return viewIdx;
+
+    // With relative addressing, we can only
+    // decide at runtime whether to offset.
+    uint32_t inRange = m_module.opLogicalAnd(boolType,
+      m_module.opSGreaterThanEqual(boolType, index,
+        m_module.consti32(multiView.firstRegister)),
+      m_module.opSLessThan(boolType, index,
+        m_module.consti32(multiView.firstRegister + multiView.registerCount)));
+
+    return m_module.opSelect(intType, inRange, viewIdx, index);
+  }
+
+
   DxsoRegisterPointer DxsoCompiler::emitOutputPtr(
             bool              texcrdOut,
       const DxsoBaseRegister& reg,
@@ -148,6 +148,10 @@ namespace dxvk {
     // Rasterizer output registers
     DxsoRegisterPointer oPos;
     DxsoRegisterPointer oPSize;
+
+    //////////////////////////////
+    // Multiview
+    uint32_t viewIndex        = 0;
   };
 
   /**
@@ -457,6 +461,15 @@ namespace dxvk {
       const DxsoBaseRegister& reg,
       const DxsoBaseRegister* relative);
 
+    uint32_t emitNativeViewIndex();
+
+    uint32_t emitInstancedViewIndex();
+
+    uint32_t emitMultiViewConstantIndex(
+            uint32_t          index,
+      const DxsoBaseRegister& reg,
+      const DxsoBaseRegister* relative);
+
     DxsoRegisterPointer emitOutputPtr(
             bool              texcrdOut,
       const DxsoBaseRegister& reg,
@@ -707,6 +720,11 @@ namespace dxvk {
       return m_layout->bitmaskCount != 1;
     }
 
+    bool isMultiView() {
+      return m_programInfo.type() == DxsoProgramTypes::VertexShader
+          && m_moduleInfo.multiView.enabled();
+    }
+
   };
 
 }
\ No newline at end of file
@@ -4,6 +4,39 @@
 
 namespace dxvk {
 
+  /**
+   * \brief Multiview info
+   *
+   * Describes which float constant registers hold per-view
+   * data, e.g. view and projection matrices. Vertex shaders
+   * compiled with a view count greater than one read those
+   * registers at an offset of \c ViewIndex * \c viewStride.
+   * Instanced views take the view index from the instance
+   * index instead, for devices without native multiview.
+   */
+  struct DxsoMultiViewInfo {
+    /// Number of views, multiview is disabled if this is less than 2
+    uint32_t viewCount     = 0;
+    /// First float constant register holding per-view data
+    uint32_t firstRegister = 0;
+    /// Number of float constant registers holding per-view data
+    uint32_t registerCount = 0;
+    /// Register distance between the data of two consecutive views
+    uint32_t viewStride    = 0;
+    /// Derive the view index from the instance index instead of
+    /// \c ViewIndex and export it as the viewport index. Draws
+    /// are then replicated into \c viewCount instances each.
+    uint32_t instanced     = 0;
+
+    bool enabled() const {
+      return viewCount > 1 && registerCount != 0;
+    }
+
+    bool contains(uint32_t reg) const {
+      return reg >= firstRegister && reg < firstRegister + registerCount;
+    }
+  };
+
   /**
    * \brief Shader module info
    *
@@ -11,7 +44,8 @@ namespace dxvk {
    * This data can be supplied by the client API implementation.
    */
   struct DxsoModuleInfo {
-    DxsoOptions options;
+    DxsoOptions       options;
+    DxsoMultiViewInfo multiView;
   };
 
-}
\ No newline at end of file
+}
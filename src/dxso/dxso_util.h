@@ -28,6 +28,7 @@ namespace dxvk {
     VSClipPlanes     = 3,
     VSFixedFunction  = 4,
     VSVertexBlendData = 5,
+    VSFixedFunctionViews = 6,
     VSCount,
 
     PSConstantBuffer = 0,
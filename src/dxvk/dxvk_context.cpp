@@ -4825,7 +4825,7 @@ namespace dxvk {
     renderingInfo.renderArea.offset = VkOffset2D { 0, 0 };
     renderingInfo.renderArea.extent = VkExtent2D { fbSize.width, fbSize.height };
     renderingInfo.layerCount = fbSize.layers;
-    renderingInfo.viewMask = renderingInfo.layerCount == 4 ? 0b1111 : renderingInfo.layerCount == 2 ? 0b11 : 0;
+    renderingInfo.viewMask = framebufferInfo.getViewMask();
 
     if (colorInfoCount) {
       renderingInfo.colorAttachmentCount = colorInfoCount;
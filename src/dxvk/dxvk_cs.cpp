@@ -2,8 +2,11 @@
 
 namespace dxvk {
   
-  DxvkCsChunk::DxvkCsChunk() {
-    
+  DxvkCsChunk::DxvkCsChunk(size_t blockSize)
+  : m_blockSize (blockSize),
+    m_storage   (new char[blockSize + CACHE_LINE_SIZE]) {
+    m_data = reinterpret_cast<char*>(align(
+      reinterpret_cast<uintptr_t>(m_storage.get()), CACHE_LINE_SIZE));
   }
   
   
@@ -63,24 +66,29 @@ namespace dxvk {
   
   
   DxvkCsChunkPool::~DxvkCsChunkPool() {
-    for (DxvkCsChunk* chunk : m_chunks)
-      delete chunk;
+    for (const auto& chunks : m_chunks) {
+      for (DxvkCsChunk* chunk : chunks)
+        delete chunk;
+    }
   }
   
   
-  DxvkCsChunk* DxvkCsChunkPool::allocChunk(DxvkCsChunkFlags flags) {
+  DxvkCsChunk* DxvkCsChunkPool::allocChunk(
+          DxvkCsChunkFlags  flags,
+          size_t            blockSize) {
     DxvkCsChunk* chunk = nullptr;
 
     { std::lock_guard<dxvk::mutex> lock(m_mutex);
+      auto& chunks = m_chunks[getSizeClass(blockSize)];
       
-      if (m_chunks.size() != 0) {
-        chunk = m_chunks.back();
-        m_chunks.pop_back();
+      if (chunks.size() != 0) {
+        chunk = chunks.back();
+        chunks.pop_back();
       }
     }
     
     if (!chunk)
-      chunk = new DxvkCsChunk();
+      chunk = new DxvkCsChunk(blockSize);
     
     chunk->init(flags);
     return chunk;
@@ -91,7 +99,7 @@ namespace dxvk {
     chunk->reset();
     
     std::lock_guard<dxvk::mutex> lock(m_mutex);
-    m_chunks.push_back(chunk);
+    m_chunks[getSizeClass(chunk->blockSize())].push_back(chunk);
   }
   
   
@@ -115,14 +123,23 @@ namespace dxvk {
   
   
   uint64_t DxvkCsThread::dispatchChunk(DxvkCsChunkRef&& chunk) {
-    uint64_t seq;
+    uint64_t seq = ++m_chunksDispatched;
+    uint64_t head = m_queueHead.load(std::memory_order_relaxed);
 
-    { std::unique_lock<dxvk::mutex> lock(m_mutex);
-      seq = ++m_chunksDispatched;
-      m_chunksQueued.push_back(std::move(chunk));
+    if (unlikely(head - m_queueTail.load(std::memory_order_acquire) >= MaxQueuedChunks))
+      waitForQueueSpace(head);
+
+    m_chunksQueued[head % MaxQueuedChunks] = std::move(chunk);
+
+    // The consumer sets the waiting flag before checking the queue
+    // head, so either it sees the new chunk or we see the flag.
+    m_queueHead.store(head + 1);
+
+    if (m_consumerWaiting.load()) {
+      std::unique_lock<dxvk::mutex> lock(m_mutex);
+      m_condOnAdd.notify_one();
     }
-    
-    m_condOnAdd.notify_one();
+
     return seq;
   }
   
@@ -154,44 +171,90 @@ namespace dxvk {
   }
   
   
+  void DxvkCsThread::waitForQueueSpace(uint64_t head) {
+    auto t0 = dxvk::high_resolution_clock::now();
+
+    { std::unique_lock<dxvk::mutex> lock(m_mutex);
+      m_producerWaiting.store(true);
+
+      m_condOnConsume.wait(lock, [this, head] {
+        return head - m_queueTail.load() < MaxQueuedChunks;
+      });
+
+      m_producerWaiting.store(false);
+    }
+
+    auto t1 = dxvk::high_resolution_clock::now();
+    auto ticks = std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0);
+
+    m_device->addStatCtr(DxvkStatCounter::CsStallCount, 1);
+    m_device->addStatCtr(DxvkStatCounter::CsStallTicks, ticks.count());
+  }
+
+
+  bool DxvkCsThread::waitForChunk(uint64_t tail) {
+    if (unlikely(m_stopped.load()))
+      return false;
+
+    if (likely(m_queueHead.load(std::memory_order_acquire) != tail))
+      return true;
+
+    auto t0 = dxvk::high_resolution_clock::now();
+
+    { std::unique_lock<dxvk::mutex> lock(m_mutex);
+      m_consumerWaiting.store(true);
+
+      m_condOnAdd.wait(lock, [this, tail] {
+        return (m_queueHead.load() != tail)
+            || (m_stopped.load());
+      });
+
+      m_consumerWaiting.store(false);
+    }
+
+    auto t1 = dxvk::high_resolution_clock::now();
+    auto ticks = std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0);
+
+    m_context->addStatCtr(DxvkStatCounter::CsIdleTicks, ticks.count());
+    return !m_stopped.load();
+  }
+
+
   void DxvkCsThread::threadFunc() {
     env::setThreadName("dxvk-cs");
 
-    // Local chunk queue, we use two queues and swap between
-    // them in order to potentially reduce lock contention.
-    std::vector<DxvkCsChunkRef> chunks;
+    uint64_t tail = 0;
 
     try {
-      while (!m_stopped.load()) {
-        { std::unique_lock<dxvk::mutex> lock(m_mutex);
+      while (waitForChunk(tail)) {
+        DxvkCsChunkRef chunk = std::move(m_chunksQueued[tail % MaxQueuedChunks]);
 
-          m_condOnAdd.wait(lock, [this] {
-            return (!m_chunksQueued.empty())
-                || (m_stopped.load());
-          });
+        // Release the slot before executing the chunk so that
+        // the producer can keep going if the queue was full.
+        m_queueTail.store(++tail);
 
-          std::swap(chunks, m_chunksQueued);
+        if (m_producerWaiting.load()) {
+          std::unique_lock<dxvk::mutex> lock(m_mutex);
+          m_condOnConsume.notify_one();
         }
 
-        for (auto& chunk : chunks) {
-          m_context->addStatCtr(DxvkStatCounter::CsChunkCount, 1);
-
-          chunk->executeAll(m_context.ptr());
+        m_context->addStatCtr(DxvkStatCounter::CsChunkCount, 1);
+        m_context->addStatCtr(DxvkStatCounter::CsChunkUsedBytes, chunk->usedSize());
+        m_context->addStatCtr(DxvkStatCounter::CsChunkTotalBytes, chunk->blockSize());
 
-          // Use a separate mutex for the chunk counter, this
-          // will only ever be contested if synchronization is
-          // actually necessary.
-          { std::unique_lock<dxvk::mutex> lock(m_counterMutex);
-            m_chunksExecuted += 1;
-            m_condOnSync.notify_one();
-          }
+        chunk->executeAll(m_context.ptr());
 
-          // Explicitly free chunk here to release
-          // references to any resources held by it
-          chunk = DxvkCsChunkRef();
+        // Use a separate mutex for the chunk counter, this
+        // will only ever be contested if synchronization is
+        // actually necessary.
+        { std::unique_lock<dxvk::mutex> lock(m_counterMutex);
+          m_chunksExecuted += 1;
+          m_condOnSync.notify_one();
         }
 
-        chunks.clear();
+        // Explicitly free chunk here to release
+        // references to any resources held by it
+        chunk = DxvkCsChunkRef();
       }
     } catch (const DxvkError& e) {
       Logger::err("Exception on CS thread!");
@@ -199,4 +262,4 @@ namespace dxvk {
     }
   }
   
-}
\ No newline at end of file
+}
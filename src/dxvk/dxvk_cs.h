@@ -138,10 +138,14 @@ namespace dxvk {
    * Stores a list of commands.
    */
   class DxvkCsChunk : public RcObject {
-    constexpr static size_t MaxBlockSize = 16384;
   public:
+
+    /// Command storage size of regular chunks
+    constexpr static size_t DefaultBlockSize = 16384;
+    /// Command storage size of chunks used for bulk work
+    constexpr static size_t LargeBlockSize   = 65536;
     
-    DxvkCsChunk();
+    DxvkCsChunk(size_t blockSize);
     ~DxvkCsChunk();
     
     /**
@@ -152,6 +156,22 @@ namespace dxvk {
       return m_commandOffset == 0;
     }
 
+    /**
+     * \brief Number of bytes used by recorded commands
+     * \returns Used command storage size
+     */
+    size_t usedSize() const {
+      return m_commandOffset;
+    }
+
+    /**
+     * \brief Command storage size
+     * \returns Maximum size of recorded commands
+     */
+    size_t blockSize() const {
+      return m_blockSize;
+    }
+
     /**
      * \brief Tries to add a command to the chunk
      * 
@@ -166,7 +186,7 @@ namespace dxvk {
     bool push(T& command) {
       using FuncType = DxvkCsTypedCmd<T>;
       
-      if (unlikely(m_commandOffset > MaxBlockSize - sizeof(FuncType)))
+      if (unlikely(m_commandOffset > m_blockSize - sizeof(FuncType)))
         return false;
       
       DxvkCsCmd* tail = m_tail;
@@ -194,7 +214,7 @@ namespace dxvk {
     M* pushCmd(T& command, Args&&... args) {
       using FuncType = DxvkCsDataCmd<T, M>;
       
-      if (unlikely(m_commandOffset > MaxBlockSize - sizeof(FuncType)))
+      if (unlikely(m_commandOffset > m_blockSize - sizeof(FuncType)))
         return nullptr;
       
       FuncType* func = new (m_data + m_commandOffset)
@@ -237,14 +257,15 @@ namespace dxvk {
   private:
     
     size_t m_commandOffset = 0;
+    size_t m_blockSize;
     
     DxvkCsCmd* m_head = nullptr;
     DxvkCsCmd* m_tail = nullptr;
 
     DxvkCsChunkFlags m_flags;
-    
-    alignas(64)
-    char m_data[MaxBlockSize];
+
+    std::unique_ptr<char[]> m_storage;
+    char*                   m_data;
     
   };
   
@@ -272,9 +293,13 @@ namespace dxvk {
      * Takes an existing chunk from the pool,
      * or creates a new one if necessary.
      * \param [in] flags Chunk flags
+     * \param [in] blockSize Command storage size, must be
+     *    either \c DefaultBlockSize or \c LargeBlockSize
      * \returns Allocated chunk object
      */
-    DxvkCsChunk* allocChunk(DxvkCsChunkFlags flags);
+    DxvkCsChunk* allocChunk(
+            DxvkCsChunkFlags  flags,
+            size_t            blockSize = DxvkCsChunk::DefaultBlockSize);
     
     /**
      * \brief Releases a chunk
@@ -287,7 +312,11 @@ namespace dxvk {
   private:
     
     dxvk::mutex               m_mutex;
-    std::vector<DxvkCsChunk*> m_chunks;
+    std::array<std::vector<DxvkCsChunk*>, 2> m_chunks;
+
+    static uint32_t getSizeClass(size_t blockSize) {
+      return blockSize > DxvkCsChunk::DefaultBlockSize ? 1 : 0;
+    }
     
   };
   
@@ -374,9 +403,13 @@ namespace dxvk {
 
   /**
    * \brief Command stream thread
-   * 
-   * Spawns a thread that will execute
-   * commands on a DXVK context. 
+   *
+   * Executes chunks on a dedicated worker thread. Chunks are
+   * passed through a bounded single-producer, single-consumer
+   * ring buffer, so the producing thread only needs to take a
+   * lock when the worker is idle or the queue is full. Callers
+   * must ensure that \ref dispatchChunk is never called from
+   * multiple threads concurrently.
    */
   class DxvkCsThread {
     
@@ -384,6 +417,9 @@ namespace dxvk {
 
     constexpr static uint64_t SynchronizeAll = ~0ull;
 
+    /// Maximum number of chunks in flight, must be a power of two
+    constexpr static uint64_t MaxQueuedChunks = 4096;
+
     DxvkCsThread(
       const Rc<DxvkDevice>&   device,
       const Rc<DxvkContext>&  context);
@@ -432,10 +468,28 @@ namespace dxvk {
     std::atomic<bool>           m_stopped = { false };
     dxvk::mutex                 m_mutex;
     dxvk::condition_variable    m_condOnAdd;
+    dxvk::condition_variable    m_condOnConsume;
     dxvk::condition_variable    m_condOnSync;
-    std::vector<DxvkCsChunkRef> m_chunksQueued;
+
+    // Written by the producer only
+    alignas(CACHE_LINE_SIZE)
+    std::atomic<uint64_t>       m_queueHead = { 0ull };
+    std::atomic<bool>           m_producerWaiting = { false };
+
+    // Written by the consumer only
+    alignas(CACHE_LINE_SIZE)
+    std::atomic<uint64_t>       m_queueTail = { 0ull };
+    std::atomic<bool>           m_consumerWaiting = { false };
+
+    alignas(CACHE_LINE_SIZE)
+    std::array<DxvkCsChunkRef, MaxQueuedChunks> m_chunksQueued;
+
     dxvk::thread                m_thread;
     
+    void waitForQueueSpace(uint64_t head);
+
+    bool waitForChunk(uint64_t tail);
+
     void threadFunc();
     
   };
@@ -204,8 +204,12 @@ namespace dxvk {
     result.setCtr(DxvkStatCounter::PipeCountGraphics, pipe.numGraphicsPipelines);
     result.setCtr(DxvkStatCounter::PipeCountLibrary,  pipe.numGraphicsLibraries);
     result.setCtr(DxvkStatCounter::PipeCountCompute,  pipe.numComputePipelines);
+    result.setCtr(DxvkStatCounter::PipeInstanceLocks,     pipe.numInstanceLocks);
+    result.setCtr(DxvkStatCounter::PipeInstanceLockWaits, pipe.numInstanceLockWaits);
     result.setCtr(DxvkStatCounter::PipeTasksDone,     workers.tasksCompleted);
     result.setCtr(DxvkStatCounter::PipeTasksTotal,    workers.tasksTotal);
+    result.setCtr(DxvkStatCounter::PipeBatchTasksDone,  workers.batchTasksCompleted);
+    result.setCtr(DxvkStatCounter::PipeBatchTasksTotal, workers.batchTasksTotal);
     result.setCtr(DxvkStatCounter::GpuIdleTicks,      m_submissionQueue.gpuIdleTicks());
 
     std::lock_guard<sync::Spinlock> lock(m_statLock);
@@ -498,6 +498,26 @@ namespace dxvk {
       m_submissionQueue.unlockDeviceQueue();
     }
 
+    /**
+     * \brief Locks device queue
+     *
+     * Unlike \c lockSubmission, this does not wait for
+     * pending submissions to complete, and only blocks
+     * while DXVK itself is submitting to the queue. Work
+     * submitted externally while holding the lock must
+     * synchronize with DXVK via timeline semaphores.
+     */
+    void lockDeviceQueue() {
+      m_submissionQueue.lockDeviceQueue();
+    }
+
+    /**
+     * \brief Unlocks device queue
+     */
+    void unlockDeviceQueue() {
+      m_submissionQueue.unlockDeviceQueue();
+    }
+
     /**
      * \brief Increments a given stat counter
      *
@@ -44,7 +44,8 @@ namespace dxvk {
 
   bool DxvkFramebufferInfo::hasTargets(const DxvkRenderTargets& renderTargets) {
     bool eq = m_renderTargets.depth.view   == renderTargets.depth.view
-           && m_renderTargets.depth.layout == renderTargets.depth.layout;
+           && m_renderTargets.depth.layout == renderTargets.depth.layout
+           && m_renderTargets.viewMask     == renderTargets.viewMask;
 
     for (uint32_t i = 0; i < MaxNumRenderTargets && eq; i++) {
       eq &= m_renderTargets.color[i].view   == renderTargets.color[i].view
@@ -85,7 +86,7 @@ namespace dxvk {
     }
 
     return DxvkRtInfo(MaxNumRenderTargets, colorFormats.data(),
-      depthStencilFormat, depthStencilReadOnlyAspects);
+      depthStencilFormat, depthStencilReadOnlyAspects, getViewMask());
   }
 
 
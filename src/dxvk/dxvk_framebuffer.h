@@ -36,11 +36,15 @@ namespace dxvk {
    * \brief Render targets
    * 
    * Stores all depth-stencil and color
-   * attachments attached to a framebuffer.
+   * attachments attached to a framebuffer,
+   * as well as the multiview view mask. If
+   * non-zero, all attachments must have at
+   * least as many layers as there are views.
    */
   struct DxvkRenderTargets {
     DxvkAttachment depth;
     DxvkAttachment color[MaxNumRenderTargets];
+    uint32_t       viewMask = 0u;
   };
 
 
@@ -217,6 +221,14 @@ namespace dxvk {
      */
     DxvkRtInfo getRtInfo() const;
 
+    /**
+     * \brief Multiview view mask
+     * \returns View mask for render passes and pipelines
+     */
+    uint32_t getViewMask() const {
+      return m_renderTargets.viewMask;
+    }
+
   private:
 
     DxvkRenderTargets   m_renderTargets;
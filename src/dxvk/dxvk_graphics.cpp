@@ -228,6 +228,8 @@ namespace dxvk {
 
     feedbackLoop = state.om.feedbackLoop();
 
+    rtInfo.viewMask = state.rt.getViewMask();
+
     for (uint32_t i = 0; i < MaxNumRenderTargets; i++) {
       rtColorFormats[i] = state.rt.getColorFormat(i);
 
@@ -302,10 +304,6 @@ namespace dxvk {
       msInfo.minSampleShading     = 1.0f;
     }
 
-    if (vs && vs->flags().test(DxvkShaderFlag::UsesMultiView)) {
-      rtInfo.viewMask = 0b11;
-    }
-
     // Alpha to coverage is not supported with sample mask exports.
     cbUseDynamicAlphaToCoverage = !fs || !fs->flags().test(DxvkShaderFlag::ExportsSampleMask);
 
@@ -918,6 +916,83 @@ namespace dxvk {
   }
 
 
+  DxvkGraphicsPipelineInstanceMap::DxvkGraphicsPipelineInstanceMap() {
+
+  }
+
+
+  DxvkGraphicsPipelineInstanceMap::~DxvkGraphicsPipelineInstanceMap() {
+
+  }
+
+
+  DxvkGraphicsPipelineInstance* DxvkGraphicsPipelineInstanceMap::find(
+    const DxvkGraphicsPipelineStateInfo& state) const {
+    Table* table = m_table.load(std::memory_order_acquire);
+
+    if (!table)
+      return nullptr;
+
+    size_t hash = state.hash();
+    size_t mask = table->capacity - 1;
+
+    for (size_t i = hash & mask; ; i = (i + 1) & mask) {
+      DxvkGraphicsPipelineInstance* instance = table->slots[i].load(std::memory_order_acquire);
+
+      if (!instance)
+        return nullptr;
+
+      if (instance->hash == hash && instance->state == state)
+        return instance;
+    }
+  }
+
+
+  void DxvkGraphicsPipelineInstanceMap::insert(
+          DxvkGraphicsPipelineInstance* instance) {
+    Table* table = m_table.load(std::memory_order_relaxed);
+
+    // Keep the load factor at or below 1/2. Readers may still
+    // be probing the old table, so only retire it, and publish
+    // the new one once it is fully populated.
+    if (!table || 2 * (table->count + 1) > table->capacity) {
+      size_t capacity = table ? 2 * table->capacity : 16;
+      auto newTable = std::make_unique<Table>(capacity);
+
+      if (table) {
+        for (size_t i = 0; i < table->capacity; i++) {
+          auto entry = table->slots[i].load(std::memory_order_relaxed);
+
+          if (entry)
+            insertSlot(*newTable, entry);
+        }
+      }
+
+      table = newTable.get();
+      m_tables.push_back(std::move(newTable));
+
+      insertSlot(*table, instance);
+      m_table.store(table, std::memory_order_release);
+    } else {
+      insertSlot(*table, instance);
+    }
+  }
+
+
+  void DxvkGraphicsPipelineInstanceMap::insertSlot(
+          Table&                        table,
+          DxvkGraphicsPipelineInstance* instance) {
+    size_t mask = table.capacity - 1;
+    size_t index = instance->hash & mask;
+
+    while (table.slots[index].load(std::memory_order_relaxed))
+      index = (index + 1) & mask;
+
+    table.slots[index].store(instance, std::memory_order_release);
+    table.count += 1;
+  }
+
+
   DxvkGraphicsPipeline::DxvkGraphicsPipeline(
           DxvkDevice*                 device,
           DxvkPipelineManager*        pipeMgr,
@@ -993,6 +1068,7 @@ namespace dxvk {
   std::pair<VkPipeline, DxvkGraphicsPipelineType> DxvkGraphicsPipeline::getPipelineHandle(
     const DxvkGraphicsPipelineStateInfo& state) {
     DxvkGraphicsPipelineInstance* instance = this->findInstance(state);
+    bool isNewInstance = false;
 
     if (unlikely(!instance)) {
       // Exit early if the state vector is invalid
@@ -1000,7 +1076,14 @@ namespace dxvk {
         return std::make_pair(VK_NULL_HANDLE, DxvkGraphicsPipelineType::FastPipeline);
 
       // Prevent other threads from adding new instances and check again
-      std::unique_lock<dxvk::mutex> lock(m_mutex);
+      std::unique_lock<dxvk::mutex> lock(m_mutex, std::try_to_lock);
+
+      if (!lock.owns_lock()) {
+        m_stats->numInstanceLockWaits += 1;
+        lock.lock();
+      }
+
+      m_stats->numInstanceLocks += 1;
       instance = this->findInstance(state);
 
       if (!instance) {
@@ -1008,6 +1091,7 @@ namespace dxvk {
         // a state cache worker and the current thread needs priority.
         bool canCreateBasePipeline = this->canCreateBasePipeline(state);
         instance = this->createInstance(state, canCreateBasePipeline);
+        isNewInstance = true;
 
         // Unlock here since we may dispatch the pipeline to a worker,
         // which will then acquire it to increment the use counter.
@@ -1031,6 +1115,15 @@ namespace dxvk {
     if (likely(fastHandle != VK_NULL_HANDLE))
       return std::make_pair(fastHandle, DxvkGraphicsPipelineType::FastPipeline);
 
+    // The base pipeline is still being used a while after the instance
+    // was created, so ask the workers to move the optimized one ahead.
+    // Optimized pipelines are never compiled if GPL is forced on.
+    if (!isNewInstance && !instance->isPrioritized.load()
+     && m_device->config().enableGraphicsPipelineLibrary != Tristate::True
+     && high_resolution_clock::now() - instance->createTime >= DxvkPipelineWorkers::AgingInterval
+     && !instance->isPrioritized.exchange(VK_TRUE, std::memory_order_relaxed))
+      m_workers->prioritizeGraphicsPipeline(this, state);
+
     return std::make_pair(instance->baseHandle.load(), DxvkGraphicsPipelineType::BasePipeline);
   }
 
@@ -1133,18 +1226,16 @@ namespace dxvk {
       this->logPipelineState(LogLevel::Error, state);
 
     m_stats->numGraphicsPipelines += 1;
-    return &(*m_pipelines.emplace(state, baseHandle, fastHandle));
+
+    auto instance = &(*m_pipelines.emplace(state, baseHandle, fastHandle));
+    m_pipelineMap.insert(instance);
+    return instance;
   }
   
   
   DxvkGraphicsPipelineInstance* DxvkGraphicsPipeline::findInstance(
     const DxvkGraphicsPipelineStateInfo& state) {
-    for (auto& instance : m_pipelines) {
-      if (instance.state == state)
-        return &instance;
-    }
-    
-    return nullptr;
+    return m_pipelineMap.find(state);
   }
   
   
@@ -1153,6 +1244,12 @@ namespace dxvk {
     if (!m_vsLibrary || !m_fsLibrary)
       return false;
 
+    // Shader libraries are compiled without a view mask, and
+    // all libraries linked into a pipeline must use the same
+    // one, so multiview pipelines need to be compiled in full.
+    if (state.rt.getViewMask())
+      return false;
+
     // We do not implement setting certain rarely used render
     // states dynamically since they are generally not used
     bool isLineRendering = DxvkGraphicsPipelinePreRasterizationState::isLineRendering(state, m_shaders.tes.ptr(), m_shaders.gs.ptr());
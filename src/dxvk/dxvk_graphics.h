@@ -4,6 +4,8 @@
 
 #include "../util/sync/sync_list.h"
 
+#include "../util/util_time.h"
+
 #include "dxvk_bind_mask.h"
 #include "dxvk_constant_state.h"
 #include "dxvk_graphics_state.h"
@@ -362,14 +364,80 @@ namespace dxvk {
             VkPipeline                      baseHandle_,
             VkPipeline                      fastHandle_)
     : state       (state_),
+      hash        (state_.hash()),
       baseHandle  (baseHandle_),
       fastHandle  (fastHandle_),
-      isCompiling (fastHandle_ != VK_NULL_HANDLE) { }
+      isCompiling (fastHandle_ != VK_NULL_HANDLE),
+      createTime  (high_resolution_clock::now()) { }
 
     DxvkGraphicsPipelineStateInfo state;
+    size_t                        hash = 0;
     std::atomic<VkPipeline>       baseHandle  = { VK_NULL_HANDLE };
     std::atomic<VkPipeline>       fastHandle  = { VK_NULL_HANDLE };
     std::atomic<VkBool32>         isCompiling = { VK_FALSE };
+    std::atomic<VkBool32>         isPrioritized = { VK_FALSE };
+    high_resolution_clock::time_point createTime;
+  };
+
+
+  /**
+   * \brief Graphics pipeline instance table
+   *
+   * Open-addressing hash table that maps state vectors to
+   * instances. Insertions must be externally synchronized,
+   * lookups are lock-free. When a table fills up, a larger
+   * copy is built and published atomically. Old tables are
+   * kept alive until the map is destroyed since readers may
+   * still be accessing them, which at most doubles memory.
+   */
+  class DxvkGraphicsPipelineInstanceMap {
+
+  public:
+
+    DxvkGraphicsPipelineInstanceMap();
+
+    ~DxvkGraphicsPipelineInstanceMap();
+
+    /**
+     * \brief Looks up an instance
+     *
+     * \param [in] state Pipeline state
+     * \returns Instance, or \c nullptr if not found
+     */
+    DxvkGraphicsPipelineInstance* find(
+      const DxvkGraphicsPipelineStateInfo& state) const;
+
+    /**
+     * \brief Adds an instance
+     *
+     * The instance must not already be in the
+     * map, and must outlive the map.
+     * \param [in] instance The instance
+     */
+    void insert(
+            DxvkGraphicsPipelineInstance* instance);
+
+  private:
+
+    struct Table {
+      Table(size_t capacity_)
+      : capacity(capacity_), slots(new std::atomic<DxvkGraphicsPipelineInstance*>[capacity_]) {
+        for (size_t i = 0; i < capacity; i++)
+          slots[i].store(nullptr, std::memory_order_relaxed);
+      }
+
+      size_t capacity;
+      size_t count = 0;
+      std::unique_ptr<std::atomic<DxvkGraphicsPipelineInstance*>[]> slots;
+    };
+
+    std::atomic<Table*>                 m_table = { nullptr };
+    std::vector<std::unique_ptr<Table>> m_tables;
+
+    static void insertSlot(
+            Table&                        table,
+            DxvkGraphicsPipelineInstance* instance);
+
   };
 
 
@@ -588,6 +656,7 @@ namespace dxvk {
     alignas(CACHE_LINE_SIZE)
     dxvk::mutex                                   m_mutex;
     sync::List<DxvkGraphicsPipelineInstance>      m_pipelines;
+    DxvkGraphicsPipelineInstanceMap               m_pipelineMap;
     uint32_t                                      m_useCount = 0;
 
     std::unordered_map<
@@ -485,8 +485,9 @@ namespace dxvk {
    * \brief Packed render target formats
    *
    * Compact representation of depth-stencil and color attachments,
-   * as well as the read-only mask for the depth-stencil attachment,
-   * which needs to be known at pipeline compile time.
+   * as well as the read-only mask for the depth-stencil attachment
+   * and the multiview view mask, which need to be known at pipeline
+   * compile time.
    */
   class DxvkRtInfo {
 
@@ -498,8 +499,9 @@ namespace dxvk {
             uint32_t            colorFormatCount,
       const VkFormat*           colorFormats,
             VkFormat            depthStencilFormat,
-            VkImageAspectFlags  depthStencilReadOnlyAspects)
-    : m_packedData(0ull) {
+            VkImageAspectFlags  depthStencilReadOnlyAspects,
+            uint32_t            viewMask)
+    : m_packedData(0ull), m_viewMask(viewMask), m_reserved(0u) {
       m_packedData |= encodeDepthStencilFormat(depthStencilFormat);
       m_packedData |= encodeDepthStencilAspects(depthStencilReadOnlyAspects);
 
@@ -519,9 +521,15 @@ namespace dxvk {
       return decodeDepthStencilAspects(m_packedData);
     }
 
+    uint32_t getViewMask() const {
+      return m_viewMask;
+    }
+
   private:
 
     uint64_t m_packedData;
+    uint32_t m_viewMask;
+    uint32_t m_reserved;
 
     static uint64_t encodeDepthStencilAspects(VkImageAspectFlags aspects) {
       return uint64_t(aspects) << 61;
@@ -748,6 +756,18 @@ namespace dxvk {
       return !bit::bcmpeq(this, &other);
     }
 
+    size_t hash() const {
+      // The state is compared bitwise and has no
+      // uninitialized padding, so hash raw data
+      auto data = reinterpret_cast<const uint64_t*>(this);
+      uint64_t hash = 0xcbf29ce484222325ull;
+
+      for (size_t i = 0; i < sizeof(*this) / sizeof(uint64_t); i++)
+        hash = (hash ^ data[i]) * 0x100000001b3ull;
+
+      return size_t(hash ^ (hash >> 32));
+    }
+
     bool useDynamicStencilRef() const {
       return ds.enableStencilTest();
     }
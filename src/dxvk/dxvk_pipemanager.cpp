@@ -1,4 +1,6 @@
+#include <algorithm>
 #include <optional>
+#include <sstream>
 
 #include "dxvk_device.h"
 #include "dxvk_pipemanager.h"
@@ -26,7 +28,7 @@ namespace dxvk {
 
     m_tasksTotal += 1;
 
-    m_buckets[uint32_t(priority)].queue.emplace(library);
+    enqueue(priority, PipelineEntry(library));
     notifyWorkers(priority);
   }
 
@@ -41,11 +43,69 @@ namespace dxvk {
     pipeline->acquirePipeline();
     m_tasksTotal += 1;
 
-    m_buckets[uint32_t(priority)].queue.emplace(pipeline, state);
+    enqueue(priority, PipelineEntry(pipeline, state));
     notifyWorkers(priority);
   }
 
 
+  void DxvkPipelineWorkers::compilePipelineBatch(
+    const DxvkPipelineBatch&              batch,
+          DxvkPipelinePriority            priority) {
+    size_t taskCount = batch.libraries.size() + batch.pipelines.size();
+
+    if (!taskCount)
+      return;
+
+    std::unique_lock lock(m_lock);
+    this->startWorkers();
+
+    m_tasksTotal += taskCount;
+    m_batchTasksTotal += taskCount;
+
+    for (auto library : batch.libraries) {
+      PipelineEntry entry(library);
+      entry.batched = true;
+
+      enqueue(priority, std::move(entry));
+    }
+
+    for (const auto& pipeline : batch.pipelines) {
+      pipeline.first->acquirePipeline();
+
+      PipelineEntry entry(pipeline.first, pipeline.second);
+      entry.batched = true;
+
+      enqueue(priority, std::move(entry));
+    }
+
+    // Wake up every worker that can process the batch
+    for (uint32_t i = uint32_t(priority); i < m_buckets.size(); i++) {
+      if (m_buckets[i].idleWorkers)
+        m_buckets[i].cond.notify_all();
+    }
+  }
+
+
+  void DxvkPipelineWorkers::prioritizeGraphicsPipeline(
+          DxvkGraphicsPipeline*           pipeline,
+    const DxvkGraphicsPipelineStateInfo&  state) {
+    std::unique_lock lock(m_lock);
+
+    pipeline->acquirePipeline();
+    m_tasksTotal += 1;
+
+    // Queue a second job rather than searching for the original
+    // one. Whichever job runs first compiles the pipeline, the
+    // other one exits early since the instance is already marked
+    // as compiling.
+    PipelineEntry entry(pipeline, state);
+    entry.queueTime = high_resolution_clock::now();
+
+    m_buckets[uint32_t(DxvkPipelinePriority::Normal)].queue.push_front(std::move(entry));
+    notifyWorkers(DxvkPipelinePriority::Normal);
+  }
+
+
   void DxvkPipelineWorkers::stopWorkers() {
     { std::unique_lock lock(m_lock);
 
@@ -62,6 +122,99 @@ namespace dxvk {
       worker.join();
 
     m_workers.clear();
+
+    logLatencyHistogram();
+  }
+
+
+  void DxvkPipelineWorkers::enqueue(
+          DxvkPipelinePriority            priority,
+          PipelineEntry&&                 entry) {
+    entry.queueTime = high_resolution_clock::now();
+    m_buckets[uint32_t(priority)].queue.push_back(std::move(entry));
+  }
+
+
+  bool DxvkPipelineWorkers::fetchEntry(
+          uint32_t                        maxPriorityIndex,
+          PipelineEntry&                  entry) {
+    auto now = high_resolution_clock::now();
+
+    // Pick the job with the highest effective priority, and the
+    // oldest one among those. Jobs gain one priority level per
+    // aging interval so that low-priority jobs cannot starve,
+    // but only high-priority jobs can use the high level.
+    uint32_t bestIndex = ~0u;
+    uint32_t bestPriority = ~0u;
+
+    for (uint32_t i = 0; i < m_buckets.size(); i++) {
+      auto& queue = m_buckets[i].queue;
+
+      if (queue.empty())
+        continue;
+
+      uint32_t priority = i;
+      uint32_t steps = uint32_t((now - queue.front().queueTime) / AgingInterval);
+
+      if (priority > uint32_t(DxvkPipelinePriority::Normal)) {
+        priority = std::max(priority - std::min(priority, steps),
+          uint32_t(DxvkPipelinePriority::Normal));
+      }
+
+      if (priority > maxPriorityIndex)
+        continue;
+
+      if (priority < bestPriority || (priority == bestPriority
+       && queue.front().queueTime < m_buckets[bestIndex].queue.front().queueTime)) {
+        bestIndex = i;
+        bestPriority = priority;
+      }
+    }
+
+    if (bestIndex == ~0u)
+      return false;
+
+    auto& queue = m_buckets[bestIndex].queue;
+    entry = std::move(queue.front());
+    queue.pop_front();
+
+    // Record queue latency for the original priority
+    auto latency = std::chrono::duration_cast<std::chrono::milliseconds>(now - entry.queueTime);
+    uint32_t bucket = 0;
+
+    while (bucket + 1 < DxvkPipelineWorkerStats::LatencyBucketCount
+        && latency.count() >= (int64_t(1) << bucket))
+      bucket += 1;
+
+    m_latencyHistogram[bestIndex][bucket].fetch_add(1, std::memory_order_relaxed);
+    return true;
+  }
+
+
+  void DxvkPipelineWorkers::logLatencyHistogram() const {
+    static const std::array<const char*, 3> names = { "high", "normal", "low" };
+
+    for (uint32_t i = 0; i < m_latencyHistogram.size(); i++) {
+      std::stringstream str;
+      uint64_t total = 0;
+
+      for (uint32_t j = 0; j < m_latencyHistogram[i].size(); j++) {
+        uint64_t count = m_latencyHistogram[i][j].load(std::memory_order_relaxed);
+
+        if (!count)
+          continue;
+
+        if (j + 1 < m_latencyHistogram[i].size())
+          str << " <" << (1u << j) << "ms: " << count;
+        else
+          str << " slower: " << count;
+
+        total += count;
+      }
+
+      if (total)
+        Logger::info(str::format("DXVK: Queue latency of ", total, " ", names[i], " priority pipeline tasks:", str.str()));
+    }
   }
 
 
@@ -138,17 +291,8 @@ namespace dxvk {
 
         bucket.idleWorkers += 1;
         bucket.cond.wait(lock, [this, maxPriorityIndex, &entry] {
-          // Attempt to fetch a work item from the
-          // highest-priority queue that is not empty
-          for (uint32_t i = 0; i <= maxPriorityIndex; i++) {
-            if (!m_buckets[i].queue.empty()) {
-              entry = m_buckets[i].queue.front();
-              m_buckets[i].queue.pop();
-              return true;
-            }
-          }
-
-          return !m_workersRunning;
+          return fetchEntry(maxPriorityIndex, entry)
+              || !m_workersRunning;
         });
 
         bucket.idleWorkers -= 1;
@@ -166,6 +310,9 @@ namespace dxvk {
         entry.graphicsPipeline->releasePipeline();
       }
 
+      if (entry.batched)
+        m_batchTasksCompleted += 1;
+
       m_tasksCompleted += 1;
     }
   }
@@ -375,6 +522,8 @@ namespace dxvk {
     result.numGraphicsPipelines = m_stats.numGraphicsPipelines.load();
     result.numGraphicsLibraries = m_stats.numGraphicsLibraries.load();
     result.numComputePipelines  = m_stats.numComputePipelines.load();
+    result.numInstanceLocks     = m_stats.numInstanceLocks.load();
+    result.numInstanceLockWaits = m_stats.numInstanceLockWaits.load();
     return result;
   }
 
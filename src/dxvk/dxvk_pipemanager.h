@@ -1,10 +1,13 @@
 
 #pragma once
 
+#include <deque>
 #include <mutex>
 #include <queue>
 #include <unordered_map>
 
+#include "../util/util_time.h"
+
 #include "dxvk_compute.h"
 #include "dxvk_graphics.h"
 #include "dxvk_state_cache.h"
@@ -23,20 +26,54 @@ namespace dxvk {
     uint32_t numGraphicsPipelines;
     uint32_t numGraphicsLibraries;
     uint32_t numComputePipelines;
+    uint64_t numInstanceLocks;
+    uint64_t numInstanceLockWaits;
   };
 
   /**
    * \brief Pipeline stats
+   *
+   * Instance lookups that hit are lock-free, the lock counters
+   * track lookups that had to take the pipeline lock in order
+   * to create an instance, and how many of those had to wait.
    */
   struct DxvkPipelineStats {
     std::atomic<uint32_t> numGraphicsPipelines  = { 0u };
     std::atomic<uint32_t> numGraphicsLibraries  = { 0u };
     std::atomic<uint32_t> numComputePipelines   = { 0u };
+    std::atomic<uint64_t> numInstanceLocks      = { 0ull };
+    std::atomic<uint64_t> numInstanceLockWaits  = { 0ull };
   };
 
+  /**
+   * \brief Pipeline worker stats
+   *
+   * Batch tasks are a subset of all tasks
+   * and are used to track state cache replay.
+   *
+   * The latency histogram counts tasks by the time they
+   * spent queued, per priority. Bucket 0 counts tasks
+   * started within 1ms, bucket \c n tasks started within
+   * 2^n ms, and the last bucket counts all slower tasks.
+   * It is also logged when the workers are stopped.
+   */
   struct DxvkPipelineWorkerStats {
+    constexpr static uint32_t LatencyBucketCount = 12;
+
     uint64_t tasksCompleted;
     uint64_t tasksTotal;
+    uint64_t batchTasksCompleted;
+    uint64_t batchTasksTotal;
+
+    std::array<std::array<uint64_t, LatencyBucketCount>, 3> latencyHistogram;
+  };
+
+  /**
+   * \brief Pipeline compile batch
+   */
+  struct DxvkPipelineBatch {
+    std::vector<DxvkShaderPipelineLibrary*> libraries;
+    std::vector<std::pair<DxvkGraphicsPipeline*, DxvkGraphicsPipelineStateInfo>> pipelines;
   };
 
   /**
@@ -58,6 +95,11 @@ namespace dxvk {
 
   public:
 
+    /// Time after which a queued job moves up one priority
+    /// level. Jobs never age into the high-priority level,
+    /// which is reserved for work that blocks rendering.
+    constexpr static auto AgingInterval = std::chrono::milliseconds(500);
+
     DxvkPipelineWorkers(
             DxvkDevice*                     device);
 
@@ -73,6 +115,14 @@ namespace dxvk {
       DxvkPipelineWorkerStats result;
       result.tasksCompleted = m_tasksCompleted.load(std::memory_order_acquire);
       result.tasksTotal = m_tasksTotal.load(std::memory_order_relaxed);
+      result.batchTasksCompleted = m_batchTasksCompleted.load(std::memory_order_acquire);
+      result.batchTasksTotal = m_batchTasksTotal.load(std::memory_order_relaxed);
+
+      for (uint32_t i = 0; i < m_latencyHistogram.size(); i++) {
+        for (uint32_t j = 0; j < m_latencyHistogram[i].size(); j++)
+          result.latencyHistogram[i][j] = m_latencyHistogram[i][j].load(std::memory_order_relaxed);
+      }
+
       return result;
     }
 
@@ -100,6 +150,37 @@ namespace dxvk {
       const DxvkGraphicsPipelineStateInfo&  state,
             DxvkPipelinePriority            priority);
 
+    /**
+     * \brief Compiles a batch of pipelines
+     *
+     * Queues all pipeline libraries ahead of the optimized
+     * pipelines, so that libraries shared by multiple pipelines
+     * are ready early, and wakes up all suitable idle workers
+     * at once rather than one per pipeline.
+     * \param [in] batch Pipeline libraries and pipelines
+     * \param [in] priority Pipeline priority
+     */
+    void compilePipelineBatch(
+      const DxvkPipelineBatch&              batch,
+            DxvkPipelinePriority            priority);
+
+    /**
+     * \brief Moves a queued graphics pipeline ahead
+     *
+     * Used as a deadline hint when an optimized pipeline is
+     * needed soon, e.g. because the draw path still falls
+     * back to the base pipeline one aging interval after
+     * the pipeline instance was created. Queues another compile job
+     * at the front of the normal-priority queue, the one that
+     * runs later becomes a no-op.
+     * Must only be called once per pipeline instance.
+     * \param [in] pipeline Graphics pipeline
+     * \param [in] state Pipeline state
+     */
+    void prioritizeGraphicsPipeline(
+            DxvkGraphicsPipeline*           pipeline,
+      const DxvkGraphicsPipelineStateInfo&  state);
+
     /**
      * \brief Stops all worker threads
      *
@@ -123,11 +204,13 @@ namespace dxvk {
       DxvkShaderPipelineLibrary*    pipelineLibrary;
       DxvkGraphicsPipeline*         graphicsPipeline;
       DxvkGraphicsPipelineStateInfo graphicsState;
+      bool                          batched = false;
+      high_resolution_clock::time_point queueTime;
     };
 
     struct PipelineBucket {
       dxvk::condition_variable  cond;
-      std::queue<PipelineEntry> queue;
+      std::deque<PipelineEntry> queue;
       uint32_t                  idleWorkers = 0;
     };
 
@@ -136,12 +219,28 @@ namespace dxvk {
     std::atomic<uint64_t>             m_tasksTotal     = { 0ull };
     std::atomic<uint64_t>             m_tasksCompleted = { 0ull };
 
+    std::atomic<uint64_t>             m_batchTasksTotal     = { 0ull };
+    std::atomic<uint64_t>             m_batchTasksCompleted = { 0ull };
+
+    std::array<std::array<std::atomic<uint64_t>,
+      DxvkPipelineWorkerStats::LatencyBucketCount>, 3> m_latencyHistogram = { };
+
     dxvk::mutex                       m_lock;
     std::array<PipelineBucket, 3>     m_buckets;
 
     bool                              m_workersRunning = false;
     std::vector<dxvk::thread>         m_workers;
 
+    void enqueue(
+            DxvkPipelinePriority            priority,
+            PipelineEntry&&                 entry);
+
+    bool fetchEntry(
+            uint32_t                        maxPriorityIndex,
+            PipelineEntry&                  entry);
+
+    void logLatencyHistogram() const;
+
     void notifyWorkers(DxvkPipelinePriority priority);
 
     void startWorkers();
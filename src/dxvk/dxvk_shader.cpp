@@ -141,7 +141,8 @@ namespace dxvk {
           m_flags.set(DxvkShaderFlag::HasSampleRateShading);
 
         if (ins.arg(1) == spv::CapabilityShaderViewportIndex
-         || ins.arg(1) == spv::CapabilityShaderLayer)
+         || ins.arg(1) == spv::CapabilityShaderLayer
+         || ins.arg(1) == spv::CapabilityShaderViewportIndexLayerEXT)
           m_flags.set(DxvkShaderFlag::ExportsViewportIndexLayerFromVertexStage);
 
         if (ins.arg(1) == spv::CapabilitySparseResidency)
@@ -257,6 +258,11 @@ namespace dxvk {
         return false;
     }
 
+    // Pipeline libraries are compiled without a view mask, and
+    // multiview pipelines are always compiled in full anyway
+    if (m_flags.test(DxvkShaderFlag::UsesMultiView))
+      return false;
+
     // Spec constant selectors are only supported in graphics
     if (m_specConstantMask & (1u << MaxNumSpecConstants))
       return m_info.stage != VK_SHADER_STAGE_COMPUTE_BIT;
@@ -1237,9 +1243,6 @@ namespace dxvk {
     }
 
     VkPipelineRenderingCreateInfo rtInfo = { VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO };
-    if (m_shaders.vs && m_shaders.vs->flags().test(DxvkShaderFlag::UsesMultiView)) {
-        rtInfo.viewMask = 0b11;
-    }
 
     VkGraphicsPipelineLibraryCreateInfoEXT libInfo = { VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_LIBRARY_CREATE_INFO_EXT, &rtInfo };
     libInfo.flags             = VK_GRAPHICS_PIPELINE_LIBRARY_PRE_RASTERIZATION_SHADERS_BIT_EXT;
@@ -1327,9 +1330,6 @@ namespace dxvk {
     VkPipelineDepthStencilStateCreateInfo dsInfo = { VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO };
 
     VkPipelineRenderingCreateInfo rtInfo = { VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO };
-    if (m_shaders.vs && m_shaders.vs->flags().test(DxvkShaderFlag::UsesMultiView)) {
-        rtInfo.viewMask = 0b11;
-    }
 
     VkGraphicsPipelineLibraryCreateInfoEXT libInfo = { VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_LIBRARY_CREATE_INFO_EXT, &rtInfo };
     libInfo.flags             = VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_SHADER_BIT_EXT;
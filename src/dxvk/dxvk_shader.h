@@ -181,6 +181,22 @@ namespace dxvk {
       return m_code.decompress();
     }
 
+    /**
+     * \brief Writes raw code to the given memory
+     * \param [out] dst At least \ref getRawCodeSize dwords
+     */
+    void getRawCode(uint32_t* dst) const {
+      m_code.decompressTo(dst);
+    }
+
+    /**
+     * \brief Raw code size
+     * \returns Code size, in dwords
+     */
+    size_t getRawCodeSize() const {
+      return m_code.size();
+    }
+
     /**
      * \brief Patches code using given info
      *
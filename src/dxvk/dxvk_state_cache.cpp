@@ -1,3 +1,7 @@
+#include <algorithm>
+#include <sstream>
+#include <tuple>
+
 #include "dxvk_device.h"
 #include "dxvk_pipemanager.h"
 #include "dxvk_state_cache.h"
@@ -26,6 +30,116 @@ namespace dxvk {
     uint32_t entrySize : 24;
   };
 
+
+  /**
+   * \brief State cache reader
+   *
+   * Reads data from a mapped cache file. Like a stream,
+   * the reader fails permanently once a read goes past
+   * the end of the data.
+   */
+  class DxvkStateCacheReader {
+
+  public:
+
+    DxvkStateCacheReader(const char* data, size_t size)
+    : m_data(data), m_size(size) { }
+
+    size_t offset() const {
+      return m_offset;
+    }
+
+    size_t remaining() const {
+      return m_size - m_offset;
+    }
+
+    const char* data() const {
+      return &m_data[m_offset];
+    }
+
+    bool read(void* data, size_t size) {
+      if (m_failed || size > remaining()) {
+        m_failed = true;
+        return false;
+      }
+
+      std::memcpy(data, &m_data[m_offset], size);
+      m_offset += size;
+      return true;
+    }
+
+    template<typename T>
+    bool read(T& data) {
+      return read(&data, sizeof(data));
+    }
+
+    bool skip(size_t size) {
+      if (m_failed || size > remaining()) {
+        m_failed = true;
+        return false;
+      }
+
+      m_offset += size;
+      return true;
+    }
+
+    explicit operator bool () const {
+      return !m_failed;
+    }
+
+  private:
+
+    const char* m_data;
+    size_t      m_size;
+    size_t      m_offset = 0;
+    bool        m_failed = false;
+
+  };
+
+
+  /**
+   * \brief Encoded cache entry
+   *
+   * Points to the encoded data of an entry, either inside
+   * the mapped cache file or in a buffer of newly encoded
+   * entries, so that entries can be re-indexed without
+   * decoding them.
+   */
+  struct DxvkStateCacheRawEntry {
+    DxvkStateCacheKey key;
+    const char*       data;
+    uint32_t          size;
+  };
+
+
+  static int compareShaderKeys(
+    const DxvkShaderKey&            a,
+    const DxvkShaderKey&            b) {
+    return std::memcmp(&a, &b, sizeof(DxvkShaderKey));
+  }
+
+
+  static int comparePipelineKeys(
+    const DxvkStateCacheKey&        a,
+    const DxvkStateCacheKey&        b) {
+    return std::memcmp(&a, &b, sizeof(DxvkStateCacheKey));
+  }
+
+
+  static int compareRawEntries(
+    const DxvkStateCacheRawEntry&   a,
+    const DxvkStateCacheRawEntry&   b) {
+    int cmp = comparePipelineKeys(a.key, b.key);
+
+    if (cmp)
+      return cmp;
+
+    if (a.size != b.size)
+      return a.size < b.size ? -1 : 1;
+
+    return std::memcmp(a.data, b.data, a.size);
+  }
+
   
   /**
    * \brief State cache entry data
@@ -118,6 +232,17 @@ namespace dxvk {
       if (version < 12)
         return true;
 
+      // v18 added the view mask
+      if (version < 18) {
+        DxvkRtInfoV17 v17;
+
+        if (!read(v17))
+          return false;
+
+        data = v17.convert();
+        return true;
+      }
+
       return read(data);
     }
 
@@ -181,11 +306,11 @@ namespace dxvk {
       return true;
     }
 
-    bool readFromStream(std::istream& stream, size_t size) {
+    bool readFrom(DxvkStateCacheReader& reader, size_t size) {
       if (size > MaxSize)
         return false;
 
-      if (!stream.read(m_data, size))
+      if (!reader.read(m_data, size))
         return false;
 
       m_size = size;
@@ -272,12 +397,12 @@ namespace dxvk {
     bool newFile = (useStateCache == "reset") || (!readCacheFile());
 
     if (newFile) {
-      auto file = openCacheFileForWrite(true);
+      // Valid entries of a corrupted file have already been
+      // rewritten at this point, so start from scratch.
+      m_file.reset();
+      m_index = DxvkStateCacheIndexHeader();
 
-      // Write all valid entries to the cache file in
-      // case we're recovering a corrupted cache file
-      for (auto& e : m_entries)
-        writeCacheEntry(file, e);
+      openCacheFileForWrite(true);
     }
   }
   
@@ -293,11 +418,16 @@ namespace dxvk {
       return;
 
     // Do not add an entry that is already in the cache
-    auto entries = m_entryMap.equal_range(shaders);
+    DxvkStateCacheIndexPipeline pipeline;
 
-    for (auto e = entries.first; e != entries.second; e++) {
-      if (m_entries[e->second].type == DxvkStateCacheEntryType::PipelineLibrary)
-        return;
+    if (findIndexedPipeline(shaders, pipeline)) {
+      for (uint32_t i = 0; i < pipeline.entryCount; i++) {
+        DxvkStateCacheEntry entry;
+
+        if (readIndexedEntry(pipeline.entryIndex + i, entry)
+         && entry.type == DxvkStateCacheEntryType::PipelineLibrary)
+          return;
+      }
     }
 
     // Queue a job to write this pipeline to the cache
@@ -319,12 +449,17 @@ namespace dxvk {
       return;
 
     // Do not add an entry that is already in the cache
-    auto entries = m_entryMap.equal_range(shaders);
+    DxvkStateCacheIndexPipeline pipeline;
 
-    for (auto e = entries.first; e != entries.second; e++) {
-      if (m_entries[e->second].type == DxvkStateCacheEntryType::MonolithicPipeline
-       && m_entries[e->second].gpState == state)
-        return;
+    if (findIndexedPipeline(shaders, pipeline)) {
+      for (uint32_t i = 0; i < pipeline.entryCount; i++) {
+        DxvkStateCacheEntry entry;
+
+        if (readIndexedEntry(pipeline.entryIndex + i, entry)
+         && entry.type == DxvkStateCacheEntryType::MonolithicPipeline
+         && entry.gpState == state)
+          return;
+      }
     }
 
     // Queue a job to write this pipeline to the cache
@@ -352,19 +487,31 @@ namespace dxvk {
     std::unique_lock<dxvk::mutex> entryLock(m_entryLock);
     m_shaderMap.insert({ key, shader });
 
+    // Look up pipelines using the shader in the index
+    DxvkStateCacheIndexShader shaderInfo;
+
+    if (!findIndexedShader(key, shaderInfo))
+      return;
+
     // Deferred lock, don't stall workers unless we have to
     std::unique_lock<dxvk::mutex> workerLock;
 
-    auto pipelines = m_pipelineMap.equal_range(key);
-
-    for (auto p = pipelines.first; p != pipelines.second; p++) {
+    for (uint32_t i = 0; i < shaderInfo.refCount; i++) {
       WorkerItem item;
+      item.pipelineIndex = readIndexTable<uint32_t>(
+        m_refTableOffset, shaderInfo.refIndex + i);
 
-      if (!getShaderByKey(p->second.vs,  item.gp.vs)
-       || !getShaderByKey(p->second.tcs, item.gp.tcs)
-       || !getShaderByKey(p->second.tes, item.gp.tes)
-       || !getShaderByKey(p->second.gs,  item.gp.gs)
-       || !getShaderByKey(p->second.fs,  item.gp.fs))
+      if (item.pipelineIndex >= m_index.pipelineCount)
+        continue;
+
+      auto pipeline = readIndexTable<DxvkStateCacheIndexPipeline>(
+        m_pipelineTableOffset, item.pipelineIndex);
+
+      if (!getShaderByKey(pipeline.key.vs,  item.gp.vs)
+       || !getShaderByKey(pipeline.key.tcs, item.gp.tcs)
+       || !getShaderByKey(pipeline.key.tes, item.gp.tes)
+       || !getShaderByKey(pipeline.key.gs,  item.gp.gs)
+       || !getShaderByKey(pipeline.key.fs,  item.gp.fs))
         continue;
       
       if (!workerLock)
@@ -399,11 +546,6 @@ namespace dxvk {
   }
 
 
-  DxvkShaderKey DxvkStateCache::getShaderKey(const Rc<DxvkShader>& shader) const {
-    return shader != nullptr ? shader->getShaderKey() : g_nullShaderKey;
-  }
-
-
   bool DxvkStateCache::getShaderByKey(
     const DxvkShaderKey&            key,
           Rc<DxvkShader>&           shader) const {
@@ -419,78 +561,167 @@ namespace dxvk {
   }
 
 
-  void DxvkStateCache::mapPipelineToEntry(
+  template<typename T>
+  T DxvkStateCache::readIndexTable(
+          size_t                    tableOffset,
+          uint32_t                  index) const {
+    T result;
+    std::memcpy(&result, &m_file.data()[tableOffset + sizeof(T) * index], sizeof(T));
+    return result;
+  }
+
+
+  bool DxvkStateCache::findIndexedShader(
+    const DxvkShaderKey&            key,
+          DxvkStateCacheIndexShader& shader) const {
+    // The shader table is sorted by key
+    uint32_t lo = 0;
+    uint32_t hi = m_index.shaderCount;
+
+    while (lo < hi) {
+      uint32_t mid = lo + (hi - lo) / 2;
+      shader = readIndexTable<DxvkStateCacheIndexShader>(m_shaderTableOffset, mid);
+
+      int cmp = compareShaderKeys(shader.key, key);
+
+      if (!cmp) {
+        return shader.refIndex <= m_index.shaderRefCount
+            && shader.refCount <= m_index.shaderRefCount - shader.refIndex;
+      }
+
+      if (cmp < 0)
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+
+    return false;
+  }
+
+
+  bool DxvkStateCache::findIndexedPipeline(
     const DxvkStateCacheKey&        key,
-          size_t                    entryId) {
-    m_entryMap.insert({ key, entryId });
+          DxvkStateCacheIndexPipeline& pipeline) const {
+    // Every pipeline has a vertex shader, so
+    // only look at pipelines referencing it
+    DxvkStateCacheIndexShader shader;
+
+    if (!findIndexedShader(key.vs, shader))
+      return false;
+
+    for (uint32_t i = 0; i < shader.refCount; i++) {
+      uint32_t pipelineIndex = readIndexTable<uint32_t>(
+        m_refTableOffset, shader.refIndex + i);
+
+      if (pipelineIndex >= m_index.pipelineCount)
+        continue;
+
+      pipeline = readIndexTable<DxvkStateCacheIndexPipeline>(
+        m_pipelineTableOffset, pipelineIndex);
+
+      if (pipeline.key.eq(key))
+        return true;
+    }
+
+    return false;
   }
 
-  
-  void DxvkStateCache::mapShaderToPipeline(
-    const DxvkShaderKey&            shader,
-    const DxvkStateCacheKey&        key) {
-    if (!shader.eq(g_nullShaderKey))
-      m_pipelineMap.insert({ shader, key });
+
+  bool DxvkStateCache::readIndexedEntry(
+          uint32_t                  index,
+          DxvkStateCacheEntry&      entry) const {
+    if (index >= m_index.entryCount)
+      return false;
+
+    auto info = readIndexTable<DxvkStateCacheIndexEntry>(m_entryTableOffset, index);
+
+    if (info.offset > m_index.dataSize
+     || info.size > m_index.dataSize - info.offset)
+      return false;
+
+    DxvkStateCacheReader reader(
+      &m_file.data()[m_dataOffset + info.offset], info.size);
+
+    return readCacheEntry(DxvkStateCacheHeader().version, reader, entry);
   }
 
 
-  void DxvkStateCache::compilePipelines(const WorkerItem& item) {
-    DxvkStateCacheKey key;
-    key.vs  = getShaderKey(item.gp.vs);
-    key.tcs = getShaderKey(item.gp.tcs);
-    key.tes = getShaderKey(item.gp.tes);
-    key.gs  = getShaderKey(item.gp.gs);
-    key.fs  = getShaderKey(item.gp.fs);
+  void DxvkStateCache::compilePipelines(
+          std::vector<WorkerItem>&  items) {
+    // Order pipelines by their pre-rasterization shaders, so
+    // that pipelines sharing a pipeline library get queued
+    // back to back once the library itself has been queued.
+    std::sort(items.begin(), items.end(), [] (const WorkerItem& a, const WorkerItem& b) {
+      return std::make_tuple(a.gp.vs.ptr(), a.gp.tcs.ptr(), a.gp.tes.ptr(), a.gp.gs.ptr(), a.pipelineIndex)
+           < std::make_tuple(b.gp.vs.ptr(), b.gp.tcs.ptr(), b.gp.tes.ptr(), b.gp.gs.ptr(), b.pipelineIndex);
+    });
+
+    DxvkPipelineBatch batch;
+
+    for (const auto& item : items) {
+      auto pipelineInfo = readIndexTable<DxvkStateCacheIndexPipeline>(
+        m_pipelineTableOffset, item.pipelineIndex);
 
-    DxvkGraphicsPipeline* pipeline = nullptr;
-    auto entries = m_entryMap.equal_range(key);
+      DxvkGraphicsPipeline* pipeline = nullptr;
 
-    for (auto e = entries.first; e != entries.second; e++) {
-      const auto& entry = m_entries[e->second];
+      for (uint32_t i = 0; i < pipelineInfo.entryCount; i++) {
+        // Entries are only decoded when the pipeline gets compiled
+        DxvkStateCacheEntry entry;
 
-      switch (entry.type) {
-        case DxvkStateCacheEntryType::MonolithicPipeline: {
-          if (!pipeline)
-            pipeline = m_pipeManager->createGraphicsPipeline(item.gp);
+        if (!readIndexedEntry(pipelineInfo.entryIndex + i, entry)
+         || !entry.shaders.eq(pipelineInfo.key))
+          continue;
 
-          m_pipeWorkers->compileGraphicsPipeline(pipeline, entry.gpState, DxvkPipelinePriority::Normal);
-        } break;
+        switch (entry.type) {
+          case DxvkStateCacheEntryType::MonolithicPipeline: {
+            if (!pipeline)
+              pipeline = m_pipeManager->createGraphicsPipeline(item.gp);
 
-        case DxvkStateCacheEntryType::PipelineLibrary: {
-          if (!m_device->canUseGraphicsPipelineLibrary() || item.gp.vs == nullptr)
-            break;
+            batch.pipelines.push_back({ pipeline, entry.gpState });
+          } break;
 
-          DxvkShaderPipelineLibraryKey libraryKey;
-          libraryKey.addShader(item.gp.vs);
+          case DxvkStateCacheEntryType::PipelineLibrary: {
+            if (!m_device->canUseGraphicsPipelineLibrary() || item.gp.vs == nullptr)
+              break;
 
-          if (item.gp.tcs != nullptr) libraryKey.addShader(item.gp.tcs);
-          if (item.gp.tes != nullptr) libraryKey.addShader(item.gp.tes);
-          if (item.gp.gs  != nullptr) libraryKey.addShader(item.gp.gs);
+            DxvkShaderPipelineLibraryKey libraryKey;
+            libraryKey.addShader(item.gp.vs);
 
-          auto pipelineLibrary = m_pipeManager->createShaderPipelineLibrary(libraryKey);
-          m_pipeWorkers->compilePipelineLibrary(pipelineLibrary, DxvkPipelinePriority::Normal);
-        } break;
+            if (item.gp.tcs != nullptr) libraryKey.addShader(item.gp.tcs);
+            if (item.gp.tes != nullptr) libraryKey.addShader(item.gp.tes);
+            if (item.gp.gs  != nullptr) libraryKey.addShader(item.gp.gs);
+
+            auto pipelineLibrary = m_pipeManager->createShaderPipelineLibrary(libraryKey);
+
+            // The pipeline manager returns the same library for
+            // the same set of shaders, only queue it once
+            if (batch.libraries.empty() || batch.libraries.back() != pipelineLibrary)
+              batch.libraries.push_back(pipelineLibrary);
+          } break;
+        }
       }
     }
+
+    m_pipeWorkers->compilePipelineBatch(batch, DxvkPipelinePriority::Normal);
   }
 
 
   bool DxvkStateCache::readCacheFile() {
     // Return success if the file was not found.
     // This way we will only create it on demand.
-    std::ifstream ifile = openCacheFileForRead();
-
-    if (!ifile) {
+    if (!mapCacheFile()) {
       Logger::warn("DXVK: No state cache file found");
       return true;
     }
 
+    DxvkStateCacheReader reader(m_file.data(), m_file.size());
+
     // The header stores the state cache version,
     // we need to regenerate it if it's outdated
     DxvkStateCacheHeader newHeader;
     DxvkStateCacheHeader curHeader;
 
-    if (!readCacheHeader(ifile, curHeader)) {
+    if (!readCacheHeader(reader, curHeader)) {
       Logger::warn("DXVK: Failed to read state cache header");
       return false;
     }
@@ -506,55 +737,98 @@ namespace dxvk {
     if (curHeader.version != newHeader.version)
       Logger::warn(str::format("DXVK: Updating state cache version to v", newHeader.version));
 
-    // Read actual cache entries from the file.
-    // If we encounter invalid entries, we should
-    // regenerate the entire state cache file.
-    uint32_t numInvalidEntries = 0;
-
-    while (ifile) {
-      DxvkStateCacheEntry entry;
-
-      if (readCacheEntry(curHeader.version, ifile, entry)) {
-        size_t entryId = m_entries.size();
-        m_entries.push_back(entry);
-
-        mapPipelineToEntry(entry.shaders, entryId);
-
-        mapShaderToPipeline(entry.shaders.vs,  entry.shaders);
-        mapShaderToPipeline(entry.shaders.tcs, entry.shaders);
-        mapShaderToPipeline(entry.shaders.tes, entry.shaders);
-        mapShaderToPipeline(entry.shaders.gs,  entry.shaders);
-        mapShaderToPipeline(entry.shaders.fs,  entry.shaders);
-      } else if (ifile) {
-        numInvalidEntries += 1;
-      }
+    // Indexed entries are decoded on demand, only entries
+    // that were appended after the index was written, or
+    // all entries of older files, need to be read here.
+    if (curHeader.version >= 19 && !mapCacheIndex(reader)) {
+      Logger::warn("DXVK: Failed to read state cache index");
+      return false;
     }
 
+    std::vector<DxvkStateCacheEntry> entries;
+    uint32_t numInvalidEntries = readCacheEntries(curHeader.version, reader, entries);
+
     Logger::info(str::format(
-      "DXVK: Read ", m_entries.size(),
+      "DXVK: Read ", m_index.entryCount + entries.size(),
       " valid state cache entries"));
 
     if (numInvalidEntries) {
       Logger::warn(str::format(
         "DXVK: Skipped ", numInvalidEntries,
         " invalid state cache entries"));
-      return false;
     }
-    
-    // Rewrite entire state cache if it is outdated
-    return curHeader.version == newHeader.version;
+
+    if (curHeader.version == newHeader.version
+     && entries.empty() && !numInvalidEntries)
+      return true;
+
+    // Rewrite the cache file with all valid entries indexed, so
+    // that we don't have to read them again. Indexed entries are
+    // copied as-is, only the remaining entries need encoding.
+    std::vector<DxvkStateCacheRawEntry> rawEntries;
+    rawEntries.reserve(m_index.entryCount + entries.size());
+
+    for (uint32_t i = 0; i < m_index.pipelineCount; i++) {
+      auto pipeline = readIndexTable<DxvkStateCacheIndexPipeline>(m_pipelineTableOffset, i);
+
+      if (pipeline.entryIndex > m_index.entryCount
+       || pipeline.entryCount > m_index.entryCount - pipeline.entryIndex)
+        continue;
+
+      for (uint32_t j = 0; j < pipeline.entryCount; j++) {
+        auto info = readIndexTable<DxvkStateCacheIndexEntry>(m_entryTableOffset, pipeline.entryIndex + j);
+
+        if (info.offset > m_index.dataSize
+         || info.size > m_index.dataSize - info.offset)
+          continue;
+
+        rawEntries.push_back({ pipeline.key, &m_file.data()[m_dataOffset + info.offset], info.size });
+      }
+    }
+
+    std::string encoded;
+    encodeCacheEntries(entries, encoded, rawEntries);
+
+    // The raw entries point into the mapped file,
+    // so build the new file before replacing it
+    return writeCacheFile(buildCacheFile(rawEntries));
+  }
+
+
+  bool DxvkStateCache::mapCacheFile() {
+    m_file = FileMapping(getCacheFileName());
+    return m_file.isOpen();
+  }
+
+
+  bool DxvkStateCache::mapCacheIndex(
+          DxvkStateCacheReader&     reader) {
+    DxvkStateCacheIndexHeader index;
+
+    size_t tableOffset = reader.offset() + sizeof(index);
+
+    if (!readCacheIndex(reader, index))
+      return false;
+
+    m_index = index;
+
+    m_shaderTableOffset   = tableOffset;
+    m_refTableOffset      = m_shaderTableOffset + index.shaderCount * sizeof(DxvkStateCacheIndexShader);
+    m_pipelineTableOffset = m_refTableOffset + index.shaderRefCount * sizeof(uint32_t);
+    m_entryTableOffset    = m_pipelineTableOffset + index.pipelineCount * sizeof(DxvkStateCacheIndexPipeline);
+    m_dataOffset          = m_entryTableOffset + index.entryCount * sizeof(DxvkStateCacheIndexEntry);
+
+    // Skip indexed entry data
+    return reader.skip(index.dataSize);
   }
 
 
   bool DxvkStateCache::readCacheHeader(
-          std::istream&             stream,
-          DxvkStateCacheHeader&     header) const {
+          DxvkStateCacheReader&     reader,
+          DxvkStateCacheHeader&     header) {
     DxvkStateCacheHeader expected;
 
-    auto data = reinterpret_cast<char*>(&header);
-    auto size = sizeof(header);
-
-    if (!stream.read(data, size))
+    if (!reader.read(header))
       return false;
     
     for (uint32_t i = 0; i < 4; i++) {
@@ -566,10 +840,52 @@ namespace dxvk {
   }
 
 
+  bool DxvkStateCache::readCacheIndex(
+          DxvkStateCacheReader&     reader,
+          DxvkStateCacheIndexHeader& index) {
+    if (!reader.read(index))
+      return false;
+
+    uint64_t tableSize =
+      uint64_t(index.shaderCount)    * sizeof(DxvkStateCacheIndexShader) +
+      uint64_t(index.shaderRefCount) * sizeof(uint32_t) +
+      uint64_t(index.pipelineCount)  * sizeof(DxvkStateCacheIndexPipeline) +
+      uint64_t(index.entryCount)     * sizeof(DxvkStateCacheIndexEntry);
+
+    if (tableSize > reader.remaining()
+     || index.dataSize > reader.remaining() - tableSize)
+      return false;
+
+    if (index.hash != Sha1Hash::compute(reader.data(), tableSize))
+      return false;
+
+    return reader.skip(tableSize);
+  }
+
+
+  uint32_t DxvkStateCache::readCacheEntries(
+          uint32_t                  version,
+          DxvkStateCacheReader&     reader,
+          std::vector<DxvkStateCacheEntry>& entries) {
+    uint32_t numInvalidEntries = 0;
+
+    while (reader && reader.remaining()) {
+      DxvkStateCacheEntry entry;
+
+      if (readCacheEntry(version, reader, entry))
+        entries.push_back(entry);
+      else if (reader)
+        numInvalidEntries += 1;
+    }
+
+    return numInvalidEntries;
+  }
+
+
   bool DxvkStateCache::readCacheEntry(
           uint32_t                  version,
-          std::istream&             stream, 
-          DxvkStateCacheEntry&      entry) const {
+          DxvkStateCacheReader&     reader,
+          DxvkStateCacheEntry&      entry) {
     // Read entry metadata and actual data
     DxvkStateCacheEntryHeader header;
     DxvkStateCacheEntryData data;
@@ -577,14 +893,14 @@ namespace dxvk {
     Sha1Hash hash;
 
     if (version >= 16) {
-      if (!stream.read(reinterpret_cast<char*>(&header), sizeof(header)))
+      if (!reader.read(header))
         return false;
 
       stageMask = VkShaderStageFlags(header.stageMask);
     } else {
       DxvkStateCacheEntryHeaderV8 headerV8;
 
-      if (!stream.read(reinterpret_cast<char*>(&headerV8), sizeof(headerV8)))
+      if (!reader.read(headerV8))
         return false;
 
       header.entryType = uint32_t(DxvkStateCacheEntryType::MonolithicPipeline);
@@ -594,8 +910,8 @@ namespace dxvk {
       stageMask = VkShaderStageFlags(headerV8.stageMask);
     }
 
-    if (!stream.read(reinterpret_cast<char*>(&hash), sizeof(hash))
-     || !data.readFromStream(stream, header.entrySize))
+    if (!reader.read(hash)
+     || !data.readFrom(reader, header.entrySize))
       return false;
 
     // Validate hash, skip entry if invalid
@@ -690,7 +1006,7 @@ namespace dxvk {
 
   void DxvkStateCache::writeCacheEntry(
           std::ostream&             stream, 
-          DxvkStateCacheEntry&      entry) const {
+    const DxvkStateCacheEntry&      entry) {
     DxvkStateCacheEntryData data;
     VkShaderStageFlags stageMask = 0;
 
@@ -765,12 +1081,246 @@ namespace dxvk {
   }
 
 
+  void DxvkStateCache::encodeCacheEntries(
+    const std::vector<DxvkStateCacheEntry>& entries,
+          std::string&              data,
+          std::vector<DxvkStateCacheRawEntry>& rawEntries) {
+    std::ostringstream stream;
+    std::vector<size_t> offsets;
+    offsets.reserve(entries.size() + 1);
+
+    for (const auto& e : entries) {
+      offsets.push_back(size_t(stream.tellp()));
+      writeCacheEntry(stream, e);
+    }
+
+    offsets.push_back(size_t(stream.tellp()));
+
+    // Raw entries point into the data string
+    data = stream.str();
+
+    for (size_t i = 0; i < entries.size(); i++) {
+      rawEntries.push_back({ entries[i].shaders, &data[offsets[i]],
+        uint32_t(offsets[i + 1] - offsets[i]) });
+    }
+  }
+
+
+  bool DxvkStateCache::writeCacheFile(
+    const std::string&              fileData) {
+    // Write the new file under a temporary name and move it over
+    // the old one. Other state cache instances, e.g. of another
+    // device in the same process, may still have the old file
+    // mapped, so it must not be truncated in place.
+    str::path_string fileName = getCacheFileName();
+    str::path_string tempName = fileName + str::topath(str::format(
+      ".", reinterpret_cast<uintptr_t>(this),
+      ".", high_resolution_clock::now().time_since_epoch().count(), ".tmp").c_str());
+
+    std::ofstream file = createCacheFile(tempName);
+
+    if (file) {
+      file.write(fileData.data(), fileData.size());
+      file.close();
+    }
+
+    bool replaced = file && env::replaceFile(tempName, fileName);
+
+    // Windows does not replace files with open mappings,
+    // so release our own mapping and try again.
+    if (file && !replaced) {
+      m_file.reset();
+      replaced = env::replaceFile(tempName, fileName);
+    }
+
+    if (!replaced) {
+      Logger::warn("DXVK: Failed to write state cache file");
+      env::removeFile(tempName);
+    }
+
+    // Map the new file, or the old one again if our mapping
+    // was released. Otherwise, keep using the old mapping.
+    if (replaced || !m_file.isOpen()) {
+      m_file.reset();
+
+      if (!mapCacheFile())
+        return false;
+    }
+
+    m_index = DxvkStateCacheIndexHeader();
+
+    DxvkStateCacheReader reader(m_file.data(), m_file.size());
+    DxvkStateCacheHeader header;
+
+    if (!readCacheHeader(reader, header)
+     || header.version != DxvkStateCacheHeader().version
+     || !mapCacheIndex(reader))
+      return false;
+
+    Logger::info(str::format("DXVK: Indexed ", m_index.entryCount,
+      " state cache entries for ", m_index.pipelineCount, " pipelines"));
+    return true;
+  }
+
+
+  std::string DxvkStateCache::buildCacheFile(
+    const std::vector<DxvkStateCacheEntry>& entries) {
+    std::vector<DxvkStateCacheRawEntry> rawEntries;
+    rawEntries.reserve(entries.size());
+
+    std::string encoded;
+    encodeCacheEntries(entries, encoded, rawEntries);
+    return buildCacheFile(rawEntries);
+  }
+
+
+  std::string DxvkStateCache::buildCacheFile(
+          std::vector<DxvkStateCacheRawEntry>& entries) {
+    // Group entries by pipeline and order them by their encoded
+    // data, so that duplicates end up next to each other
+    std::sort(entries.begin(), entries.end(),
+      [] (const DxvkStateCacheRawEntry& a, const DxvkStateCacheRawEntry& b) {
+        return compareRawEntries(a, b) < 0;
+      });
+
+    std::vector<DxvkStateCacheIndexPipeline> pipelines;
+    std::vector<DxvkStateCacheIndexEntry> entryTable;
+    std::string entryData;
+
+    for (size_t i = 0; i < entries.size(); i++) {
+      const auto& e = entries[i];
+
+      if (i && !compareRawEntries(entries[i - 1], e))
+        continue;
+
+      if (pipelines.empty() || !pipelines.back().key.eq(e.key)) {
+        DxvkStateCacheIndexPipeline pipeline;
+        pipeline.key = e.key;
+        pipeline.entryIndex = uint32_t(entryTable.size());
+        pipeline.entryCount = 0;
+        pipelines.push_back(pipeline);
+      }
+
+      DxvkStateCacheIndexEntry entry;
+      entry.offset = entryData.size();
+      entry.size = e.size;
+      entry.reserved = 0;
+
+      entryData.append(e.data, e.size);
+      entryTable.push_back(entry);
+      pipelines.back().entryCount += 1;
+    }
+
+    // Map every shader to the pipelines using it
+    std::vector<std::pair<DxvkShaderKey, uint32_t>> shaderRefs;
+
+    for (uint32_t i = 0; i < pipelines.size(); i++) {
+      const auto& key = pipelines[i].key;
+
+      for (const auto* shader : { &key.vs, &key.tcs, &key.tes, &key.gs, &key.fs }) {
+        if (!shader->eq(g_nullShaderKey))
+          shaderRefs.push_back({ *shader, i });
+      }
+    }
+
+    std::sort(shaderRefs.begin(), shaderRefs.end(),
+      [] (const std::pair<DxvkShaderKey, uint32_t>& a, const std::pair<DxvkShaderKey, uint32_t>& b) {
+        int cmp = compareShaderKeys(a.first, b.first);
+        return cmp < 0 || (!cmp && a.second < b.second);
+      });
+
+    std::vector<DxvkStateCacheIndexShader> shaders;
+    std::vector<uint32_t> refTable;
+
+    for (const auto& r : shaderRefs) {
+      if (shaders.empty() || !shaders.back().key.eq(r.first)) {
+        DxvkStateCacheIndexShader shader;
+        shader.key = r.first;
+        shader.refIndex = uint32_t(refTable.size());
+        shader.refCount = 0;
+        shaders.push_back(shader);
+      }
+
+      refTable.push_back(r.second);
+      shaders.back().refCount += 1;
+    }
+
+    // Lay out index tables back to back so that
+    // they can be validated with a single hash
+    std::string tables;
+    tables.append(reinterpret_cast<const char*>(shaders.data()),    shaders.size()    * sizeof(DxvkStateCacheIndexShader));
+    tables.append(reinterpret_cast<const char*>(refTable.data()),   refTable.size()   * sizeof(uint32_t));
+    tables.append(reinterpret_cast<const char*>(pipelines.data()),  pipelines.size()  * sizeof(DxvkStateCacheIndexPipeline));
+    tables.append(reinterpret_cast<const char*>(entryTable.data()), entryTable.size() * sizeof(DxvkStateCacheIndexEntry));
+
+    DxvkStateCacheHeader header;
+    DxvkStateCacheIndexHeader index;
+    index.shaderCount     = uint32_t(shaders.size());
+    index.shaderRefCount  = uint32_t(refTable.size());
+    index.pipelineCount   = uint32_t(pipelines.size());
+    index.entryCount      = uint32_t(entryTable.size());
+    index.dataSize        = entryData.size();
+    index.hash            = Sha1Hash::compute(tables.data(), tables.size());
+
+    std::string result;
+    result.reserve(sizeof(header) + sizeof(index) + tables.size() + entryData.size());
+    result.append(reinterpret_cast<const char*>(&header), sizeof(header));
+    result.append(reinterpret_cast<const char*>(&index), sizeof(index));
+    result.append(tables);
+    result.append(entryData);
+    return result;
+  }
+
+
+  int32_t DxvkStateCache::importCacheFile(
+    const str::path_string&               path,
+          std::vector<DxvkStateCacheEntry>& entries,
+          uint32_t&                       version) {
+    FileMapping file(path);
+
+    if (!file.isOpen())
+      return -1;
+
+    DxvkStateCacheReader reader(file.data(), file.size());
+    DxvkStateCacheHeader header;
+
+    if (!readCacheHeader(reader, header)
+     || header.version < 8 || header.version == 16
+     || header.version > DxvkStateCacheHeader().version)
+      return -1;
+
+    version = header.version;
+
+    // Indexed entry data is followed by appended
+    // entries, so both can be read in one go
+    DxvkStateCacheIndexHeader index;
+
+    if (header.version >= 19 && !readCacheIndex(reader, index))
+      return -1;
+
+    return int32_t(readCacheEntries(header.version, reader, entries));
+  }
+
+
+  bool DxvkStateCache::exportCacheFile(
+    const str::path_string&               path,
+    const std::vector<DxvkStateCacheEntry>& entries) {
+    std::string fileData = buildCacheFile(entries);
+
+    std::ofstream file(path.c_str(), std::ios_base::binary | std::ios_base::trunc);
+    file.write(fileData.data(), fileData.size());
+    file.close();
+
+    return bool(file);
+  }
+
+
   void DxvkStateCache::workerFunc() {
     env::setThreadName("dxvk-worker");
 
-    while (!m_stopThreads.load()) {
-      WorkerItem item;
+    std::vector<WorkerItem> items;
 
+    while (!m_stopThreads.load()) {
       { std::unique_lock<dxvk::mutex> lock(m_workerLock);
 
         if (m_workerQueue.empty()) {
@@ -783,11 +1333,16 @@ namespace dxvk {
         if (m_workerQueue.empty())
           break;
         
-        item = m_workerQueue.front();
-        m_workerQueue.pop();
+        // Take everything that became compilable
+        // so that it can be scheduled as one batch
+        while (!m_workerQueue.empty()) {
+          items.push_back(std::move(m_workerQueue.front()));
+          m_workerQueue.pop();
+        }
       }
 
-      compilePipelines(item);
+      compilePipelines(items);
+      items.clear();
     }
   }
 
@@ -851,6 +1406,22 @@ namespace dxvk {
   }
 
 
+  std::ofstream DxvkStateCache::createCacheFile(
+    const str::path_string&         fileName) const {
+    std::ofstream file(fileName.c_str(),
+      std::ios_base::binary |
+      std::ios_base::trunc);
+
+    if (!file && env::createDirectory(getCacheDir())) {
+      file = std::ofstream(fileName.c_str(),
+        std::ios_base::binary |
+        std::ios_base::trunc);
+    }
+
+    return file;
+  }
+
+
   std::ofstream DxvkStateCache::openCacheFileForWrite(bool recreate) const {
     std::ofstream file;
 
@@ -861,15 +1432,7 @@ namespace dxvk {
     }
 
     if (recreate) {
-      file = std::ofstream(getCacheFileName().c_str(),
-        std::ios_base::binary |
-        std::ios_base::trunc);
-
-      if (!file && env::createDirectory(getCacheDir())) {
-        file = std::ofstream(getCacheFileName().c_str(),
-          std::ios_base::binary |
-          std::ios_base::trunc);
-      }
+      file = createCacheFile(getCacheFileName());
     } else {
       file = std::ofstream(getCacheFileName().c_str(),
         std::ios_base::binary |
@@ -882,13 +1445,15 @@ namespace dxvk {
     if (recreate) {
       Logger::warn("DXVK: Creating new state cache file");
 
-      // Write header with the current version number
+      // Write header with the current version number,
+      // followed by an empty index. Entries written
+      // from now on will be indexed on the next run.
       DxvkStateCacheHeader header;
+      DxvkStateCacheIndexHeader index;
+      index.hash = g_nullHash;
 
-      auto data = reinterpret_cast<const char*>(&header);
-      auto size = sizeof(header);
-
-      file.write(data, size);
+      file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+      file.write(reinterpret_cast<const char*>(&index), sizeof(index));
     }
 
     return file;
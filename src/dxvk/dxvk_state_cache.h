@@ -10,11 +10,15 @@
 
 #include "dxvk_state_cache_types.h"
 
+#include "../util/util_file_map.h"
+
 namespace dxvk {
 
   class DxvkDevice;
   class DxvkPipelineManager;
   class DxvkPipelineWorkers;
+  class DxvkStateCacheReader;
+  struct DxvkStateCacheRawEntry;
 
   /**
    * \brief State cache
@@ -24,6 +28,10 @@ namespace dxvk {
    * game, which allows DXVK to compile them ahead
    * of time instead of compiling them on the first
    * draw.
+   *
+   * The cache file is memory-mapped and indexed by
+   * shader key, entries are only decoded once all
+   * shaders required by the pipeline are available.
    */
   class DxvkStateCache {
 
@@ -74,12 +82,44 @@ namespace dxvk {
      */
     void stopWorkers();
 
+    /**
+     * \brief Reads all entries from a cache file
+     *
+     * Decodes indexed and appended entries alike, and converts
+     * entries from older file versions. Does not require a
+     * device, so that offline tools can use it.
+     * \param [in] path Cache file path
+     * \param [out] entries Valid entries, in file order
+     * \param [out] version File version
+     * \returns Number of invalid entries, or \c -1 if
+     *    the file could not be read or is not supported
+     */
+    static int32_t importCacheFile(
+      const str::path_string&               path,
+            std::vector<DxvkStateCacheEntry>& entries,
+            uint32_t&                       version);
+
+    /**
+     * \brief Writes an indexed cache file
+     *
+     * Entries are grouped by pipeline, and entries that
+     * encode to the same data as a previous entry of the
+     * same pipeline are dropped.
+     * \param [in] path Cache file path
+     * \param [in] entries Entries to write
+     * \returns \c true on success
+     */
+    static bool exportCacheFile(
+      const str::path_string&               path,
+      const std::vector<DxvkStateCacheEntry>& entries);
+
   private:
 
     using WriterItem = DxvkStateCacheEntry;
 
     struct WorkerItem {
       DxvkGraphicsPipelineShaders gp;
+      uint32_t                    pipelineIndex;
     };
 
     DxvkDevice*                       m_device;
@@ -87,19 +127,19 @@ namespace dxvk {
     DxvkPipelineWorkers*              m_pipeWorkers;
     bool                              m_enable = false;
 
-    std::vector<DxvkStateCacheEntry>  m_entries;
     std::atomic<bool>                 m_stopThreads = { false };
 
-    dxvk::mutex                       m_entryLock;
+    FileMapping                       m_file;
+    DxvkStateCacheIndexHeader         m_index;
 
-    std::unordered_multimap<
-      DxvkStateCacheKey, size_t,
-      DxvkHash, DxvkEq> m_entryMap;
+    size_t                            m_shaderTableOffset   = 0;
+    size_t                            m_refTableOffset      = 0;
+    size_t                            m_pipelineTableOffset = 0;
+    size_t                            m_entryTableOffset    = 0;
+    size_t                            m_dataOffset          = 0;
+
+    dxvk::mutex                       m_entryLock;
 
-    std::unordered_multimap<
-      DxvkShaderKey, DxvkStateCacheKey,
-      DxvkHash, DxvkEq> m_pipelineMap;
-    
     std::unordered_map<
       DxvkShaderKey, Rc<DxvkShader>,
       DxvkHash, DxvkEq> m_shaderMap;
@@ -114,38 +154,72 @@ namespace dxvk {
     std::queue<WriterItem>            m_writerQueue;
     dxvk::thread                      m_writerThread;
 
-    DxvkShaderKey getShaderKey(
-      const Rc<DxvkShader>&           shader) const;
-
     bool getShaderByKey(
       const DxvkShaderKey&            key,
             Rc<DxvkShader>&           shader) const;
     
-    void mapPipelineToEntry(
+    bool findIndexedShader(
+      const DxvkShaderKey&            key,
+            DxvkStateCacheIndexShader& shader) const;
+
+    bool findIndexedPipeline(
       const DxvkStateCacheKey&        key,
-            size_t                    entryId);
-    
-    void mapShaderToPipeline(
-      const DxvkShaderKey&            shader,
-      const DxvkStateCacheKey&        key);
+            DxvkStateCacheIndexPipeline& pipeline) const;
+
+    bool readIndexedEntry(
+            uint32_t                  index,
+            DxvkStateCacheEntry&      entry) const;
+
+    template<typename T>
+    T readIndexTable(
+            size_t                    tableOffset,
+            uint32_t                  index) const;
 
     void compilePipelines(
-      const WorkerItem&               item);
+            std::vector<WorkerItem>&  items);
 
     bool readCacheFile();
 
-    bool readCacheHeader(
-            std::istream&             stream,
-            DxvkStateCacheHeader&     header) const;
+    bool mapCacheFile();
+
+    bool mapCacheIndex(
+            DxvkStateCacheReader&     reader);
+
+    bool writeCacheFile(
+      const std::string&              fileData);
+
+    static bool readCacheHeader(
+            DxvkStateCacheReader&     reader,
+            DxvkStateCacheHeader&     header);
+
+    static bool readCacheIndex(
+            DxvkStateCacheReader&     reader,
+            DxvkStateCacheIndexHeader& index);
 
-    bool readCacheEntry(
+    static bool readCacheEntry(
             uint32_t                  version,
-            std::istream&             stream, 
-            DxvkStateCacheEntry&      entry) const;
+            DxvkStateCacheReader&     reader,
+            DxvkStateCacheEntry&      entry);
+
+    static uint32_t readCacheEntries(
+            uint32_t                  version,
+            DxvkStateCacheReader&     reader,
+            std::vector<DxvkStateCacheEntry>& entries);
     
-    void writeCacheEntry(
+    static void writeCacheEntry(
             std::ostream&             stream, 
-            DxvkStateCacheEntry&      entry) const;
+      const DxvkStateCacheEntry&      entry);
+
+    static void encodeCacheEntries(
+      const std::vector<DxvkStateCacheEntry>& entries,
+            std::string&              data,
+            std::vector<DxvkStateCacheRawEntry>& rawEntries);
+
+    static std::string buildCacheFile(
+      const std::vector<DxvkStateCacheEntry>& entries);
+
+    static std::string buildCacheFile(
+            std::vector<DxvkStateCacheRawEntry>& entries);
     
     void workerFunc();
 
@@ -159,6 +233,9 @@ namespace dxvk {
 
     std::ifstream openCacheFileForRead() const;
 
+    std::ofstream createCacheFile(
+      const str::path_string&         fileName) const;
+
     std::ofstream openCacheFileForWrite(
             bool                      recreate) const;
 
@@ -60,12 +60,80 @@ namespace dxvk {
    */
   struct DxvkStateCacheHeader {
     char     magic[4]   = { 'D', 'X', 'V', 'K' };
-    uint32_t version    = 17;
+    uint32_t version    = 19;
     uint32_t entrySize  = 0; /* no longer meaningful */
   };
 
   static_assert(sizeof(DxvkStateCacheHeader) == 12);
 
+
+  /**
+   * \brief State cache index header
+   *
+   * Follows the file header since v19. The header is followed
+   * by the shader table, the shader reference table, the pipeline
+   * table and the entry table, and then by the data of all indexed
+   * entries. Entries added after the index was written are appended
+   * to the end of the file and get indexed on the next run.
+   */
+  struct DxvkStateCacheIndexHeader {
+    uint32_t shaderCount    = 0;
+    uint32_t shaderRefCount = 0;
+    uint32_t pipelineCount  = 0;
+    uint32_t entryCount     = 0;
+    uint64_t dataSize       = 0;
+    Sha1Hash hash;          /* hash of all index tables */
+    uint32_t reserved       = 0;
+  };
+
+  static_assert(sizeof(DxvkStateCacheIndexHeader) == 48);
+
+
+  /**
+   * \brief Shader table entry
+   *
+   * Shaders are sorted by key. Points to a range of
+   * the shader reference table, which stores indices
+   * of all pipelines that use the shader.
+   */
+  struct DxvkStateCacheIndexShader {
+    DxvkShaderKey key;
+    uint32_t      refIndex;
+    uint32_t      refCount;
+  };
+
+  static_assert(sizeof(DxvkStateCacheIndexShader) == 32);
+
+
+  /**
+   * \brief Pipeline table entry
+   *
+   * Points to a range of the entry table
+   * that stores all entries for the pipeline.
+   */
+  struct DxvkStateCacheIndexPipeline {
+    DxvkStateCacheKey key;
+    uint32_t          entryIndex;
+    uint32_t          entryCount;
+  };
+
+  static_assert(sizeof(DxvkStateCacheIndexPipeline) == 128);
+
+
+  /**
+   * \brief Entry table entry
+   *
+   * Locates an encoded entry, relative to
+   * the start of the entry data.
+   */
+  struct DxvkStateCacheIndexEntry {
+    uint64_t offset;
+    uint32_t size;
+    uint32_t reserved;
+  };
+
+  static_assert(sizeof(DxvkStateCacheIndexEntry) == 16);
+
   using DxvkBindingMaskV10 = DxvkBindingSet<384>;
   using DxvkBindingMaskV8 = DxvkBindingSet<128>;
 
@@ -117,7 +185,22 @@ namespace dxvk {
         colorFormats[i] = color[i].format;
 
       return DxvkRtInfo(MaxNumRenderTargets, colorFormats.data(),
-        depth.format, readOnlyAspects);
+        depth.format, readOnlyAspects, 0u);
+    }
+  };
+
+  class DxvkRtInfoV17 {
+
+  public:
+
+    uint64_t m_packedData;
+
+    DxvkRtInfo convert() const {
+      // The packed format layout is unchanged, v18 only
+      // appended the view mask, which was implicit before.
+      DxvkRtInfo result(0, nullptr, VK_FORMAT_UNDEFINED, 0, 0u);
+      std::memcpy(&result, &m_packedData, sizeof(m_packedData));
+      return result;
     }
   };
 
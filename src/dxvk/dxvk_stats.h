@@ -20,6 +20,10 @@ namespace dxvk {
     PipeCountCompute,         ///< Number of compute pipelines
     PipeTasksDone,            ///< Boolean indicating compiler activity
     PipeTasksTotal,           ///< Boolean indicating compiler activity
+    PipeBatchTasksDone,       ///< Completed state cache replay tasks
+    PipeBatchTasksTotal,      ///< Queued state cache replay tasks
+    PipeInstanceLocks,        ///< Pipeline instance lookups that took the lock
+    PipeInstanceLockWaits,    ///< Pipeline instance lookups that waited for the lock
     QueueSubmitCount,         ///< Number of command buffer submissions
     QueuePresentCount,        ///< Number of present calls / frames
     GpuSyncCount,             ///< Number of GPU synchronizations
@@ -28,6 +32,11 @@ namespace dxvk {
     CsSyncCount,              ///< CS thread synchronizations
     CsSyncTicks,              ///< Time spent waiting on CS
     CsChunkCount,             ///< Submitted CS chunks
+    CsStallCount,             ///< Stalls on a full CS chunk queue
+    CsStallTicks,             ///< Time spent waiting for queue space
+    CsIdleTicks,              ///< Time the CS thread spent waiting for work
+    CsChunkUsedBytes,         ///< Command bytes in executed CS chunks
+    CsChunkTotalBytes,        ///< Capacity of executed CS chunks
     DescriptorPoolCount,      ///< Descriptor pool count
     DescriptorSetCount,       ///< Descriptor sets allocated
     NumCounters,              ///< Number of counters available
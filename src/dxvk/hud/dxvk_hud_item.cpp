@@ -644,9 +644,23 @@ namespace dxvk::hud {
       uint64_t diffCsChunks = (currCsChunks - m_prevCsChunks) / m_updateCount;
       m_prevCsChunks = currCsChunks;
 
+      uint64_t currCsIdleTicks  = counters.getCtr(DxvkStatCounter::CsIdleTicks);
+      uint64_t currCsUsedBytes  = counters.getCtr(DxvkStatCounter::CsChunkUsedBytes);
+      uint64_t currCsTotalBytes = counters.getCtr(DxvkStatCounter::CsChunkTotalBytes);
+
+      uint64_t diffCsIdleTicks  = currCsIdleTicks  - m_prevCsIdleTicks;
+      uint64_t diffCsUsedBytes  = currCsUsedBytes  - m_prevCsUsedBytes;
+      uint64_t diffCsTotalBytes = currCsTotalBytes - m_prevCsTotalBytes;
+
+      m_prevCsIdleTicks  = currCsIdleTicks;
+      m_prevCsUsedBytes  = currCsUsedBytes;
+      m_prevCsTotalBytes = currCsTotalBytes;
+
       uint64_t syncTicks = m_maxCsSyncTicks / 100;
 
       m_csChunkString = str::format(diffCsChunks);
+      m_csFillString = str::format(diffCsTotalBytes ? (100 * diffCsUsedBytes) / diffCsTotalBytes : 0, "%");
+      m_csIdleString = str::format(std::min<uint64_t>(100, (100 * diffCsIdleTicks) / ticks), "%");
       m_csSyncString = m_maxCsSyncCount
         ? str::format(m_maxCsSyncCount, " (", (syncTicks / 10), ".", (syncTicks % 10), " ms)")
         : str::format(m_maxCsSyncCount);
@@ -674,6 +688,28 @@ namespace dxvk::hud {
       { 1.0f, 1.0f, 1.0f, 1.0f },
       m_csChunkString);
 
+    position.y += 20.0f;
+    renderer.drawText(16.0f,
+      { position.x, position.y },
+      { 0.25f, 1.0f, 0.25f, 1.0f },
+      "CS fill:");
+
+    renderer.drawText(16.0f,
+      { position.x + 132.0f, position.y },
+      { 1.0f, 1.0f, 1.0f, 1.0f },
+      m_csFillString);
+
+    position.y += 20.0f;
+    renderer.drawText(16.0f,
+      { position.x, position.y },
+      { 0.25f, 1.0f, 0.25f, 1.0f },
+      "CS idle:");
+
+    renderer.drawText(16.0f,
+      { position.x + 132.0f, position.y },
+      { 1.0f, 1.0f, 1.0f, 1.0f },
+      m_csIdleString);
+
     position.y += 20.0f;
     renderer.drawText(16.0f,
       { position.x, position.y },
@@ -414,6 +414,9 @@ namespace dxvk::hud {
     uint64_t m_prevCsSyncCount  = 0;
     uint64_t m_prevCsSyncTicks  = 0;
     uint64_t m_prevCsChunks     = 0;
+    uint64_t m_prevCsIdleTicks  = 0;
+    uint64_t m_prevCsUsedBytes  = 0;
+    uint64_t m_prevCsTotalBytes = 0;
 
     uint64_t m_maxCsSyncCount   = 0;
     uint64_t m_maxCsSyncTicks   = 0;
@@ -422,6 +425,8 @@ namespace dxvk::hud {
 
     std::string m_csSyncString;
     std::string m_csChunkString;
+    std::string m_csFillString;
+    std::string m_csIdleString;
 
     dxvk::high_resolution_clock::time_point m_lastUpdate
       = dxvk::high_resolution_clock::now();
@@ -88,8 +88,12 @@ namespace dxvk {
 
   SpirvCodeBuffer SpirvCompressedBuffer::decompress() const {
     SpirvCodeBuffer code(m_size);
-    uint32_t* data = code.data();
+    decompressTo(code.data());
+    return code;
+  }
+
 
+  void SpirvCompressedBuffer::decompressTo(uint32_t* data) const {
     uint32_t srcOffset = 0;
     uint32_t dstOffset = 0;
 
@@ -116,8 +120,6 @@ namespace dxvk {
 
       srcOffset += 17;
     }
-
-    return code;
   }
 
 }
\ No newline at end of file
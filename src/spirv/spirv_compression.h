@@ -24,6 +24,20 @@ namespace dxvk {
     
     SpirvCodeBuffer decompress() const;
 
+    /**
+     * \brief Decompresses code into the given memory
+     * \param [out] dst At least \ref size dwords
+     */
+    void decompressTo(uint32_t* dst) const;
+
+    /**
+     * \brief Size of the decompressed code
+     * \returns Code size, in dwords
+     */
+    size_t size() const {
+      return m_size;
+    }
+
   private:
 
     size_t                m_size;
@@ -0,0 +1,186 @@
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "../dxvk/dxvk_state_cache.h"
+
+namespace dxvk {
+
+  /**
+   * \brief Per-shader usage counts
+   */
+  struct CacheToolShaderStats {
+    uint32_t pipelineCount = 0;
+    uint32_t entryCount    = 0;
+  };
+
+
+  /**
+   * \brief Command line options
+   */
+  struct CacheToolOptions {
+    std::vector<std::string> inputs;
+    std::string              output;
+    bool                     stats = false;
+  };
+
+
+  static void printUsage(const char* name) {
+    std::cerr << "Usage: " << name << " [-o output] [--stats] input..." << std::endl
+              << std::endl
+              << "Merges DXVK state cache files, drops invalid, duplicate and" << std::endl
+              << "unreachable entries and writes an indexed cache file." << std::endl
+              << std::endl
+              << "  -o, --output FILE   Write merged cache to FILE" << std::endl
+              << "  -s, --stats         Print pipeline counts per shader" << std::endl;
+  }
+
+
+  static bool parseOptions(int argc, char** argv, CacheToolOptions& options) {
+    for (int i = 1; i < argc; i++) {
+      if (!std::strcmp(argv[i], "-o") || !std::strcmp(argv[i], "--output")) {
+        if (++i == argc)
+          return false;
+
+        options.output = argv[i];
+      } else if (!std::strcmp(argv[i], "-s") || !std::strcmp(argv[i], "--stats")) {
+        options.stats = true;
+      } else if (argv[i][0] == '-') {
+        return false;
+      } else {
+        options.inputs.push_back(argv[i]);
+      }
+    }
+
+    return !options.inputs.empty();
+  }
+
+
+  /**
+   * \brief Checks whether an entry can ever be replayed
+   *
+   * The state cache only compiles pipelines with a vertex
+   * shader, and pipeline libraries only ever cover the
+   * pre-rasterization stages.
+   */
+  static bool isReachable(const DxvkStateCacheEntry& entry) {
+    DxvkShaderKey nullKey;
+
+    if (entry.shaders.vs.eq(nullKey))
+      return false;
+
+    if (entry.shaders.tcs.eq(nullKey) != entry.shaders.tes.eq(nullKey))
+      return false;
+
+    if (entry.type == DxvkStateCacheEntryType::PipelineLibrary
+     && !entry.shaders.fs.eq(nullKey))
+      return false;
+
+    return true;
+  }
+
+
+  static void printStats(const std::vector<DxvkStateCacheEntry>& entries) {
+    std::unordered_map<DxvkShaderKey, CacheToolShaderStats, DxvkHash, DxvkEq> shaders;
+    std::unordered_set<DxvkStateCacheKey, DxvkHash, DxvkEq> pipelines;
+
+    DxvkShaderKey nullKey;
+
+    for (const auto& e : entries) {
+      bool newPipeline = pipelines.insert(e.shaders).second;
+
+      for (const auto* key : { &e.shaders.vs, &e.shaders.tcs, &e.shaders.tes, &e.shaders.gs, &e.shaders.fs }) {
+        if (key->eq(nullKey))
+          continue;
+
+        auto& stats = shaders[*key];
+        stats.pipelineCount += newPipeline ? 1 : 0;
+        stats.entryCount += 1;
+      }
+    }
+
+    std::vector<std::pair<DxvkShaderKey, CacheToolShaderStats>> sorted(shaders.begin(), shaders.end());
+
+    std::sort(sorted.begin(), sorted.end(), [] (
+      const std::pair<DxvkShaderKey, CacheToolShaderStats>& a,
+      const std::pair<DxvkShaderKey, CacheToolShaderStats>& b) {
+      return a.second.pipelineCount > b.second.pipelineCount;
+    });
+
+    std::cout << pipelines.size() << " pipelines, " << sorted.size() << " shaders" << std::endl;
+
+    for (const auto& s : sorted) {
+      std::cout << s.first.toString() << ": "
+                << s.second.pipelineCount << " pipelines, "
+                << s.second.entryCount << " entries" << std::endl;
+    }
+  }
+
+
+  static int run(int argc, char** argv) {
+    CacheToolOptions options;
+
+    if (!parseOptions(argc, argv, options)) {
+      printUsage(argv[0]);
+      return 1;
+    }
+
+    std::vector<DxvkStateCacheEntry> entries;
+
+    for (const auto& input : options.inputs) {
+      std::vector<DxvkStateCacheEntry> fileEntries;
+      uint32_t version = 0;
+
+      int32_t numInvalid = DxvkStateCache::importCacheFile(
+        str::topath(input.c_str()), fileEntries, version);
+
+      if (numInvalid < 0) {
+        std::cerr << input << ": Failed to read state cache file" << std::endl;
+        return 1;
+      }
+
+      std::cout << input << ": v" << version << ", "
+                << fileEntries.size() << " valid entries, "
+                << numInvalid << " invalid entries" << std::endl;
+
+      entries.insert(entries.end(), fileEntries.begin(), fileEntries.end());
+    }
+
+    size_t entryCount = entries.size();
+
+    entries.erase(std::remove_if(entries.begin(), entries.end(),
+      [] (const DxvkStateCacheEntry& e) { return !isReachable(e); }),
+      entries.end());
+
+    std::cout << "Dropped " << (entryCount - entries.size()) << " unreachable entries" << std::endl;
+
+    if (options.stats)
+      printStats(entries);
+
+    if (options.output.empty())
+      return 0;
+
+    if (!DxvkStateCache::exportCacheFile(str::topath(options.output.c_str()), entries)) {
+      std::cerr << options.output << ": Failed to write state cache file" << std::endl;
+      return 1;
+    }
+
+    // Re-read the file to report the effect of deduplication
+    std::vector<DxvkStateCacheEntry> written;
+    uint32_t version = 0;
+
+    DxvkStateCache::importCacheFile(str::topath(options.output.c_str()), written, version);
+
+    std::cout << options.output << ": Wrote " << written.size() << " entries, dropped "
+              << (entries.size() - written.size()) << " duplicates" << std::endl;
+    return 0;
+  }
+
+}
+
+
+int main(int argc, char** argv) {
+  return dxvk::run(argc, argv);
+}
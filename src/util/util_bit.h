@@ -222,6 +222,47 @@ namespace dxvk::bit {
     #endif
   }
 
+  /**
+   * \brief Compares two dword arrays element by element
+   *
+   * \param [in] a First array
+   * \param [in] b Second array
+   * \param [in] count Number of dwords to compare, at most 32
+   * \returns Bit mask of the dwords that differ
+   */
+  inline uint32_t dcmpne(const uint32_t* a, const uint32_t* b, uint32_t count) {
+    uint32_t result = 0;
+    uint32_t i = 0;
+
+    #if defined(DXVK_ARCH_X86) && (defined(__GNUC__) || defined(__clang__) || defined(_MSC_VER))
+    for ( ; i + 4 <= count; i += 4) {
+      __m128i eq = _mm_cmpeq_epi32(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i)),
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i)));
+
+      uint32_t mask = uint32_t(_mm_movemask_ps(_mm_castsi128_ps(eq)));
+      result |= (~mask & 0xfu) << i;
+    }
+    #endif
+
+    for ( ; i < count; i++)
+      result |= uint32_t(a[i] != b[i]) << i;
+
+    return result;
+  }
+
+  /**
+   * \brief Checks an array of dwords for non-zero values
+   *
+   * \param [in] a The array
+   * \param [in] count Number of dwords to check, at most 32
+   * \returns Bit mask of the dwords that are not zero
+   */
+  inline uint32_t dnez(const uint32_t* a, uint32_t count) {
+    static const uint32_t zero[32] = { };
+    return dcmpne(a, zero, count);
+  }
+
   template <size_t Bits>
   class bitset {
     static constexpr size_t Dwords = align(Bits, 32) / 32;
@@ -1,4 +1,5 @@
 #include <array>
+#include <cstdio>
 #include <cstdlib>
 #include <filesystem>
 #include <numeric>
@@ -146,5 +147,23 @@ namespace dxvk::env {
     return std::filesystem::create_directories(path);
 #endif
   }
+
+
+  bool replaceFile(const str::path_string& src, const str::path_string& dst) {
+#ifdef _WIN32
+    return !!MoveFileExW(src.c_str(), dst.c_str(), MOVEFILE_REPLACE_EXISTING);
+#else
+    return !std::rename(src.c_str(), dst.c_str());
+#endif
+  }
+
+
+  bool removeFile(const str::path_string& path) {
+#ifdef _WIN32
+    return !!DeleteFileW(path.c_str());
+#else
+    return !std::remove(path.c_str());
+#endif
+  }
   
 }
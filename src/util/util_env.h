@@ -75,5 +75,24 @@ namespace dxvk::env {
    * \returns \c true on success
    */
   bool createDirectory(const std::string& path);
+
+  /**
+   * \brief Moves a file over another one
+   *
+   * Replaces the destination file if it exists.
+   * On POSIX systems, this is done atomically.
+   * \param [in] src Path to the new file
+   * \param [in] dst Path to the file to replace
+   * \returns \c true on success
+   */
+  bool replaceFile(const str::path_string& src, const str::path_string& dst);
+
+  /**
+   * \brief Deletes a file
+   *
+   * \param [in] path Path to the file
+   * \returns \c true on success
+   */
+  bool removeFile(const str::path_string& path);
   
 }
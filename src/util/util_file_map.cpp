@@ -0,0 +1,105 @@
+#include <cstdint>
+#include <utility>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "util_file_map.h"
+
+#include "./com/com_include.h"
+
+namespace dxvk {
+
+  FileMapping::FileMapping(const str::path_string& path) {
+#ifdef _WIN32
+    HANDLE file = ::CreateFileW(path.c_str(), GENERIC_READ,
+      FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+      nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+
+    if (file == INVALID_HANDLE_VALUE)
+      return;
+
+    LARGE_INTEGER size = { };
+
+    if (::GetFileSizeEx(file, &size) && size.QuadPart > 0
+     && uint64_t(size.QuadPart) <= uint64_t(SIZE_MAX)) {
+      HANDLE mapping = ::CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+      if (mapping) {
+        // The view keeps the mapping object alive
+        m_data = reinterpret_cast<const char*>(::MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+        ::CloseHandle(mapping);
+      }
+
+      if (m_data)
+        m_size = size_t(size.QuadPart);
+    }
+
+    m_open = m_data || !size.QuadPart;
+    ::CloseHandle(file);
+#else
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+
+    if (fd < 0)
+      return;
+
+    struct stat st = { };
+
+    if (!::fstat(fd, &st) && st.st_size > 0) {
+      void* data = ::mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+
+      if (data != MAP_FAILED) {
+        m_data = reinterpret_cast<const char*>(data);
+        m_size = size_t(st.st_size);
+      }
+    }
+
+    m_open = m_data || !st.st_size;
+    ::close(fd);
+#endif
+  }
+
+
+  FileMapping::FileMapping(FileMapping&& other)
+  : m_data(std::exchange(other.m_data, nullptr)),
+    m_size(std::exchange(other.m_size, 0)),
+    m_open(std::exchange(other.m_open, false)) { }
+
+
+  FileMapping& FileMapping::operator = (FileMapping&& other) {
+    if (this != &other) {
+      reset();
+
+      m_data = std::exchange(other.m_data, nullptr);
+      m_size = std::exchange(other.m_size, 0);
+      m_open = std::exchange(other.m_open, false);
+    }
+
+    return *this;
+  }
+
+
+  FileMapping::~FileMapping() {
+    reset();
+  }
+
+
+  void FileMapping::reset() {
+    if (m_data) {
+#ifdef _WIN32
+      ::UnmapViewOfFile(m_data);
+#else
+      ::munmap(const_cast<char*>(m_data), m_size);
+#endif
+    }
+
+    m_data = nullptr;
+    m_size = 0;
+    m_open = false;
+  }
+
+}
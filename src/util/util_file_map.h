@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstddef>
+
+#include "util_string.h"
+
+namespace dxvk {
+
+  /**
+   * \brief Read-only file mapping
+   *
+   * Maps the entire contents of a file into the address space
+   * of the process. The file stays open for writing by others,
+   * but data appended after the mapping was created is not
+   * visible through it.
+   */
+  class FileMapping {
+
+  public:
+
+    FileMapping() { }
+
+    /**
+     * \brief Maps a file
+     *
+     * Check \ref isOpen to see whether the file exists.
+     * \param [in] path File path
+     */
+    explicit FileMapping(const str::path_string& path);
+
+    FileMapping(FileMapping&& other);
+
+    FileMapping& operator = (FileMapping&& other);
+
+    ~FileMapping();
+
+    /**
+     * \brief Checks whether the file could be opened
+     * \returns \c true if the file exists and could be mapped
+     */
+    bool isOpen() const {
+      return m_open;
+    }
+
+    /**
+     * \brief Mapped file data
+     * \returns Pointer to file data, or \c nullptr if empty
+     */
+    const char* data() const {
+      return m_data;
+    }
+
+    /**
+     * \brief Size of the mapping
+     * \returns File size at the time it was mapped
+     */
+    size_t size() const {
+      return m_size;
+    }
+
+    /**
+     * \brief Unmaps the file
+     *
+     * Required before the file can be truncated
+     * or replaced on some platforms.
+     */
+    void reset();
+
+  private:
+
+    const char* m_data = nullptr;
+    size_t      m_size = 0;
+    bool        m_open = false;
+
+  };
+
+}
@@ -165,4 +165,24 @@ namespace dxvk {
     #endif
   }
 
+  /**
+   * \brief Replaces NaN with zero in an array of vectors
+   *
+   * \param [out] dst Destination vectors
+   * \param [in] src Source data, \c count * 4 floats
+   * \param [in] count Number of vectors
+   */
+  inline void replaceNaN(Vector4* dst, const float* src, uint32_t count) {
+    #ifdef DXVK_ARCH_X86
+    for (uint32_t i = 0; i < count; i++) {
+      __m128 value = _mm_loadu_ps(src + 4 * i);
+      __m128 mask  = _mm_cmpeq_ps(value, value);
+      _mm_storeu_ps(dst[i].data, _mm_and_ps(value, mask));
+    }
+    #else
+    for (uint32_t i = 0; i < count; i++)
+      dst[i] = replaceNaN(Vector4(src + 4 * i));
+    #endif
+  }
+
 }